@@ -159,11 +159,17 @@ bool Adc::stop()
 // TODO only ADC0_0 to ADC0_7 handled at the moment
 // figure out channel from name (ADC0_1, ADC0_4, ...)
 // or Pin P4_3
-Adc* Adc::from_string(const char *name)
+Adc* Adc::from_string(const char *name, uint8_t samples, uint8_t oversample)
 {
     if(enabled) return nullptr; // aready setup
     if(instance_idx < 0) return nullptr; // too many instances
 
+    // the middle half must be enough readings for the oversampling
+    if(samples < 4 || oversample > 4 || (samples / 2) < (1 << (2 * oversample))) {
+        printf("ERROR: Adc: %d samples is not enough to oversample by %d bits\n", samples, oversample);
+        return nullptr;
+    }
+
     const char *p = strcasestr(name, "adc");
     if (p != nullptr) {
         // ADC specific pin
@@ -222,9 +228,17 @@ Adc* Adc::from_string(const char *name)
         return nullptr;
     }
 
+    if(!filter.init(samples, samples / 4)) {
+        printf("ERROR: Adc: not enough memory for the sample filter\n");
+        channel = -1;
+        return nullptr;
+    }
+    this->oversample = oversample;
+
     allocated_channels.insert(channel);
 
-    memset(sample_buffer, 0, sizeof(sample_buffer));
+    fifo_head = fifo_tail = 0;
+    stale = true;
     memset(ave_buf, 0, sizeof(ave_buf));
     Chip_ADC_EnableChannel(_LPC_ADC_ID, CHANNEL_LUT[channel], ENABLE);
 #ifndef NO_ADC_INTERRUPTS
@@ -267,42 +281,59 @@ void Adc::sample_isr()
     }
 }
 
-// Keeps the last 32 values for each channel
-// This is called in an ISR, so sample_buffer needs to be accessed atomically
+// Queues the reading for the next read()
+// This is called in an ISR, it only writes the fifo, the reader filters the readings
 //_ramfunc_
 void Adc::new_sample(uint32_t value)
 {
-    // Shuffle down and add new value to the end
-    // FIXME memmove appears to not be inline, so in an interrupt in SPIFI it is too slow
-    // memmove(&sample_buffer[0], &sample_buffer[1], sizeof(sample_buffer) - sizeof(sample_buffer[0]));
-    for (int i = 1; i < num_samples; ++i) {
-        sample_buffer[i - 1] = sample_buffer[i];
+    fifo[fifo_head & (fifo_size - 1)] = value; // the 10 bit ADC reading
+    fifo_head = fifo_head + 1;
+}
+
+// add the readings queued by the ISR to the filter
+void Adc::update()
+{
+    uint16_t buf[fifo_size];
+    uint32_t head, n;
+
+    // copy without stopping the ISR, and try again if it wrapped around onto the readings being copied
+    do {
+        head = fifo_head;
+        n = head - fifo_tail;
+        if(n > fifo_size - 1) {
+            // missed some so just take the latest, the rest of the window is too old to use
+            n = fifo_size - 1;
+            stale = true;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            buf[i] = fifo[(head - n + i) & (fifo_size - 1)];
+        }
+    } while(fifo_head - (head - n) >= fifo_size);
+
+    fifo_tail = head;
+    if(n == 0) return;
+
+    if(stale) {
+        // start the window again from just the readings we have, rather than old readings or copies of one of them
+        filter.clear();
+        stale = false;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        filter.add(buf[i]);
     }
-    sample_buffer[num_samples - 1] = value; // the 10 bit ADC reading
 }
 
-//#define USE_MEDIAN_FILTER
 // gets called 20 times a second from a timer
 uint32_t Adc::read()
 {
-    uint16_t median_buffer[num_samples];
-
-    // needs atomic access TODO maybe be able to use std::atomic here or some lockless mutex
-    taskENTER_CRITICAL();
-    memcpy(median_buffer, sample_buffer, sizeof(median_buffer));
-    taskEXIT_CRITICAL();
+    update();
 
-#ifdef USE_MEDIAN_FILTER
-    // returns the median value of the last 8 samples
-    return median_buffer[quick_median(median_buffer, num_samples)];
-
-#elif defined(OVERSAMPLE)
-    // Oversample to get 2 extra bits of resolution
     // weed out top and bottom worst values then oversample the rest
-    std::sort(median_buffer, median_buffer + num_samples);
-    uint32_t sum = 0;
-    for (int i = num_samples / 4; i < (num_samples - (num_samples / 4)); ++i) {
-        sum += median_buffer[i];
+    // to get oversample extra bits of resolution
+    uint32_t sum = filter.get_sum();
+    if(oversample == 0) {
+        // the average of the middle half
+        return sum / filter.get_count();
     }
 
     // put into a 4 element moving average and return the average of the last 4 oversampled readings
@@ -310,63 +341,17 @@ uint32_t Adc::read()
     ave_buf[3] = ave_buf[2];
     ave_buf[2] = ave_buf[1];
     ave_buf[1] = ave_buf[0];
-    ave_buf[0] = sum >> OVERSAMPLE;
+    ave_buf[0] = (sum << oversample) / filter.get_count();
     return roundf((ave_buf[0] + ave_buf[1] + ave_buf[2] + ave_buf[3]) / 4.0F);
-
-#else
-    // sort the 8 readings and return the average of the middle 4
-    std::sort(median_buffer, median_buffer + num_samples);
-    int sum = 0;
-    for (int i = num_samples / 4; i < (num_samples - (num_samples / 4)); ++i) {
-        sum += median_buffer[i];
-    }
-    return sum / (num_samples / 2);
-
-#endif
-}
-
-static void split(uint16_t data[], unsigned int n, uint16_t x, unsigned int& i, unsigned int& j)
-{
-    do {
-        while (data[i] < x) i++;
-        while (x < data[j]) j--;
-
-        if (i <= j) {
-            uint16_t ii = data[i];
-            data[i] = data[j];
-            data[j] = ii;
-            i++; j--;
-        }
-    } while (i <= j);
-}
-
-// C.A.R. Hoare's Quick Median
-static unsigned int quick_median(uint16_t data[], unsigned int n)
-{
-    unsigned int l = 0, r = n - 1, k = n / 2;
-    while (l < r) {
-        uint16_t x = data[k];
-        unsigned int i = l, j = r;
-        split(data, n, x, i, j);
-        if (j < k) l = i;
-        if (k < i) r = j;
-    }
-    return k;
 }
 
 float Adc::read_voltage()
 {
     // just return the voltage on the pin
-    uint16_t median_buffer[num_samples];
-
-    // needs atomic access TODO maybe be able to use std::atomic here or some lockless mutex
-    taskENTER_CRITICAL();
-    memcpy(median_buffer, sample_buffer, sizeof(median_buffer));
-    taskEXIT_CRITICAL();
+    update();
 
     // take the median value
-    unsigned int i= quick_median(median_buffer, num_samples);
-    uint16_t adc= median_buffer[i];
+    uint16_t adc= filter.get_median();
 
     float v= 3.3F * (adc / 1024.0F); // 10 bit adc values
     return v;
@@ -4,6 +4,8 @@
 #include <cmath>
 #include <set>
 
+#include "TrimmedMeanFilter.h"
+
 class Pin;
 
 // define how many bits of extra resolution required
@@ -23,7 +25,9 @@ public:
     static void on_tick(void);
 
     // specific to each instance
-    Adc* from_string(const char *name);
+    // samples is how many readings are filtered, the highest and lowest quarter are dropped and the rest averaged
+    // to give oversample extra bits of resolution, which needs 4^oversample readings left after the trim
+    Adc* from_string(const char *name, uint8_t samples= default_samples, uint8_t oversample= default_oversample);
     uint32_t read();
     float read_voltage();
     int get_channel() const { return channel; }
@@ -32,11 +36,7 @@ public:
     bool is_created() const { return instance_idx >= 0; }
 
     // return the maximum ADC value, base is 10bits 1024.
-#ifdef OVERSAMPLE
-    static int get_max_value() { return 1024 << OVERSAMPLE;}
-#else
-    static int get_max_value() { return 1024;}
-#endif
+    int get_max_value() const { return 1024 << oversample; }
 
     static void sample_isr();
 
@@ -48,13 +48,18 @@ private:
 
 #ifdef OVERSAMPLE
     // we need 4^n sample to oversample and we get double that to filter out spikes
-    static const int num_samples= 32; // powf(4, OVERSAMPLE)*2; // TODO FIXME
+    static const int default_samples= 32; // powf(4, OVERSAMPLE)*2;
+    static const int default_oversample= OVERSAMPLE;
 #else
-    static const int num_samples= 8;
+    static const int default_samples= 8;
+    static const int default_oversample= 0;
 #endif
+    // readings taken by the ISR that have not been filtered yet, must be a power of 2
+    static const int fifo_size= 16;
 
     // instance specific fields
     void new_sample(uint32_t value);
+    void update();
 
     bool enabled{false};
     static bool running;
@@ -62,8 +67,15 @@ private:
     int instance_idx{-1};
     uint32_t not_ready_error{0};
     static int slowticker_n;
-    // buffer storing the last num_samples readings for each channel instance
-    uint16_t sample_buffer[num_samples];
+    uint8_t oversample{0};
+    // the last readings for each channel instance, sorted as they are added
+    TrimmedMeanFilter filter;
+    // written by the ISR, read and filtered when the value is read. volatile so the copy in update()
+    // stays between the two reads of fifo_head that check the ISR did not overwrite it
+    volatile uint16_t fifo[fifo_size];
+    volatile uint32_t fifo_head{0};
+    uint32_t fifo_tail{0};
+    bool stale{true}; // the filter window has no recent readings in it
     uint16_t ave_buf[4]{0};
 };
 
@@ -54,6 +54,7 @@ public:
 
     bool is_inverting() const { return inverting; }
     void set_inverting(bool f) { inverting = f; }
+    bool is_open_drain() const { return open_drain; }
 
     // mbed::InterruptIn *interrupt_pin();
 
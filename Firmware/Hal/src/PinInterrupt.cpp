@@ -0,0 +1,66 @@
+#include "PinInterrupt.h"
+#include "Pin.h"
+
+#include "board.h"
+
+PinInterrupt *PinInterrupt::channels[num_channels];
+
+bool PinInterrupt::attach(const Pin& pin, std::function<void(bool)> fnc)
+{
+    if(!pin.connected() || channel >= 0) return false;
+
+    for (int ch = 0; ch < num_channels; ++ch) {
+        if(channels[ch] == nullptr) {
+            channels[ch] = this;
+            channel = ch;
+            break;
+        }
+    }
+    if(channel < 0) return false;
+
+    this->pin = &pin;
+    this->fnc = fnc;
+
+    // interrupt on both edges of the pin
+    Chip_SCU_GPIOIntPinSel(channel, pin.get_gpioport(), pin.get_gpiopin());
+    Chip_PININT_SetPinModeEdge(LPC_GPIO_PIN_INT, PININTCH(channel));
+    Chip_PININT_EnableIntHigh(LPC_GPIO_PIN_INT, PININTCH(channel));
+    Chip_PININT_EnableIntLow(LPC_GPIO_PIN_INT, PININTCH(channel));
+    Chip_PININT_ClearIntStatus(LPC_GPIO_PIN_INT, PININTCH(channel));
+
+    IRQn_Type irq = (IRQn_Type)(PIN_INT0_IRQn + channel);
+    NVIC_SetPriority(irq, 0); // same as the step ticker, cannot call any RTOS stuff from this IRQ
+    NVIC_ClearPendingIRQ(irq);
+    NVIC_EnableIRQ(irq);
+    return true;
+}
+
+void PinInterrupt::detach()
+{
+    if(channel < 0) return;
+
+    IRQn_Type irq = (IRQn_Type)(PIN_INT0_IRQn + channel);
+    NVIC_DisableIRQ(irq);
+    Chip_PININT_DisableIntHigh(LPC_GPIO_PIN_INT, PININTCH(channel));
+    Chip_PININT_DisableIntLow(LPC_GPIO_PIN_INT, PININTCH(channel));
+    channels[channel] = nullptr;
+    channel = -1;
+}
+
+void PinInterrupt::handle_irq(int ch)
+{
+    Chip_PININT_ClearIntStatus(LPC_GPIO_PIN_INT, PININTCH(ch));
+    PinInterrupt *p = channels[ch];
+    if(p != nullptr && p->fnc) p->fnc(p->pin->get());
+}
+
+extern "C" {
+    void GPIO0_IRQHandler(void) { PinInterrupt::handle_irq(0); }
+    void GPIO1_IRQHandler(void) { PinInterrupt::handle_irq(1); }
+    void GPIO2_IRQHandler(void) { PinInterrupt::handle_irq(2); }
+    void GPIO3_IRQHandler(void) { PinInterrupt::handle_irq(3); }
+    void GPIO4_IRQHandler(void) { PinInterrupt::handle_irq(4); }
+    void GPIO5_IRQHandler(void) { PinInterrupt::handle_irq(5); }
+    void GPIO6_IRQHandler(void) { PinInterrupt::handle_irq(6); }
+    void GPIO7_IRQHandler(void) { PinInterrupt::handle_irq(7); }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+
+class Pin;
+
+// Calls a function from an interrupt on every edge of a pin, using one of the eight GPIO pin interrupts.
+// The interrupt has the same priority as the step ticker, so the function can read the positions of
+// the motors and stop them without a step being issued while it does.
+class PinInterrupt
+{
+public:
+    PinInterrupt() {}
+    ~PinInterrupt() { detach(); }
+
+    // fnc is called with the state of the pin (after any inversion) on each edge,
+    // returns false if the pin is not connected or all the pin interrupts are in use
+    bool attach(const Pin& pin, std::function<void(bool)> fnc);
+    void detach();
+    bool is_attached() const { return channel >= 0; }
+
+    // called from the GPIOn IRQ handlers
+    static void handle_irq(int ch);
+
+private:
+    static const int num_channels = 8;
+    static PinInterrupt *channels[num_channels];
+
+    const Pin *pin{nullptr};
+    std::function<void(bool)> fnc;
+    int8_t channel{-1};
+};
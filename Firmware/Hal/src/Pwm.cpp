@@ -8,6 +8,9 @@
 
 #include "board.h"
 
+// TODO move ramfunc define to a utils.h
+#define _ramfunc_ __attribute__ ((section(".ramfunctions"),long_call,noinline))
+
 uint32_t Pwm::frequency= 0;
 
 /* 43xx Pinmap for PWM to CTOUT and function
@@ -164,8 +167,21 @@ void Pwm::set(float v)
 	if(v < 0) v= 0;
 	else if(v > 1) v= 1;
 
-	uint32_t ticks= floorf(Chip_SCTPWM_GetTicksPerCycle(LPC_SCT) * v);
+	ticks= floorf(Chip_SCTPWM_GetTicksPerCycle(LPC_SCT) * v);
 	Chip_SCTPWM_SetDutyCycle(LPC_SCT, index, ticks);
+}
+
+_ramfunc_ void Pwm::set_duty(uint16_t duty)
+{
+	if(!valid) return;
 
-	value= v;
+	if(duty > 0x8000) duty= 0x8000;
+	ticks= ((uint64_t)Chip_SCTPWM_GetTicksPerCycle(LPC_SCT) * duty) >> 15;
+	Chip_SCTPWM_SetDutyCycle(LPC_SCT, index, ticks);
+}
+
+float Pwm::get() const
+{
+	uint32_t cycle= Chip_SCTPWM_GetTicksPerCycle(LPC_SCT);
+	return cycle == 0 ? 0 : (float)ticks / cycle;
 }
@@ -14,7 +14,9 @@ public:
 	bool is_valid() const { return valid; }
 	// set duty cycle 0-1
 	void set(float v);
-	float get() const { return value; }
+	// set duty cycle in 1.15 fixed point (0x8000 is 1), only uses integer math so it can be called from an ISR
+	void set_duty(uint16_t duty);
+	float get() const;
 	static uint32_t get_frequency() { return frequency; }
 	static bool setup(uint32_t freq);
 
@@ -25,7 +27,7 @@ private:
 	static int pwm_index;
 	static uint32_t frequency;
 	std::string pin_name;
-	float value;
+	volatile uint32_t ticks{0}; // the on time of each cycle in SCT ticks
 	bool valid{false};
 	uint8_t index;
 
@@ -0,0 +1,35 @@
+#include "StepPins.h"
+#include "Pin.h"
+
+bool StepPins::add(uint8_t n, const Pin& pin)
+{
+    if(n >= max_pins || !pin.connected() || pin.is_open_drain()) return false;
+
+    uint8_t p= pin.get_gpioport();
+    uint32_t bit= 1UL << pin.get_gpiopin();
+
+    // find the slot for the port or allocate a new one
+    uint8_t s= 0;
+    while(s < num_ports && port[s] != p) ++s;
+    if(s == num_ports) {
+        if(num_ports >= max_ports) return false;
+        port[s]= p;
+        inverted[s]= 0;
+        ++num_ports;
+    }
+
+    slot[n]= s;
+    mask[n]= bit;
+    if(pin.is_inverting()) {
+        inverted[s] |= bit;
+    } else {
+        inverted[s] &= ~bit;
+    }
+
+    return true;
+}
+
+void StepPins::clear()
+{
+    num_ports= 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "board.h"
+
+class Pin;
+
+// Sets and clears the step pins of a group of motors with one masked SET and one CLR write per
+// GPIO port, rather than a byte write per pin.
+// The port, bit and polarity of each pin are worked out when it is added, so the ISR only has to
+// OR the bits of the motors that stepped together.
+// The GPIO block is passed in so a test can use a plain LPC_GPIO_T in memory instead of the real one.
+class StepPins
+{
+public:
+    StepPins(LPC_GPIO_T *gpio= LPC_GPIO_PORT) : gpio(gpio) {}
+
+    // adds the step pin of motor n, returns false if the pin can not be batched
+    // (not connected or open drain), in which case it has to be set by the motor itself
+    bool add(uint8_t n, const Pin& pin);
+    void clear();
+
+    // raise the step pins of the motors with a bit set in motors
+    inline void step(uint32_t motors) { write(motors, true); }
+
+    // lower the step pins of the motors with a bit set in motors
+    inline void unstep(uint32_t motors) { write(motors, false); }
+
+    uint8_t get_num_ports() const { return num_ports; }
+
+private:
+    static const int max_pins= 32; // one per bit of the motor mask
+    static const int max_ports= 8;
+
+    inline void write(uint32_t motors, bool on)
+    {
+        uint32_t bits[max_ports];
+        for (int i = 0; i < num_ports; ++i) bits[i]= 0;
+
+        while(motors != 0) {
+            int n= __builtin_ctz(motors);
+            motors &= motors - 1;
+            bits[slot[n]] |= mask[n];
+        }
+
+        for (int i = 0; i < num_ports; ++i) {
+            if(bits[i] == 0) continue;
+            // an inverted pin is cleared to step and set to unstep
+            uint32_t hi= on ? (bits[i] & ~inverted[i]) : (bits[i] & inverted[i]);
+            uint32_t lo= bits[i] ^ hi;
+            if(hi != 0) gpio->SET[port[i]]= hi;
+            if(lo != 0) gpio->CLR[port[i]]= lo;
+        }
+    }
+
+    LPC_GPIO_T *gpio;
+
+    // per pin
+    uint32_t mask[max_pins];     // bit of the pin in its port
+    uint8_t slot[max_pins];      // index into the per port arrays below
+
+    // per port used
+    uint8_t port[max_ports];     // GPIO port number
+    uint32_t inverted[max_ports]; // bits of the pins on the port that are active low
+    uint8_t num_ports{0};
+};
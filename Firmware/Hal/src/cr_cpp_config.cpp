@@ -1,7 +1,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-void *operator new(size_t size)
+__attribute__ ((weak)) void *operator new(size_t size)
 {
     return malloc(size);
 }
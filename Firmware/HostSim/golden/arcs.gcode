@@ -0,0 +1,9 @@
+; full circle and a couple of short segments
+G21
+G90
+G0 X10 Y0
+G2 X10 Y0 I-10 J0 F2400
+G1 X10.5 Y0.2
+G1 X11 Y0.1
+G1 X11.5 Y0.4
+G3 X0 Y0 I-5.75 J-0.2 F1200
@@ -0,0 +1,497 @@
+; dense short segments, a straight line and a circle, planned with the long look-ahead
+G21
+G90
+G1 X0 Y0 F12000
+G1 X0.25
+G1 X0.50
+G1 X0.75
+G1 X1.00
+G1 X1.25
+G1 X1.50
+G1 X1.75
+G1 X2.00
+G1 X2.25
+G1 X2.50
+G1 X2.75
+G1 X3.00
+G1 X3.25
+G1 X3.50
+G1 X3.75
+G1 X4.00
+G1 X4.25
+G1 X4.50
+G1 X4.75
+G1 X5.00
+G1 X5.25
+G1 X5.50
+G1 X5.75
+G1 X6.00
+G1 X6.25
+G1 X6.50
+G1 X6.75
+G1 X7.00
+G1 X7.25
+G1 X7.50
+G1 X7.75
+G1 X8.00
+G1 X8.25
+G1 X8.50
+G1 X8.75
+G1 X9.00
+G1 X9.25
+G1 X9.50
+G1 X9.75
+G1 X10.00
+G1 X10.25
+G1 X10.50
+G1 X10.75
+G1 X11.00
+G1 X11.25
+G1 X11.50
+G1 X11.75
+G1 X12.00
+G1 X12.25
+G1 X12.50
+G1 X12.75
+G1 X13.00
+G1 X13.25
+G1 X13.50
+G1 X13.75
+G1 X14.00
+G1 X14.25
+G1 X14.50
+G1 X14.75
+G1 X15.00
+G1 X15.25
+G1 X15.50
+G1 X15.75
+G1 X16.00
+G1 X16.25
+G1 X16.50
+G1 X16.75
+G1 X17.00
+G1 X17.25
+G1 X17.50
+G1 X17.75
+G1 X18.00
+G1 X18.25
+G1 X18.50
+G1 X18.75
+G1 X19.00
+G1 X19.25
+G1 X19.50
+G1 X19.75
+G1 X20.00
+G1 X20.25
+G1 X20.50
+G1 X20.75
+G1 X21.00
+G1 X21.25
+G1 X21.50
+G1 X21.75
+G1 X22.00
+G1 X22.25
+G1 X22.50
+G1 X22.75
+G1 X23.00
+G1 X23.25
+G1 X23.50
+G1 X23.75
+G1 X24.00
+G1 X24.25
+G1 X24.50
+G1 X24.75
+G1 X25.00
+G1 X25.25
+G1 X25.50
+G1 X25.75
+G1 X26.00
+G1 X26.25
+G1 X26.50
+G1 X26.75
+G1 X27.00
+G1 X27.25
+G1 X27.50
+G1 X27.75
+G1 X28.00
+G1 X28.25
+G1 X28.50
+G1 X28.75
+G1 X29.00
+G1 X29.25
+G1 X29.50
+G1 X29.75
+G1 X30.00
+G1 X30.25
+G1 X30.50
+G1 X30.75
+G1 X31.00
+G1 X31.25
+G1 X31.50
+G1 X31.75
+G1 X32.00
+G1 X32.25
+G1 X32.50
+G1 X32.75
+G1 X33.00
+G1 X33.25
+G1 X33.50
+G1 X33.75
+G1 X34.00
+G1 X34.25
+G1 X34.50
+G1 X34.75
+G1 X35.00
+G1 X35.25
+G1 X35.50
+G1 X35.75
+G1 X36.00
+G1 X36.25
+G1 X36.50
+G1 X36.75
+G1 X37.00
+G1 X37.25
+G1 X37.50
+G1 X37.75
+G1 X38.00
+G1 X38.25
+G1 X38.50
+G1 X38.75
+G1 X39.00
+G1 X39.25
+G1 X39.50
+G1 X39.75
+G1 X40.00
+G1 X40.25
+G1 X40.50
+G1 X40.75
+G1 X41.00
+G1 X41.25
+G1 X41.50
+G1 X41.75
+G1 X42.00
+G1 X42.25
+G1 X42.50
+G1 X42.75
+G1 X43.00
+G1 X43.25
+G1 X43.50
+G1 X43.75
+G1 X44.00
+G1 X44.25
+G1 X44.50
+G1 X44.75
+G1 X45.00
+G1 X45.25
+G1 X45.50
+G1 X45.75
+G1 X46.00
+G1 X46.25
+G1 X46.50
+G1 X46.75
+G1 X47.00
+G1 X47.25
+G1 X47.50
+G1 X47.75
+G1 X48.00
+G1 X48.25
+G1 X48.50
+G1 X48.75
+G1 X49.00
+G1 X49.25
+G1 X49.50
+G1 X49.75
+G1 X50.00
+G1 X50.25
+G1 X50.50
+G1 X50.75
+G1 X51.00
+G1 X51.25
+G1 X51.50
+G1 X51.75
+G1 X52.00
+G1 X52.25
+G1 X52.50
+G1 X52.75
+G1 X53.00
+G1 X53.25
+G1 X53.50
+G1 X53.75
+G1 X54.00
+G1 X54.25
+G1 X54.50
+G1 X54.75
+G1 X55.00
+G1 X55.25
+G1 X55.50
+G1 X55.75
+G1 X56.00
+G1 X56.25
+G1 X56.50
+G1 X56.75
+G1 X57.00
+G1 X57.25
+G1 X57.50
+G1 X57.75
+G1 X58.00
+G1 X58.25
+G1 X58.50
+G1 X58.75
+G1 X59.00
+G1 X59.25
+G1 X59.50
+G1 X59.75
+G1 X60.00
+G1 X60.499 Y0.006
+G1 X60.997 Y0.025
+G1 X61.495 Y0.056
+G1 X61.991 Y0.099
+G1 X62.487 Y0.155
+G1 X62.981 Y0.223
+G1 X63.473 Y0.304
+G1 X63.963 Y0.397
+G1 X64.450 Y0.501
+G1 X64.935 Y0.618
+G1 X65.417 Y0.748
+G1 X65.895 Y0.889
+G1 X66.370 Y1.041
+G1 X66.840 Y1.206
+G1 X67.307 Y1.383
+G1 X67.769 Y1.570
+G1 X68.226 Y1.770
+G1 X68.678 Y1.981
+G1 X69.124 Y2.203
+G1 X69.565 Y2.436
+G1 X70.000 Y2.679
+G1 X70.429 Y2.934
+G1 X70.851 Y3.199
+G1 X71.266 Y3.475
+G1 X71.675 Y3.761
+G1 X72.076 Y4.057
+G1 X72.470 Y4.363
+G1 X72.856 Y4.679
+G1 X73.234 Y5.004
+G1 X73.603 Y5.339
+G1 X73.965 Y5.683
+G1 X74.317 Y6.035
+G1 X74.661 Y6.397
+G1 X74.996 Y6.766
+G1 X75.321 Y7.144
+G1 X75.637 Y7.530
+G1 X75.943 Y7.924
+G1 X76.239 Y8.325
+G1 X76.525 Y8.734
+G1 X76.801 Y9.149
+G1 X77.066 Y9.571
+G1 X77.321 Y10.000
+G1 X77.564 Y10.435
+G1 X77.797 Y10.876
+G1 X78.019 Y11.322
+G1 X78.230 Y11.774
+G1 X78.430 Y12.231
+G1 X78.617 Y12.693
+G1 X78.794 Y13.160
+G1 X78.959 Y13.630
+G1 X79.111 Y14.105
+G1 X79.252 Y14.583
+G1 X79.382 Y15.065
+G1 X79.499 Y15.550
+G1 X79.603 Y16.037
+G1 X79.696 Y16.527
+G1 X79.777 Y17.019
+G1 X79.845 Y17.513
+G1 X79.901 Y18.009
+G1 X79.944 Y18.505
+G1 X79.975 Y19.003
+G1 X79.994 Y19.501
+G1 X80.000 Y20.000
+G1 X79.994 Y20.499
+G1 X79.975 Y20.997
+G1 X79.944 Y21.495
+G1 X79.901 Y21.991
+G1 X79.845 Y22.487
+G1 X79.777 Y22.981
+G1 X79.696 Y23.473
+G1 X79.603 Y23.963
+G1 X79.499 Y24.450
+G1 X79.382 Y24.935
+G1 X79.252 Y25.417
+G1 X79.111 Y25.895
+G1 X78.959 Y26.370
+G1 X78.794 Y26.840
+G1 X78.617 Y27.307
+G1 X78.430 Y27.769
+G1 X78.230 Y28.226
+G1 X78.019 Y28.678
+G1 X77.797 Y29.124
+G1 X77.564 Y29.565
+G1 X77.321 Y30.000
+G1 X77.066 Y30.429
+G1 X76.801 Y30.851
+G1 X76.525 Y31.266
+G1 X76.239 Y31.675
+G1 X75.943 Y32.076
+G1 X75.637 Y32.470
+G1 X75.321 Y32.856
+G1 X74.996 Y33.234
+G1 X74.661 Y33.603
+G1 X74.317 Y33.965
+G1 X73.965 Y34.317
+G1 X73.603 Y34.661
+G1 X73.234 Y34.996
+G1 X72.856 Y35.321
+G1 X72.470 Y35.637
+G1 X72.076 Y35.943
+G1 X71.675 Y36.239
+G1 X71.266 Y36.525
+G1 X70.851 Y36.801
+G1 X70.429 Y37.066
+G1 X70.000 Y37.321
+G1 X69.565 Y37.564
+G1 X69.124 Y37.797
+G1 X68.678 Y38.019
+G1 X68.226 Y38.230
+G1 X67.769 Y38.430
+G1 X67.307 Y38.617
+G1 X66.840 Y38.794
+G1 X66.370 Y38.959
+G1 X65.895 Y39.111
+G1 X65.417 Y39.252
+G1 X64.935 Y39.382
+G1 X64.450 Y39.499
+G1 X63.963 Y39.603
+G1 X63.473 Y39.696
+G1 X62.981 Y39.777
+G1 X62.487 Y39.845
+G1 X61.991 Y39.901
+G1 X61.495 Y39.944
+G1 X60.997 Y39.975
+G1 X60.499 Y39.994
+G1 X60.000 Y40.000
+G1 X59.501 Y39.994
+G1 X59.003 Y39.975
+G1 X58.505 Y39.944
+G1 X58.009 Y39.901
+G1 X57.513 Y39.845
+G1 X57.019 Y39.777
+G1 X56.527 Y39.696
+G1 X56.037 Y39.603
+G1 X55.550 Y39.499
+G1 X55.065 Y39.382
+G1 X54.583 Y39.252
+G1 X54.105 Y39.111
+G1 X53.630 Y38.959
+G1 X53.160 Y38.794
+G1 X52.693 Y38.617
+G1 X52.231 Y38.430
+G1 X51.774 Y38.230
+G1 X51.322 Y38.019
+G1 X50.876 Y37.797
+G1 X50.435 Y37.564
+G1 X50.000 Y37.321
+G1 X49.571 Y37.066
+G1 X49.149 Y36.801
+G1 X48.734 Y36.525
+G1 X48.325 Y36.239
+G1 X47.924 Y35.943
+G1 X47.530 Y35.637
+G1 X47.144 Y35.321
+G1 X46.766 Y34.996
+G1 X46.397 Y34.661
+G1 X46.035 Y34.317
+G1 X45.683 Y33.965
+G1 X45.339 Y33.603
+G1 X45.004 Y33.234
+G1 X44.679 Y32.856
+G1 X44.363 Y32.470
+G1 X44.057 Y32.076
+G1 X43.761 Y31.675
+G1 X43.475 Y31.266
+G1 X43.199 Y30.851
+G1 X42.934 Y30.429
+G1 X42.679 Y30.000
+G1 X42.436 Y29.565
+G1 X42.203 Y29.124
+G1 X41.981 Y28.678
+G1 X41.770 Y28.226
+G1 X41.570 Y27.769
+G1 X41.383 Y27.307
+G1 X41.206 Y26.840
+G1 X41.041 Y26.370
+G1 X40.889 Y25.895
+G1 X40.748 Y25.417
+G1 X40.618 Y24.935
+G1 X40.501 Y24.450
+G1 X40.397 Y23.963
+G1 X40.304 Y23.473
+G1 X40.223 Y22.981
+G1 X40.155 Y22.487
+G1 X40.099 Y21.991
+G1 X40.056 Y21.495
+G1 X40.025 Y20.997
+G1 X40.006 Y20.499
+G1 X40.000 Y20.000
+G1 X40.006 Y19.501
+G1 X40.025 Y19.003
+G1 X40.056 Y18.505
+G1 X40.099 Y18.009
+G1 X40.155 Y17.513
+G1 X40.223 Y17.019
+G1 X40.304 Y16.527
+G1 X40.397 Y16.037
+G1 X40.501 Y15.550
+G1 X40.618 Y15.065
+G1 X40.748 Y14.583
+G1 X40.889 Y14.105
+G1 X41.041 Y13.630
+G1 X41.206 Y13.160
+G1 X41.383 Y12.693
+G1 X41.570 Y12.231
+G1 X41.770 Y11.774
+G1 X41.981 Y11.322
+G1 X42.203 Y10.876
+G1 X42.436 Y10.435
+G1 X42.679 Y10.000
+G1 X42.934 Y9.571
+G1 X43.199 Y9.149
+G1 X43.475 Y8.734
+G1 X43.761 Y8.325
+G1 X44.057 Y7.924
+G1 X44.363 Y7.530
+G1 X44.679 Y7.144
+G1 X45.004 Y6.766
+G1 X45.339 Y6.397
+G1 X45.683 Y6.035
+G1 X46.035 Y5.683
+G1 X46.397 Y5.339
+G1 X46.766 Y5.004
+G1 X47.144 Y4.679
+G1 X47.530 Y4.363
+G1 X47.924 Y4.057
+G1 X48.325 Y3.761
+G1 X48.734 Y3.475
+G1 X49.149 Y3.199
+G1 X49.571 Y2.934
+G1 X50.000 Y2.679
+G1 X50.435 Y2.436
+G1 X50.876 Y2.203
+G1 X51.322 Y1.981
+G1 X51.774 Y1.770
+G1 X52.231 Y1.570
+G1 X52.693 Y1.383
+G1 X53.160 Y1.206
+G1 X53.630 Y1.041
+G1 X54.105 Y0.889
+G1 X54.583 Y0.748
+G1 X55.065 Y0.618
+G1 X55.550 Y0.501
+G1 X56.037 Y0.397
+G1 X56.527 Y0.304
+G1 X57.019 Y0.223
+G1 X57.513 Y0.155
+G1 X58.009 Y0.099
+G1 X58.505 Y0.056
+G1 X59.003 Y0.025
+G1 X59.501 Y0.006
+G1 X60.000 Y0.000
+G0 X0 Y0
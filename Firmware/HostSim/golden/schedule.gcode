@@ -0,0 +1,18 @@
+; square, arcs and a z move stepped from the precomputed step schedule
+G21
+G90
+G1 X20 F3000
+G1 Y20
+G1 X0
+G1 Y0
+G1 Z1 F300
+G1 X10 Y10 F6000
+G0 X0 Y0 Z0
+G0 X10 Y0
+G2 X10 Y0 I-10 J0 F2400
+G1 X10.5 Y0.2
+G1 X11 Y0.1
+G1 X11.5 Y0.4
+G3 X0 Y0 I-5.75 J-0.2 F1200
+G1 Z2 F600
+G0 X0 Y0 Z0
@@ -0,0 +1,10 @@
+; square with a z lift and a diagonal, exercises junctions
+G21
+G90
+G1 X20 F3000
+G1 Y20
+G1 X0
+G1 Y0
+G1 Z1 F300
+G1 X10 Y10 F6000
+G0 X0 Y0 Z0
@@ -0,0 +1,34 @@
+#pragma once
+
+// Host simulation replacement for the FreeRTOS kernel headers.
+// Only the subset used by the motion core is provided, time is simulated and
+// advances only when a task sleeps (see sim.h)
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE                 ( ( BaseType_t ) 0 )
+#define pdTRUE                  ( ( BaseType_t ) 1 )
+#define pdPASS                  ( pdTRUE )
+#define pdFAIL                  ( pdFALSE )
+
+#define portMAX_DELAY           ( TickType_t ) 0xffffffffUL
+#define configTICK_RATE_HZ      ( ( TickType_t ) 1000 )
+#define portTICK_PERIOD_MS      ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define pdMS_TO_TICKS( xTimeInMs ) ( ( TickType_t ) ( ( ( TickType_t ) ( xTimeInMs ) * ( TickType_t ) configTICK_RATE_HZ ) / ( TickType_t ) 1000 ) )
+
+#define tskIDLE_PRIORITY        ( ( UBaseType_t ) 0U )
+
+// there is only one thread of execution so these are all no-ops
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define taskENTER_CRITICAL_FROM_ISR() 0
+#define taskEXIT_CRITICAL_FROM_ISR( x ) (void)(x)
+#define taskDISABLE_INTERRUPTS()
+#define taskENABLE_INTERRUPTS()
+#define portYIELD_FROM_ISR( x ) (void)(x)
+#define portEND_SWITCHING_ISR( x ) (void)(x)
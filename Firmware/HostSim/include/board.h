@@ -0,0 +1,71 @@
+#pragma once
+
+// Host simulation replacement for the lpcopen board and chip headers.
+// The GPIO block is a plain memory struct laid out like LPC_GPIO_T so that
+// Pin and StepperMotor compile unchanged and the simulator (or a test) can
+// inspect the pin state after each tick.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __IO volatile
+#define __O volatile
+
+typedef struct {
+    __IO uint8_t B[8][32];      // byte pin registers
+    __IO uint32_t W[8][32];     // word pin registers
+    __IO uint32_t DIR[8];       // direction registers
+    __IO uint32_t MASK[8];
+    __IO uint32_t PIN[8];
+    __IO uint32_t MPIN[8];
+    __IO uint32_t SET[8];
+    __O  uint32_t CLR[8];
+    __O  uint32_t NOT[8];
+} LPC_GPIO_T;
+
+extern LPC_GPIO_T sim_gpio_port;
+#define LPC_GPIO_PORT (&sim_gpio_port)
+
+static inline void Chip_GPIO_SetPinDIROutput(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin)
+{
+    pGPIO->DIR[port] |= 1UL << pin;
+}
+
+static inline void Chip_GPIO_SetPinDIRInput(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin)
+{
+    pGPIO->DIR[port] &= ~(1UL << pin);
+}
+
+static inline void Chip_GPIO_SetPinDIR(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin, uint8_t output)
+{
+    if(output) {
+        Chip_GPIO_SetPinDIROutput(pGPIO, port, pin);
+    } else {
+        Chip_GPIO_SetPinDIRInput(pGPIO, port, pin);
+    }
+}
+
+#define SCU_MODE_PULLUP            (0x0 << 3)
+#define SCU_MODE_REPEATER          (0x1 << 3)
+#define SCU_MODE_INACT             (0x2 << 3)
+#define SCU_MODE_PULLDOWN          (0x3 << 3)
+#define SCU_MODE_HIGHSPEEDSLEW_EN  (0x1 << 5)
+#define SCU_MODE_INBUFF_EN         (0x1 << 6)
+#define SCU_MODE_ZIF_DIS           (0x1 << 7)
+#define SCU_MODE_4MA_DRIVESTR      (0x0 << 8)
+#define SCU_MODE_8MA_DRIVESTR      (0x1 << 8)
+#define SCU_MODE_14MA_DRIVESTR     (0x2 << 8)
+#define SCU_MODE_20MA_DRIVESTR     (0x3 << 8)
+
+// there is no pin muxing on the host
+static inline void Chip_SCU_PinMuxSet(uint8_t port, uint8_t pin, uint16_t modefunc)
+{
+    (void)port; (void)pin; (void)modefunc;
+}
+
+#ifdef __cplusplus
+}
+#endif
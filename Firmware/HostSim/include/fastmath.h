@@ -0,0 +1,4 @@
+#pragma once
+
+// newlib specific header, the host libm is used instead
+#include <math.h>
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// a simple FIFO, a receive on an empty queue advances simulated time until it times out
+QueueHandle_t xQueueCreate( UBaseType_t uxQueueLength, UBaseType_t uxItemSize );
+BaseType_t xQueueSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait );
+BaseType_t xQueueSendFromISR( QueueHandle_t xQueue, const void * const pvItemToQueue, BaseType_t *pxHigherPriorityTaskWoken );
+BaseType_t xQueueReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait );
+UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue );
+UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue );
+void vQueueDelete( QueueHandle_t xQueue );
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+// the host has no cycle counter to busy wait on, delays are ignored
+static inline void StopWatch_DelayUs(uint32_t us) { (void)us; }
+static inline void StopWatch_DelayMs(uint32_t ms) { (void)ms; }
+
+// for timing the stopwatch counts host nanoseconds (it wraps every 4 seconds, as on the board)
+static inline uint32_t StopWatch_Start(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+static inline uint32_t StopWatch_Elapsed(uint32_t startTime) { return StopWatch_Start() - startTime; }
+static inline uint32_t StopWatch_TicksPerSecond(void) { return 1000000000UL; }
+static inline uint32_t StopWatch_TicksToMs(uint32_t ticks) { return ticks / 1000000UL; }
+static inline uint32_t StopWatch_TicksToUs(uint32_t ticks) { return ticks / 1000UL; }
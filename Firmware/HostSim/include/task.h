@@ -0,0 +1,30 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)( void * );
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TickType_t xTaskGetTickCount( void );
+TickType_t xTaskGetTickCountFromISR( void );
+void vTaskDelay( const TickType_t xTicksToDelay );
+void vTaskSuspendAll( void );
+BaseType_t xTaskResumeAll( void );
+TaskHandle_t xTaskGetCurrentTaskHandle( void );
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask );
+void vTaskDelete( TaskHandle_t xTaskToDelete );
+UBaseType_t uxTaskGetStackHighWaterMark( TaskHandle_t xTask );
+size_t xPortGetFreeHeapSize( void );
+
+// task notifications, there is only one simulated task so these just count
+BaseType_t xTaskNotifyGive( TaskHandle_t xTaskToNotify );
+void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken );
+uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait );
+
+#ifdef __cplusplus
+}
+#endif
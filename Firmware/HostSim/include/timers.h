@@ -0,0 +1,22 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)( TimerHandle_t xTimer );
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// software timers are run from vTaskDelay() as simulated time advances
+TimerHandle_t xTimerCreate( const char * const pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction );
+BaseType_t xTimerStart( TimerHandle_t xTimer, TickType_t xTicksToWait );
+BaseType_t xTimerStop( TimerHandle_t xTimer, TickType_t xTicksToWait );
+BaseType_t xTimerDelete( TimerHandle_t xTimer, TickType_t xTicksToWait );
+BaseType_t xTimerChangePeriod( TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait );
+void *pvTimerGetTimerID( const TimerHandle_t xTimer );
+
+#ifdef __cplusplus
+}
+#endif
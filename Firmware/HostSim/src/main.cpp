@@ -0,0 +1,654 @@
+#include "main.h"
+#include "sim.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "Module.h"
+#include "OutputStream.h"
+#include "GCode.h"
+#include "GCodeProcessor.h"
+#include "BinaryGCode.h"
+#include "Dispatcher.h"
+#include "ConfigReader.h"
+#include "Robot.h"
+#include "Planner.h"
+#include "Conveyor.h"
+#include "StepTicker.h"
+#include "StepperMotor.h"
+#include "SlowTicker.h"
+#include "StepTrace.h"
+#include "SlabAllocator.h"
+#include "BilinearGrid.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <unistd.h>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+ * Host replay of the motion core.
+ * Reads a config.ini and a gcode file, runs the gcode through the real
+ * Dispatcher/Robot/Planner/Conveyor/StepTicker on simulated time and
+ * optionally records or verifies a step trace.
+ *
+ * The trace has one line per step tick that issued at least one step:-
+ *   tick step_bits dir_bits
+ * where bit n is actuator n, the dir bit is the state of the direction pin.
+ */
+
+// the pools that would be in the LPC4330 AHB ram banks
+static uint8_t ram2_pool[32 * 1024];
+static uint8_t ram3_pool[32 * 1024];
+static uint8_t ram4_pool[16 * 1024];
+static uint8_t ram5_pool[16 * 1024];
+static const size_t slab_size= 16 * 1024;
+MemoryPool *_RAM2;
+MemoryPool *_RAM3;
+MemoryPool *_RAM4;
+MemoryPool *_RAM5;
+
+void setup_memory_pool()
+{
+    _RAM2= new MemoryPool(ram2_pool, sizeof(ram2_pool));
+    _RAM3= new MemoryPool(ram3_pool, sizeof(ram3_pool));
+    _RAM4= new MemoryPool(ram4_pool, sizeof(ram4_pool));
+    _RAM5= new MemoryPool(ram5_pool, sizeof(ram5_pool));
+
+    // small allocations from new come from the slab, as they do on the firmware
+    void *slab= _RAM2->alloc(slab_size);
+    if(slab != nullptr) {
+        SlabAllocator::set_instance(new SlabAllocator(slab, slab_size));
+    }
+}
+
+// sleep for given ms, time only moves when we sleep
+void safe_sleep(uint32_t ms)
+{
+    TickType_t delayms = pdMS_TO_TICKS(10); // 10 ms sleep
+    while(ms > 0) {
+        vTaskDelay(delayms);
+        if(ms > 10) {
+            ms -= 10;
+        } else {
+            break;
+        }
+    }
+}
+
+// time moves in 1ms steps until the conveyor notifies us it has released a block
+void safe_wait(uint32_t ms)
+{
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+}
+
+extern "C" void vApplicationTickHook( void )
+{
+    // as on the target the stepticker wakes the command thread from the RTOS tick
+    if(Conveyor::getInstance() != nullptr) {
+        Conveyor::getInstance()->notify_block_release();
+    }
+}
+
+void print_to_all_consoles(const char *str)
+{
+    printf("%s", str);
+}
+
+void set_abort_comms()
+{
+}
+
+static GCodeProcessor gp;
+
+// cut down version of the firmware dispatch_line, no file upload or M500 handling
+bool dispatch_line(OutputStream& os, const char *ln)
+{
+    std::string line(ln);
+
+    // see if a command
+    if(islower(line[0]) || line[0] == '$') {
+        if(!THEDISPATCHER->dispatch(line.c_str(), os)) {
+            os.printf("error:Unsupported command - %s\n", line.c_str());
+        }else if(!os.is_no_response()) {
+            os.puts("ok\n");
+        }
+        os.set_no_response(false);
+        return true;
+    }
+
+    GCodeProcessor::GCodes_t gcodes;
+    bool ok;
+    if(ln[0] == BinaryGCode::STX) {
+        // a binary record (STX len payload), decoded by the decoder of the stream it came from
+        GCode gc;
+        ok = os.get_decoder()->decode((const uint8_t *)&ln[2], (uint8_t)ln[1], gc);
+        gcodes.push_back(gc);
+        line = "(binary record)";
+    } else {
+        ok = gp.parse(line.c_str(), gcodes);
+    }
+    if(!ok) {
+        if(gcodes.empty()) {
+            os.printf("rs N%d\n", gp.get_line_number() + 1);
+            return true;
+        }
+
+        auto& g= gcodes.back();
+        if(g.has_error()) {
+            os.printf("// WARNING gcode parse failed %s - %s\n", g.get_error_message(), line.c_str());
+        }
+        gcodes.pop_back();
+    }
+
+    if(gcodes.empty()) {
+        os.puts("ok\n");
+        return true;
+    }
+
+    int ngcodes = gcodes.size();
+    for(auto& i : gcodes) {
+        if(i.has_m() || i.has_g()) {
+            if(!THEDISPATCHER->dispatch(i, os, ngcodes == 1)) {
+                if(ngcodes == 1) os.puts("ok - ignored\n");
+            }
+        } else {
+            os.puts("ok\n");
+        }
+        --ngcodes;
+    }
+
+    return true;
+}
+
+// records the step trace, and compares it to a golden trace if one was given
+class TraceRecorder
+{
+public:
+    TraceRecorder(FILE *out, FILE *golden) : out(out), golden(golden) {}
+
+    void tick(uint64_t t)
+    {
+        auto& actuators = Robot::getInstance()->actuators;
+        uint32_t stepbits = 0, dirbits = 0;
+        for (size_t i = 0; i < actuators.size(); ++i) {
+            int32_t pos = actuators[i]->get_current_step();
+            if(pos != last_pos[i]) {
+                last_pos[i] = pos;
+                stepbits |= (1 << i);
+            }
+            if(actuators[i]->which_direction()) dirbits |= (1 << i);
+        }
+        if(stepbits == 0) return;
+
+        ++nevents;
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%llu %02lX %02lX\n", (unsigned long long)t, (unsigned long)stepbits, (unsigned long)dirbits);
+        if(out != nullptr) fputs(buf, out);
+        if(golden != nullptr && mismatch == 0) {
+            char gbuf[64];
+            if(fgets(gbuf, sizeof(gbuf), golden) == nullptr || strcmp(buf, gbuf) != 0) {
+                mismatch = nevents;
+                printf("ERROR: trace differs from golden at event %lu: got %s", (unsigned long)nevents, buf);
+            }
+        }
+    }
+
+    // check the golden trace does not have more events than we generated
+    bool finish()
+    {
+        if(golden != nullptr && mismatch == 0) {
+            char gbuf[64];
+            if(fgets(gbuf, sizeof(gbuf), golden) != nullptr) {
+                printf("ERROR: trace is shorter than golden, %lu events\n", (unsigned long)nevents);
+                mismatch = nevents + 1;
+            }
+        }
+        return mismatch == 0;
+    }
+
+    uint64_t get_events() const { return nevents; }
+
+private:
+    FILE *out;
+    FILE *golden;
+    int32_t last_pos[k_max_actuators]{0};
+    uint64_t nevents{0};
+    uint64_t mismatch{0};
+};
+
+// times parsing every line of the gcode count times, the same way dispatch_line() does
+static int parse_benchmark(FILE *fp, int count)
+{
+    std::vector<std::string> lines;
+    char line[132];
+    while(fgets(line, sizeof(line), fp) != nullptr) {
+        size_t n = strlen(line);
+        while(n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) line[--n] = '\0';
+        if(n > 0 && line[0] != ';') lines.push_back(line);
+    }
+    if(lines.empty()) {
+        printf("ERROR: no gcode to parse\n");
+        return 2;
+    }
+
+    GCodeProcessor parser;
+    size_t ngcodes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        for(auto& l : lines) {
+            GCodeProcessor::GCodes_t gcodes;
+            parser.parse(l.c_str(), gcodes);
+            ngcodes += gcodes.size();
+        }
+    }
+    double elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / 1e9;
+
+    size_t nlines = lines.size() * count;
+    printf("parsed %lu lines (%lu gcodes) in %1.3f s, %1.0f lines/s, %1.0f ns/line\n",
+           (unsigned long)nlines, (unsigned long)ngcodes, elapsed, nlines / elapsed, elapsed * 1e9 / nlines);
+    return 0;
+}
+
+// times reading the config count times, every section is asked for as a section and as sub sections
+// which is about what the modules do when they are configured at boot
+static int config_benchmark(const char *fn, int count)
+{
+    size_t nsections = 0;
+    size_t nkeys = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        std::ifstream fs(fn);
+        if(!fs.is_open()) {
+            printf("ERROR: opening config file: %s\n", fn);
+            return 2;
+        }
+        ConfigReader cr(fs);
+        ConfigReader::sections_t sections;
+        cr.get_sections(sections);
+        for(auto& s : sections) {
+            ConfigReader::section_map_t m;
+            cr.get_section(s.c_str(), m);
+            ConfigReader::sub_section_map_t ssm;
+            cr.get_sub_sections(s.c_str(), ssm);
+            nkeys += m.size();
+        }
+        nsections += sections.size();
+    }
+    double elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / 1e9;
+
+    printf("%s: %lu sections, %lu keys, %1.1f us per load\n", fn, (unsigned long)nsections / count, (unsigned long)nkeys / count, elapsed * 1e6 / count);
+    return 0;
+}
+
+// the height at x, y interpolated from the four points around it each time, the way CartGridStrategy used to
+static float grid_direct(const float *grid, int nx, int ny, float x_start, float y_start, float x_size, float y_size, float x, float y)
+{
+    float x_target = std::min(std::max(x, std::min(x_start, x_start + x_size)), std::max(x_start, x_start + x_size));
+    float y_target = std::min(std::max(y, std::min(y_start, y_start + y_size)), std::max(y_start, y_start + y_size));
+    float grid_x = std::max(0.001F, (x_target - x_start) / (x_size / (nx - 1)));
+    float grid_y = std::max(0.001F, (y_target - y_start) / (y_size / (ny - 1)));
+    int floor_x = floorf(grid_x);
+    int floor_y = floorf(grid_y);
+    float ratio_x = grid_x - floor_x;
+    float ratio_y = grid_y - floor_y;
+    // at the far edge the ratio is 0 so the point past the edge does not count
+    int next_x = std::min(floor_x + 1, nx - 1);
+    int next_y = std::min(floor_y + 1, ny - 1);
+    float z1 = grid[floor_x + floor_y * nx];
+    float z2 = grid[floor_x + next_y * nx];
+    float z3 = grid[next_x + floor_y * nx];
+    float z4 = grid[next_x + next_y * nx];
+    float left = (1 - ratio_y) * z1 + ratio_y * z2;
+    float right = (1 - ratio_y) * z3 + ratio_y * z4;
+    return (1 - ratio_x) * left + ratio_x * right;
+}
+
+static int grid_benchmark(int count)
+{
+    // a 7x7 grid on a 200mm bed, the path zig zags across it in 0.1mm steps and a bit past the edges
+    const int nx = 7, ny = 7;
+    const float size = 200;
+    float grid[nx * ny];
+    for (int y = 0; y < ny; ++y) {
+        for (int x = 0; x < nx; ++x) {
+            grid[x + y * nx] = 0.2F * sinf(x * 0.9F) * cosf(y * 0.7F) + 0.01F * (x - y);
+        }
+    }
+    BilinearGrid bilinear;
+    if(!bilinear.allocate(nx * ny)) {
+        printf("ERROR: out of memory\n");
+        return 2;
+    }
+    bilinear.set(grid, nx, ny, 0, 0, size, size);
+
+    const int npoints = 10000;
+    std::vector<float> px(npoints), py(npoints);
+    for (int i = 0; i < npoints; ++i) {
+        px[i] = fmodf(i * 0.1F, size + 20) - 10;
+        py[i] = (i / 2200) * 40.0F - 5;
+    }
+
+    float max_diff = 0;
+    for (int i = 0; i < npoints; ++i) {
+        float d = fabsf(bilinear.get_z(px[i], py[i]) - grid_direct(grid, nx, ny, 0, 0, size, size, px[i], py[i]));
+        if(d > max_diff) max_diff = d;
+    }
+
+    volatile float sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < count; ++n) {
+        for (int i = 0; i < npoints; ++i) sum = sum + grid_direct(grid, nx, ny, 0, 0, size, size, px[i], py[i]);
+    }
+    double direct = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / 1e9;
+
+    start = std::chrono::steady_clock::now();
+    for (int n = 0; n < count; ++n) {
+        for (int i = 0; i < npoints; ++i) sum = sum + bilinear.get_z(px[i], py[i]);
+    }
+    double patches = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / 1e9;
+
+    double n = (double)count * npoints;
+    printf("interpolating four points: %1.1f M transforms/s\n", n / direct / 1e6);
+    printf("precomputed patches: %1.1f M transforms/s\n", n / patches / 1e6);
+    printf("largest difference: %g mm\n", max_diff);
+    return 0;
+}
+
+// reads the next text line without the newline, or the next binary record which is returned
+// as STX len payload, the way the comms threads queue them for the command thread
+static bool read_line(FILE *fp, char *line, size_t sz)
+{
+    int c = fgetc(fp);
+    if(c == EOF) return false;
+
+    if(c == BinaryGCode::STX) {
+        uint8_t frame[BinaryGCode::MAX_FRAME];
+        frame[0] = c;
+        int len = fgetc(fp);
+        size_t fs = len == EOF ? 0 : BinaryGCode::frame_size(len);
+        frame[1] = len;
+        if(fs == 0 || fread(&frame[2], 1, fs - 2, fp) != fs - 2 || !BinaryGCode::check_frame(frame, fs)) {
+            printf("ERROR: bad binary record\n");
+            return false;
+        }
+        memcpy(line, frame, fs - 2);
+        return true;
+    }
+
+    ungetc(c, fp);
+    if(fgets(line, sz, fp) == nullptr) return false;
+    size_t n = strlen(line);
+    while(n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) line[--n] = '\0';
+    return true;
+}
+
+// the reference encoder, writes the gcode to stdout with the moves it can as binary records
+static int encode_gcode(FILE *fp)
+{
+    GCodeProcessor parser;
+    BinaryGCode encoder;
+    char line[132];
+    size_t nlines = 0, nrecords = 0, text_bytes = 0, out_bytes = 0;
+    while(fgets(line, sizeof(line), fp) != nullptr) {
+        size_t n = strlen(line);
+        while(n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) line[--n] = '\0';
+        ++nlines;
+        text_bytes += n + 1;
+
+        // commands and numbered lines stay as text
+        if(!islower(line[0]) && line[0] != '$' && line[0] != 'N') {
+            GCodeProcessor::GCodes_t gcodes;
+            uint8_t frame[BinaryGCode::MAX_FRAME];
+            size_t fs;
+            if(parser.parse(line, gcodes) && gcodes.size() == 1 && (fs = encoder.encode(gcodes[0], frame)) > 0) {
+                fwrite(frame, 1, fs, stdout);
+                out_bytes += fs;
+                ++nrecords;
+                continue;
+            }
+        }
+        printf("%s\n", line);
+        out_bytes += n + 1;
+    }
+    fprintf(stderr, "%lu lines, %lu as binary records, %lu bytes of text as %lu bytes\n",
+            (unsigned long)nlines, (unsigned long)nrecords, (unsigned long)text_bytes, (unsigned long)out_bytes);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s -c config.ini [-t trace] [-g golden] [-f frequency] [-r steptrace] [-p count] [-b count] [-l count] [-e] [-v] [gcode file]\n", prog);
+    printf(" -c config.ini - the configuration to use\n");
+    printf(" -t trace - write the step trace to the given file\n");
+    printf(" -g golden - compare the step trace with the given file, exit status is 1 if they differ\n");
+    printf(" -f frequency - step ticker frequency, default is 150000\n");
+    printf(" -v - print the responses from the gcode handlers\n");
+    printf(" -p count - only parse the gcode, count times, and report the parse rate\n");
+    printf(" -b count - only read the config, count times, and report the time it takes\n");
+    printf(" -e - only encode the gcode to stdout, with the moves that can be as binary records\n");
+    printf(" -l count - only run the bed leveling grid compensation over a path, count times, and report the rate\n");
+#ifdef STEPTICKER_TRACE
+    printf(" -r steptrace - record the stepticker step trace to the given file\n");
+#endif
+    printf(" gcode is read from stdin if no file is given\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *config_fn = nullptr;
+    const char *trace_fn = nullptr;
+    const char *golden_fn = nullptr;
+    const char *steptrace_fn = nullptr;
+    float frequency = 150000;
+    bool verbose = false;
+    int parse_count = 0;
+    int config_count = 0;
+    int grid_count = 0;
+    bool encode = false;
+
+    int c;
+    while((c = getopt(argc, argv, "c:t:g:f:r:p:b:l:evh")) != -1) {
+        switch(c) {
+            case 'c': config_fn = optarg; break;
+            case 't': trace_fn = optarg; break;
+            case 'g': golden_fn = optarg; break;
+            case 'f': frequency = strtof(optarg, nullptr); break;
+            case 'v': verbose = true; break;
+            case 'r': steptrace_fn = optarg; break;
+            case 'p': parse_count = atoi(optarg); break;
+            case 'b': config_count = atoi(optarg); break;
+            case 'l': grid_count = atoi(optarg); break;
+            case 'e': encode = true; break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+
+    if(parse_count > 0) {
+        FILE *fp = (optind < argc) ? fopen(argv[optind], "r") : stdin;
+        if(fp == nullptr) {
+            printf("ERROR: opening gcode file: %s\n", argv[optind]);
+            return 2;
+        }
+        int ret = parse_benchmark(fp, parse_count);
+        if(fp != stdin) fclose(fp);
+        return ret;
+    }
+
+    if(encode) {
+        FILE *fp = (optind < argc) ? fopen(argv[optind], "r") : stdin;
+        if(fp == nullptr) {
+            printf("ERROR: opening gcode file: %s\n", argv[optind]);
+            return 2;
+        }
+        int ret = encode_gcode(fp);
+        if(fp != stdin) fclose(fp);
+        return ret;
+    }
+
+    if(grid_count > 0) {
+        return grid_benchmark(grid_count);
+    }
+
+    if(config_fn == nullptr) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if(config_count > 0) {
+        return config_benchmark(config_fn, config_count);
+    }
+
+    setup_memory_pool();
+
+    SlowTicker *slow_ticker = new SlowTicker();
+    StepTicker *step_ticker = new StepTicker();
+    step_ticker->set_frequency(frequency);
+    step_ticker->set_unstep_time(1);
+    new Dispatcher();
+
+    std::ifstream fs(config_fn);
+    if(!fs.is_open()) {
+        printf("ERROR: opening config file: %s\n", config_fn);
+        return 2;
+    }
+
+    ConfigReader cr(fs);
+    Planner *planner = new Planner();
+    planner->configure(cr);
+    Conveyor *conveyor = new Conveyor();
+    conveyor->configure(cr);
+    Robot *robot = new Robot();
+    if(!robot->configure(cr)) {
+        printf("ERROR: Configuring robot failed\n");
+        return 2;
+    }
+    fs.close();
+
+    if(!planner->initialize(robot->get_number_registered_motors())) {
+        printf("FATAL: planner failed to initialize\n");
+        return 2;
+    }
+    THEDISPATCHER->build_dispatch_tables();
+    conveyor->start();
+    slow_ticker->start();
+    if(!step_ticker->start()) {
+        printf("ERROR: failed to start StepTicker\n");
+        return 2;
+    }
+
+    FILE *gcode_fp = stdin;
+    if(optind < argc) {
+        gcode_fp = fopen(argv[optind], "r");
+        if(gcode_fp == nullptr) {
+            printf("ERROR: opening gcode file: %s\n", argv[optind]);
+            return 2;
+        }
+    }
+
+    FILE *trace_fp = nullptr;
+    if(trace_fn != nullptr) {
+        trace_fp = fopen(trace_fn, "w");
+        if(trace_fp == nullptr) {
+            printf("ERROR: opening trace file: %s\n", trace_fn);
+            return 2;
+        }
+    }
+
+    FILE *golden_fp = nullptr;
+    if(golden_fn != nullptr) {
+        golden_fp = fopen(golden_fn, "r");
+        if(golden_fp == nullptr) {
+            printf("ERROR: opening golden trace file: %s\n", golden_fn);
+            return 2;
+        }
+    }
+
+    TraceRecorder recorder(trace_fp, golden_fp);
+    if(trace_fp != nullptr || golden_fp != nullptr) {
+        sim_set_tick_hook([&recorder](uint64_t t) { recorder.tick(t); });
+    }
+
+#ifdef STEPTICKER_TRACE
+    // the low priority drain task is a software timer here
+    StepTrace *step_trace = nullptr;
+    if(steptrace_fn != nullptr) {
+        step_trace = new StepTrace();
+        // the drain opens the file so it has to be running first
+        TimerHandle_t th = xTimerCreate("StepTraceDrain", pdMS_TO_TICKS(10), pdTRUE, nullptr, [](TimerHandle_t) { StepTrace::getInstance()->drain(); });
+        xTimerStart(th, 0);
+        if(!step_trace->initialize() || !step_trace->start_recording(steptrace_fn)) {
+            printf("ERROR: failed to start step trace to %s\n", steptrace_fn);
+            return 2;
+        }
+    }
+#else
+    if(steptrace_fn != nullptr) {
+        printf("ERROR: -r needs the step trace compiled in (rake steptrace=1)\n");
+        return 2;
+    }
+#endif
+
+    OutputStream nullos;
+    OutputStream coutos(&std::cout);
+    OutputStream& os = verbose ? coutos : nullos;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // this is the command thread loop
+    char line[132];
+    size_t nlines = 0;
+    while(read_line(gcode_fp, line, sizeof(line))) {
+        dispatch_line(os, line);
+        ++nlines;
+        Module::broadcast_in_commmand_ctx(false);
+        conveyor->check_queue();
+    }
+
+    // let everything run out
+    conveyor->wait_for_idle();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+#ifdef STEPTICKER_TRACE
+    if(step_trace != nullptr) step_trace->stop_recording();
+#endif
+
+    bool ok = recorder.finish();
+    if(trace_fp != nullptr) fclose(trace_fp);
+    if(golden_fp != nullptr) fclose(golden_fp);
+    if(gcode_fp != stdin) fclose(gcode_fp);
+
+    uint64_t ticks = sim_get_ticks();
+    printf("lines: %lu, step ticks: %llu, simulated time: %1.3f s, host time: %1.3f s\n",
+           (unsigned long)nlines, (unsigned long long)ticks, (double)ticks / step_ticker->get_frequency(), elapsed / 1e6);
+    if(ticks > 0) {
+        printf("step ISR: %1.1f %s/tick%s\n", (double)sim_get_isr_time() / ticks, sim_get_isr_units(), (trace_fp != nullptr || golden_fp != nullptr) ? " (including the trace recorder)" : "");
+    }
+    const Planner::schedule_stats_t& ss= planner->get_schedule_stats();
+    if(ss.count > 0) {
+        // what building the step schedules cost the command thread (host time)
+        printf("schedule build: %lu blocks, %1.1f us/block, %1.1f ns/step, max %1.1f us\n", (unsigned long)ss.count,
+               (double)ss.time / ss.count / 1000, (double)ss.time / ss.steps, (double)ss.max_time / 1000);
+    }
+    if(trace_fp != nullptr || golden_fp != nullptr) {
+        printf("step events: %llu\n", (unsigned long long)recorder.get_events());
+    }
+    for(auto a : robot->actuators) {
+        printf("actuator %d: %ld steps, %1.4f mm\n", a->get_motor_id(), (long)(int32_t)a->get_current_step(), a->get_current_position());
+    }
+
+    if(golden_fp != nullptr) {
+        printf("golden trace %s\n", ok ? "matched" : "did NOT match");
+    }
+
+    return ok ? 0 : 1;
+}
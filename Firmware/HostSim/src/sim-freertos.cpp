@@ -0,0 +1,261 @@
+#include "sim.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "queue.h"
+#include "timers.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+
+// The subset of the FreeRTOS API used by the firmware, implemented for a single
+// thread of execution on simulated time.
+
+static TickType_t rtos_ticks;
+
+struct sim_timer_t {
+    const char *name;
+    TickType_t period;
+    TickType_t expiry;
+    bool autoreload;
+    bool active;
+    void *id;
+    TimerCallbackFunction_t callback;
+};
+static std::vector<sim_timer_t*> timers;
+
+// defined by the application, called on every RTOS tick like configUSE_TICK_HOOK
+extern "C" void vApplicationTickHook( void );
+
+void sim_rtos_tick()
+{
+    ++rtos_ticks;
+    vApplicationTickHook();
+    for(auto t : timers) {
+        if(t->active && rtos_ticks >= t->expiry) {
+            if(t->autoreload) {
+                t->expiry += t->period;
+            } else {
+                t->active = false;
+            }
+            t->callback(t);
+        }
+    }
+}
+
+extern "C" TickType_t xTaskGetTickCount( void )
+{
+    return rtos_ticks;
+}
+
+extern "C" TickType_t xTaskGetTickCountFromISR( void )
+{
+    return rtos_ticks;
+}
+
+extern "C" void vTaskDelay( const TickType_t xTicksToDelay )
+{
+    sim_advance_ms(xTicksToDelay * portTICK_PERIOD_MS);
+}
+
+extern "C" void vTaskSuspendAll( void ) {}
+extern "C" BaseType_t xTaskResumeAll( void ) { return pdFALSE; }
+
+static int current_task;
+extern "C" TaskHandle_t xTaskGetCurrentTaskHandle( void )
+{
+    return &current_task;
+}
+
+extern "C" BaseType_t xTaskCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask )
+{
+    printf("ERROR: cannot create task %s, there is only one thread in the host simulation\n", pcName);
+    return pdFAIL;
+}
+
+extern "C" void vTaskDelete( TaskHandle_t xTaskToDelete ) {}
+extern "C" UBaseType_t uxTaskGetStackHighWaterMark( TaskHandle_t xTask ) { return 0; }
+extern "C" size_t xPortGetFreeHeapSize( void ) { return 0; }
+
+static uint32_t notify_count;
+extern "C" BaseType_t xTaskNotifyGive( TaskHandle_t xTaskToNotify )
+{
+    ++notify_count;
+    return pdPASS;
+}
+
+extern "C" void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken )
+{
+    ++notify_count;
+    if(pxHigherPriorityTaskWoken != nullptr) *pxHigherPriorityTaskWoken = pdTRUE;
+}
+
+// waits in 1ms steps so a notify from the simulated ISRs will wake us up
+extern "C" uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait )
+{
+    while(notify_count == 0 && xTicksToWait > 0) {
+        sim_advance_ms(1);
+        if(xTicksToWait != portMAX_DELAY) --xTicksToWait;
+    }
+
+    uint32_t n = notify_count;
+    if(n > 0) {
+        if(xClearCountOnExit) notify_count = 0;
+        else --notify_count;
+    }
+    return n;
+}
+
+// semaphores are counts, a mutex can always be taken as there is only one thread
+struct sim_semaphore_t {
+    bool mutex;
+    uint32_t count;
+};
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateMutex( void )
+{
+    return new sim_semaphore_t{true, 1};
+}
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateBinary( void )
+{
+    return new sim_semaphore_t{false, 0};
+}
+
+extern "C" BaseType_t xSemaphoreTake( SemaphoreHandle_t xSemaphore, TickType_t xBlockTime )
+{
+    sim_semaphore_t *s = (sim_semaphore_t *)xSemaphore;
+    if(s->mutex) return pdTRUE;
+    while(s->count == 0 && xBlockTime > 0) {
+        sim_advance_ms(1);
+        if(xBlockTime != portMAX_DELAY) --xBlockTime;
+    }
+    if(s->count == 0) return pdFALSE;
+    --s->count;
+    return pdTRUE;
+}
+
+extern "C" BaseType_t xSemaphoreGive( SemaphoreHandle_t xSemaphore )
+{
+    sim_semaphore_t *s = (sim_semaphore_t *)xSemaphore;
+    if(!s->mutex) s->count = 1;
+    return pdTRUE;
+}
+
+extern "C" BaseType_t xSemaphoreGiveFromISR( SemaphoreHandle_t xSemaphore, BaseType_t *pxHigherPriorityTaskWoken )
+{
+    if(pxHigherPriorityTaskWoken != nullptr) *pxHigherPriorityTaskWoken = pdTRUE;
+    return xSemaphoreGive(xSemaphore);
+}
+
+extern "C" void vSemaphoreDelete( SemaphoreHandle_t xSemaphore )
+{
+    delete (sim_semaphore_t *)xSemaphore;
+}
+
+// queues hold copies of the items like the real thing
+struct sim_queue_t {
+    size_t length;
+    size_t item_size;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+extern "C" QueueHandle_t xQueueCreate( UBaseType_t uxQueueLength, UBaseType_t uxItemSize )
+{
+    return new sim_queue_t{uxQueueLength, uxItemSize, {}};
+}
+
+extern "C" BaseType_t xQueueSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait )
+{
+    sim_queue_t *q = (sim_queue_t *)xQueue;
+    // nothing else can empty the queue while we wait
+    if(q->items.size() >= q->length) return pdFAIL;
+    const uint8_t *p = (const uint8_t *)pvItemToQueue;
+    q->items.emplace_back(p, p + q->item_size);
+    return pdPASS;
+}
+
+extern "C" BaseType_t xQueueSendFromISR( QueueHandle_t xQueue, const void * const pvItemToQueue, BaseType_t *pxHigherPriorityTaskWoken )
+{
+    if(pxHigherPriorityTaskWoken != nullptr) *pxHigherPriorityTaskWoken = pdFALSE;
+    return xQueueSend(xQueue, pvItemToQueue, 0);
+}
+
+extern "C" BaseType_t xQueueReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait )
+{
+    sim_queue_t *q = (sim_queue_t *)xQueue;
+    // only an ISR could fill the queue so wait for at most the timeout
+    while(q->items.empty() && xTicksToWait > 0 && xTicksToWait != portMAX_DELAY) {
+        sim_advance_ms(1);
+        --xTicksToWait;
+    }
+    if(q->items.empty()) return pdFAIL;
+    memcpy(pvBuffer, q->items.front().data(), q->item_size);
+    q->items.pop_front();
+    return pdPASS;
+}
+
+extern "C" UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue )
+{
+    sim_queue_t *q = (sim_queue_t *)xQueue;
+    return q->length - q->items.size();
+}
+
+extern "C" UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue )
+{
+    return ((sim_queue_t *)xQueue)->items.size();
+}
+
+extern "C" void vQueueDelete( QueueHandle_t xQueue )
+{
+    delete (sim_queue_t *)xQueue;
+}
+
+extern "C" TimerHandle_t xTimerCreate( const char * const pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction )
+{
+    sim_timer_t *t = new sim_timer_t{pcTimerName, xTimerPeriodInTicks, 0, uxAutoReload != 0, false, pvTimerID, pxCallbackFunction};
+    timers.push_back(t);
+    return t;
+}
+
+extern "C" BaseType_t xTimerStart( TimerHandle_t xTimer, TickType_t xTicksToWait )
+{
+    sim_timer_t *t = (sim_timer_t *)xTimer;
+    t->expiry = rtos_ticks + t->period;
+    t->active = true;
+    return pdPASS;
+}
+
+extern "C" BaseType_t xTimerStop( TimerHandle_t xTimer, TickType_t xTicksToWait )
+{
+    ((sim_timer_t *)xTimer)->active = false;
+    return pdPASS;
+}
+
+extern "C" BaseType_t xTimerDelete( TimerHandle_t xTimer, TickType_t xTicksToWait )
+{
+    for(auto i = timers.begin(); i != timers.end(); ++i) {
+        if(*i == xTimer) {
+            timers.erase(i);
+            break;
+        }
+    }
+    delete (sim_timer_t *)xTimer;
+    return pdPASS;
+}
+
+extern "C" BaseType_t xTimerChangePeriod( TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait )
+{
+    sim_timer_t *t = (sim_timer_t *)xTimer;
+    t->period = xNewPeriod;
+    // like FreeRTOS changing the period also starts the timer
+    return xTimerStart(xTimer, xTicksToWait);
+}
+
+extern "C" void *pvTimerGetTimerID( const TimerHandle_t xTimer )
+{
+    return ((sim_timer_t *)xTimer)->id;
+}
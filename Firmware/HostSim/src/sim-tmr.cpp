@@ -0,0 +1,153 @@
+#include "sim.h"
+#include "tmr-setup.h"
+#include "board.h"
+
+#include <stdio.h>
+#include <chrono>
+
+// Simulated TMR0/TMR1 and the GPIO register file
+
+LPC_GPIO_T sim_gpio_port;
+
+using tmr_handler_t = void (*)(void);
+
+static tmr_handler_t tmr0_mr0_handler;
+static tmr_handler_t tmr0_mr1_handler;
+static uint32_t tmr0_frequency;
+static bool tmr0_running;
+static bool tmr0_mr1_pending;
+
+static tmr_handler_t tmr1_handler;
+static uint32_t tmr1_frequency;
+static uint32_t tmr1_accumulator;
+
+static uint64_t current_tick;
+static uint32_t tick_remainder;
+static std::function<void(uint64_t)> tick_hook;
+static uint64_t isr_time;
+
+static inline uint64_t isr_clock()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+uint64_t sim_get_isr_time()
+{
+    return isr_time;
+}
+
+const char *sim_get_isr_units()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+extern "C" int tmr0_setup(uint32_t frequency, uint32_t delay, void *mr0handler, void *mr1handler)
+{
+    if(frequency == 0) return -1;
+    tmr0_frequency = frequency;
+    tmr0_mr0_handler = (tmr_handler_t)mr0handler;
+    tmr0_mr1_handler = (tmr_handler_t)mr1handler;
+    tmr0_running = true;
+    // the simulated timer is exact
+    return 0;
+}
+
+extern "C" void tmr0_mr1_start()
+{
+    tmr0_mr1_pending = true;
+}
+
+extern "C" void tmr0_stop()
+{
+    tmr0_running = false;
+    tmr0_mr1_pending = false;
+}
+
+extern "C" int tmr1_setup(uint32_t frequency, void *timer_handler)
+{
+    if(frequency == 0) return 0;
+    tmr1_frequency = frequency;
+    tmr1_handler = (tmr_handler_t)timer_handler;
+    tmr1_accumulator = 0;
+    return frequency;
+}
+
+extern "C" void tmr1_stop()
+{
+    tmr1_handler = nullptr;
+}
+
+extern "C" int tmr1_set_frequency(uint32_t frequency)
+{
+    tmr1_frequency = frequency;
+    return frequency;
+}
+
+void sim_set_tick_hook(std::function<void(uint64_t)> fnc)
+{
+    tick_hook = fnc;
+}
+
+uint64_t sim_get_ticks()
+{
+    return current_tick;
+}
+
+uint32_t sim_get_tick_frequency()
+{
+    return tmr0_running ? tmr0_frequency : 0;
+}
+
+void sim_run_ticks(uint64_t n)
+{
+    if(!tmr0_running) {
+        current_tick += n;
+        return;
+    }
+
+    uint64_t start = isr_clock();
+    for (uint64_t i = 0; i < n; ++i) {
+        tmr0_mr0_handler();
+        // the unstep match fires well before the next step tick
+        if(tmr0_mr1_pending) {
+            tmr0_mr1_pending = false;
+            tmr0_mr1_handler();
+        }
+        if(tick_hook) tick_hook(current_tick);
+        ++current_tick;
+    }
+    isr_time += isr_clock() - start;
+}
+
+void sim_advance_ms(uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; ++i) {
+        // spread any fractional ticks per ms so the long term rate is exact
+        uint32_t f = tmr0_running ? tmr0_frequency : 1000;
+        uint32_t n = f / 1000;
+        tick_remainder += f % 1000;
+        if(tick_remainder >= 1000) {
+            tick_remainder -= 1000;
+            ++n;
+        }
+        sim_run_ticks(n);
+
+        if(tmr1_handler != nullptr) {
+            tmr1_accumulator += tmr1_frequency;
+            while(tmr1_accumulator >= 1000) {
+                tmr1_accumulator -= 1000;
+                tmr1_handler();
+            }
+        }
+
+        sim_rtos_tick();
+    }
+}
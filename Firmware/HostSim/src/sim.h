@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+
+// Host simulation of the step timer and the RTOS clock.
+// There is only one thread of execution (the command thread), simulated time
+// only advances when it sleeps (vTaskDelay(), safe_sleep() etc), at which point
+// the TMR0 step and unstep handlers are called once per step tick exactly as
+// the ISRs would be on the target.
+
+// run the step timer for the given number of step ticks
+void sim_run_ticks(uint64_t n);
+// advance simulated time by the given number of milliseconds, this runs the
+// step timer, tmr1 and any active software timers
+void sim_advance_ms(uint32_t ms);
+
+// number of step ticks since the simulation started
+uint64_t sim_get_ticks();
+// step tick frequency as set by tmr0_setup(), 0 if it has not been started
+uint32_t sim_get_tick_frequency();
+
+// host time spent in the step and unstep handlers (and the tick hook if set),
+// in TSC cycles on x86 otherwise in ns, see sim_get_isr_units()
+uint64_t sim_get_isr_time();
+const char *sim_get_isr_units();
+
+// called once per simulated millisecond, advances the RTOS tick count, calls
+// vApplicationTickHook() and runs any expired software timers
+void sim_rtos_tick();
+
+// called after every step tick with the tick number, used to record traces
+void sim_set_tick_hook(std::function<void(uint64_t)> fnc);
@@ -0,0 +1,81 @@
+#include "PlanNodeQueue.h"
+
+#include "../Unity/src/unity.h"
+#include "TestRegistry.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+static void add_node(PlanNodeQueue& q, float max_entry_speed, float millimeters)
+{
+    PlanNode *n= q.get_head();
+    n->acceleration= 1000;
+    n->millimeters= millimeters;
+    n->max_entry_speed= max_entry_speed;
+    TEST_ASSERT_TRUE(q.queue_head());
+}
+
+REGISTER_TEST(PlanNodeQueue,basic)
+{
+    PlanNodeQueue q(10);
+    TEST_ASSERT_TRUE(q.empty());
+    TEST_ASSERT_TRUE(q.get_tail() == nullptr);
+    TEST_ASSERT_TRUE(q.get_last() == nullptr);
+    TEST_ASSERT_TRUE(isinf(q.tail_limit()));
+
+    // one is always kept free for the head
+    for (int i = 1; i <= 9; ++i) {
+        TEST_ASSERT_FALSE(q.full());
+        add_node(q, 10, 1);
+    }
+    TEST_ASSERT_TRUE(q.full());
+    TEST_ASSERT_EQUAL_INT(9, q.size());
+    TEST_ASSERT_FALSE(q.queue_head());
+
+    // potentials are the running sum of 2*acceleration*millimeters
+    TEST_ASSERT_EQUAL_FLOAT(0, q.get_tail()->potential);
+    TEST_ASSERT_EQUAL_FLOAT(2000, q.get_second()->potential);
+    TEST_ASSERT_EQUAL_FLOAT(16000, q.get_last()->potential);
+    TEST_ASSERT_EQUAL_FLOAT(18000, q.end_potential());
+
+    // all the junctions are the same so the first one is the tightest
+    TEST_ASSERT_EQUAL_FLOAT(100, q.tail_limit());
+    TEST_ASSERT_EQUAL_FLOAT(2100, q.second_limit());
+
+    for (int i = 1; i <= 9; ++i) {
+        q.release_tail();
+    }
+    TEST_ASSERT_TRUE(q.empty());
+
+    // restarts from zero once empty
+    add_node(q, 10, 1);
+    TEST_ASSERT_EQUAL_FLOAT(0, q.get_tail()->potential);
+    TEST_ASSERT_EQUAL_FLOAT(2000, q.end_potential());
+}
+
+// the incremental limits must be the same as searching all the nodes
+REGISTER_TEST(PlanNodeQueue,limits)
+{
+    PlanNodeQueue q(64);
+    std::vector<double> limits;
+
+    srand(1234);
+    for (int i = 0; i < 2000; ++i) {
+        if(!q.full() && (q.empty() || rand() % 3 != 0)) {
+            add_node(q, rand() % 200, (rand() % 100) / 50.0F);
+            limits.push_back(q.get_last()->limit());
+        } else {
+            q.release_tail();
+            limits.erase(limits.begin());
+        }
+
+        double tl= INFINITY, sl= INFINITY;
+        for (size_t j = 0; j < limits.size(); ++j) {
+            if(limits[j] < tl) tl= limits[j];
+            if(j > 0 && limits[j] < sl) sl= limits[j];
+        }
+        TEST_ASSERT_TRUE(tl == q.tail_limit());
+        TEST_ASSERT_TRUE(sl == q.second_limit());
+    }
+}
@@ -166,7 +166,7 @@ REGISTER_TEST(ADCTest, adc_class_interrupts)
 
     TEST_ASSERT_TRUE(Adc::start());
 
-    const uint32_t max_adc_value = Adc::get_max_value();
+    const uint32_t max_adc_value = adc->get_max_value();
     printf("Max ADC= %lu\n", max_adc_value);
 
     // give it time to accumulate the 32 samples
@@ -221,7 +221,7 @@ REGISTER_TEST(ADCTest, two_adc_channels)
 #endif
     TEST_ASSERT_TRUE(Adc::start());
 
-    const uint32_t max_adc_value = Adc::get_max_value();
+    const uint32_t max_adc_value = adc->get_max_value();
     printf("Max ADC= %lu\n", max_adc_value);
 
     // give it time to accumulate the 32 samples
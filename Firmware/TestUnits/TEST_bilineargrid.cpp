@@ -0,0 +1,55 @@
+#include "../Unity/src/unity.h"
+#include "TestRegistry.h"
+
+#include "BilinearGrid.h"
+
+#include <math.h>
+
+// the height at x, y from the four points around it
+static float direct(const float *grid, int nx, int ny, float x_start, float y_start, float x_size, float y_size, float x, float y)
+{
+    float gx = (std::min(std::max(x, std::min(x_start, x_start + x_size)), std::max(x_start, x_start + x_size)) - x_start) * (nx - 1) / x_size;
+    float gy = (std::min(std::max(y, std::min(y_start, y_start + y_size)), std::max(y_start, y_start + y_size)) - y_start) * (ny - 1) / y_size;
+    int ix = std::min((int)floorf(gx), nx - 2);
+    int iy = std::min((int)floorf(gy), ny - 2);
+    float u = gx - ix, v = gy - iy;
+    float left = (1 - v) * grid[ix + iy * nx] + v * grid[ix + (iy + 1) * nx];
+    float right = (1 - v) * grid[ix + 1 + iy * nx] + v * grid[ix + 1 + (iy + 1) * nx];
+    return (1 - u) * left + u * right;
+}
+
+REGISTER_TEST(BilinearGrid, matches_interpolation)
+{
+    const int nx = 5, ny = 4;
+    float grid[nx * ny];
+    for (int i = 0; i < nx * ny; ++i) grid[i] = sinf(i * 1.7F) * 0.3F;
+
+    BilinearGrid bg;
+    TEST_ASSERT_TRUE(bg.allocate(nx * ny));
+
+    // the second grid runs from the far corner back
+    const float grids[][4] = { {10, 20, 200, 150}, {210, 170, -200, -150} };
+    for (auto& g : grids) {
+        bg.set(grid, nx, ny, g[0], g[1], g[2], g[3]);
+
+        // on the grid points
+        for (int y = 0; y < ny; ++y) {
+            for (int x = 0; x < nx; ++x) {
+                float px = g[0] + x * g[2] / (nx - 1), py = g[1] + y * g[3] / (ny - 1);
+                TEST_ASSERT_FLOAT_WITHIN(0.001F, grid[x + y * nx], bg.get_z(px, py));
+            }
+        }
+
+        // across the grid and past its edges
+        for (float y = -10; y < 200; y += 3.3F) {
+            for (float x = -10; x < 240; x += 2.7F) {
+                TEST_ASSERT_FLOAT_WITHIN(0.001F, direct(grid, nx, ny, g[0], g[1], g[2], g[3], x, y), bg.get_z(x, y));
+            }
+        }
+    }
+
+    // a smaller grid fits in the cells allocated for the bigger one
+    bg.set(grid, 3, 3, 0, 0, 100, 100);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001F, (grid[0] + grid[1] + grid[3] + grid[4]) / 4, bg.get_z(25, 25));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001F, grid[8], bg.get_z(150, 150));
+}
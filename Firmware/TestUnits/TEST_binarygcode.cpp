@@ -0,0 +1,180 @@
+#include "GCode.h"
+#include "GCodeProcessor.h"
+#include "BinaryGCode.h"
+
+#include "../Unity/src/unity.h"
+#include "TestRegistry.h"
+
+#include <cstring>
+
+// the decoded gcode has to be exactly what the parser makes of the line
+static void check_same(const GCode& a, const GCode& b)
+{
+    TEST_ASSERT_TRUE(b.has_g());
+    TEST_ASSERT_EQUAL_INT(a.get_code(), b.get_code());
+    TEST_ASSERT_EQUAL_INT(a.get_num_args(), b.get_num_args());
+    for (auto& i : a.get_args()) {
+        TEST_ASSERT_TRUE(b.has_arg(i.first));
+        float f = b.get_arg(i.first);
+        TEST_ASSERT_TRUE(memcmp(&i.second, &f, sizeof(float)) == 0);
+    }
+}
+
+REGISTER_TEST(BinaryGCode, round_trip)
+{
+    const char *lines[] = {
+        "G1 X10 Y20 F3000", "G1 X10.5 Y19.999", "X-3.125 Y-0.001 S0.8", "G0 Z5", "G1 X0 Y0 E1.23456",
+        "G2 X10 Y10 I5 J-5", "G3 X0 Y0 I-5 J5 F1234.5", "G1 E1234.56789", "G1 X-16000.001", "G0 X0 Y0 Z0 E0",
+    };
+
+    GCodeProcessor gp;
+    BinaryGCode encoder, decoder;
+    for (auto l : lines) {
+        GCodeProcessor::GCodes_t gcodes;
+        TEST_ASSERT_TRUE(gp.parse(l, gcodes));
+        TEST_ASSERT_EQUAL_INT(1, gcodes.size());
+
+        uint8_t frame[BinaryGCode::MAX_FRAME];
+        size_t n = encoder.encode(gcodes[0], frame);
+        TEST_ASSERT_TRUE(n > 0);
+        TEST_ASSERT_TRUE(n <= BinaryGCode::MAX_FRAME);
+        TEST_ASSERT_EQUAL_INT(n, BinaryGCode::frame_size(frame[1]));
+        TEST_ASSERT_TRUE(BinaryGCode::check_frame(frame, n));
+
+        GCode gc;
+        TEST_ASSERT_TRUE(decoder.decode(&frame[2], frame[1], gc));
+        check_same(gcodes[0], gc);
+    }
+
+    // small moves are only a few bytes as only the difference is sent
+    GCodeProcessor::GCodes_t gcodes;
+    gp.parse("G1 X10 Y20", gcodes);
+    gp.parse("G1 X10.002 Y19.999", gcodes);
+    uint8_t frame[BinaryGCode::MAX_FRAME];
+    encoder.encode(gcodes[0], frame);
+    TEST_ASSERT_EQUAL_INT(8, encoder.encode(gcodes[1], frame));
+}
+
+REGISTER_TEST(BinaryGCode, stays_text)
+{
+    const char *lines[] = {
+        "M3 S1", "G28", "G1.1 X1", "G1 X1 A2", "G1 X1.0001", "G4 P10", "T1", "G1 X3000000",
+    };
+
+    GCodeProcessor gp;
+    BinaryGCode encoder;
+    for (auto l : lines) {
+        GCodeProcessor::GCodes_t gcodes;
+        gp.parse(l, gcodes);
+        uint8_t frame[BinaryGCode::MAX_FRAME];
+        TEST_ASSERT_EQUAL_INT(0, encoder.encode(gcodes.back(), frame));
+    }
+}
+
+REGISTER_TEST(BinaryGCode, bad_frames)
+{
+    GCodeProcessor gp;
+    GCodeProcessor::GCodes_t gcodes;
+    gp.parse("G1 X1 Y2", gcodes);
+
+    BinaryGCode encoder, decoder;
+    uint8_t frame[BinaryGCode::MAX_FRAME];
+    size_t n = encoder.encode(gcodes[0], frame);
+    TEST_ASSERT_TRUE(BinaryGCode::check_frame(frame, n));
+
+    // every single bit error is caught by the crc
+    for (size_t i = 1; i < n; ++i) {
+        for (int b = 0; b < 8; ++b) {
+            frame[i] ^= 1 << b;
+            TEST_ASSERT_FALSE(BinaryGCode::check_frame(frame, n));
+            frame[i] ^= 1 << b;
+        }
+    }
+    TEST_ASSERT_FALSE(BinaryGCode::check_frame(frame, n - 1));
+    TEST_ASSERT_EQUAL_INT(0, BinaryGCode::frame_size(BinaryGCode::MAX_PAYLOAD + 1));
+
+    // a payload that is cut short or has reserved flags set
+    GCode gc;
+    TEST_ASSERT_FALSE(decoder.decode(&frame[2], frame[1] - 1, gc));
+    TEST_ASSERT_TRUE(gc.has_error());
+    uint8_t p[] = {0x05, 0x00};
+    TEST_ASSERT_FALSE(decoder.decode(p, sizeof(p), gc));
+
+    // a failed record does not change the values the next one is relative to
+    TEST_ASSERT_TRUE(decoder.decode(&frame[2], frame[1], gc));
+    TEST_ASSERT_EQUAL_FLOAT(1, gc.get_arg('X'));
+    TEST_ASSERT_EQUAL_FLOAT(2, gc.get_arg('Y'));
+}
+
+REGISTER_TEST(BinaryGCode, reset)
+{
+    GCodeProcessor gp;
+    GCodeProcessor::GCodes_t gcodes;
+    BinaryGCode encoder, decoder;
+    uint8_t frame[BinaryGCode::MAX_FRAME];
+    GCode gc;
+
+    gp.parse("G1 X5", gcodes);
+    size_t n = encoder.encode(gcodes[0], frame);
+    TEST_ASSERT_TRUE(decoder.decode(&frame[2], frame[1], gc));
+
+    // a decoder that missed the first record gets out of step
+    BinaryGCode late;
+    gcodes.clear();
+    gp.parse("G1 X7", gcodes);
+    n = encoder.encode(gcodes[0], frame);
+    TEST_ASSERT_TRUE(late.decode(&frame[2], frame[1], gc));
+    TEST_ASSERT_EQUAL_FLOAT(2, gc.get_arg('X'));
+
+    // until the encoder is reset, its next record sets the values from 0
+    encoder.reset();
+    gcodes.clear();
+    gp.parse("G1 X9", gcodes);
+    n = encoder.encode(gcodes[0], frame);
+    TEST_ASSERT_TRUE(n > 0);
+    TEST_ASSERT_TRUE(late.decode(&frame[2], frame[1], gc));
+    TEST_ASSERT_EQUAL_FLOAT(9, gc.get_arg('X'));
+    TEST_ASSERT_TRUE(decoder.decode(&frame[2], frame[1], gc));
+    TEST_ASSERT_EQUAL_FLOAT(9, gc.get_arg('X'));
+
+    // the modal move is the last one decoded
+    TEST_ASSERT_EQUAL_INT(1, GCodeProcessor::get_group1_modal_code());
+}
+
+REGISTER_TEST(BinaryGCode, resync)
+{
+    GCodeProcessor gp;
+    GCodeProcessor::GCodes_t gcodes;
+    BinaryGCode encoder, decoder;
+    uint8_t frame[BinaryGCode::MAX_FRAME];
+    GCode gc;
+
+    gp.parse("G1 X5", gcodes);
+    encoder.encode(gcodes[0], frame);
+    TEST_ASSERT_TRUE(decoder.decode(&frame[2], frame[1], gc));
+
+    // a record was lost (eg it failed its crc), the next ones are rejected as they are relative to it
+    decoder.desync();
+    TEST_ASSERT_FALSE(decoder.is_synced());
+    gcodes.clear();
+    gp.parse("G1 X7", gcodes);
+    encoder.encode(gcodes[0], frame);
+    TEST_ASSERT_FALSE(decoder.decode(&frame[2], frame[1], gc));
+    TEST_ASSERT_TRUE(gc.has_error());
+
+    // until the host sends a reset record
+    encoder.reset();
+    gcodes.clear();
+    gp.parse("G1 X9 Y1", gcodes);
+    encoder.encode(gcodes[0], frame);
+    TEST_ASSERT_TRUE(decoder.decode(&frame[2], frame[1], gc));
+    TEST_ASSERT_TRUE(decoder.is_synced());
+    TEST_ASSERT_EQUAL_FLOAT(9, gc.get_arg('X'));
+    TEST_ASSERT_EQUAL_FLOAT(1, gc.get_arg('Y'));
+
+    gcodes.clear();
+    gp.parse("G1 X10", gcodes);
+    encoder.encode(gcodes[0], frame);
+    TEST_ASSERT_TRUE(decoder.decode(&frame[2], frame[1], gc));
+    TEST_ASSERT_EQUAL_FLOAT(10, gc.get_arg('X'));
+}
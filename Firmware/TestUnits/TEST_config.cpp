@@ -178,6 +178,44 @@ REGISTER_TEST(ConfigTest, test_spaces_around_kv)
     TEST_ASSERT_EQUAL_INT(4, cr2.get_int(m2, "four", -1));
 }
 
+REGISTER_TEST(ConfigTest, indexed_sections)
+{
+    // the file is read once, a repeated header only continues the section when it follows itself
+    std::stringstream ss("[a]\none=1\n[a]\ntwo=2\n[b]\np.x=3\np.y = 4 # comment\nq=5\n[a]\nthree=3\n");
+    ConfigReader cr(ss);
+
+    ConfigReader::section_map_t m;
+    TEST_ASSERT_TRUE(cr.get_section("a", m));
+    TEST_ASSERT_EQUAL_INT(2, m.size());
+    TEST_ASSERT_EQUAL_INT(1, cr.get_int(m, "one", -1));
+    TEST_ASSERT_EQUAL_INT(2, cr.get_int(m, "two", -1));
+
+    // sections can be asked for in any order and more than once
+    ConfigReader::sub_section_map_t ssmap;
+    TEST_ASSERT_TRUE(cr.get_sub_sections("b", ssmap));
+    TEST_ASSERT_EQUAL_INT(1, ssmap.size());
+    TEST_ASSERT_EQUAL_INT(2, ssmap["p"].size());
+    TEST_ASSERT_EQUAL_INT(4, cr.get_int(ssmap["p"], "y", -1));
+
+    m.clear();
+    TEST_ASSERT_TRUE(cr.get_section("b", m));
+    TEST_ASSERT_EQUAL_INT(3, m.size());
+    TEST_ASSERT_EQUAL_INT(3, cr.get_int(m, "p.x", -1));
+    TEST_ASSERT_EQUAL_INT(5, cr.get_int(m, "q", -1));
+
+    m.clear();
+    TEST_ASSERT_TRUE(cr.get_section("a", m));
+    TEST_ASSERT_EQUAL_INT(2, m.size());
+
+    // the stream is not read again unless asked to
+    ss.str("[c]\nfour=4\n");
+    m.clear();
+    TEST_ASSERT_FALSE(cr.get_section("c", m));
+    cr.reindex();
+    TEST_ASSERT_TRUE(cr.get_section("c", m));
+    TEST_ASSERT_EQUAL_INT(4, cr.get_int(m, "four", -1));
+}
+
 REGISTER_TEST(ConfigTest, write_no_change)
 {
     std::istringstream iss(str);
@@ -105,3 +105,79 @@ REGISTER_TESTF(Dispatcher, one_off_dispatch)
     TEST_ASSERT_EQUAL_INT(-789, args['Y']);
     TEST_ASSERT_EQUAL_INT(123, args['Z']);
 }
+
+REGISTER_TESTF(Dispatcher, dispatch_tables)
+{
+    // the tables must call the same handlers in the same order as the multimap
+    int order= 0;
+    THEDISPATCHER->add_handler(Dispatcher::MCODE_HANDLER, 911, [&order](GCode& gc, OutputStream& os) { order= order * 10 + 1; return true; });
+    THEDISPATCHER->add_handler(Dispatcher::MCODE_HANDLER, 911, [&order](GCode& gc, OutputStream& os) { order= order * 10 + 2; return true; });
+    TEST_ASSERT_TRUE(THEDISPATCHER->build_dispatch_tables());
+
+    OutputStream os;
+    TEST_ASSERT_TRUE(THEDISPATCHER->dispatch(gcodes[0], os));
+    TEST_ASSERT_TRUE(cb1);
+    TEST_ASSERT_TRUE(cb3);
+    TEST_ASSERT_TRUE(THEDISPATCHER->dispatch(gcodes[1], os));
+    TEST_ASSERT_TRUE(cb2);
+    TEST_ASSERT_FALSE(THEDISPATCHER->dispatch(gcodes[2], os));
+    TEST_ASSERT_TRUE(THEDISPATCHER->dispatch(os, 'M', 911, 0));
+    TEST_ASSERT_EQUAL_INT(12, order);
+    TEST_ASSERT_FALSE(THEDISPATCHER->dispatch(os, 'M', 912, 0));
+
+    // removing a handler after they are built rebuilds the tables
+    cb1= cb3= false;
+    THEDISPATCHER->remove_handler(Dispatcher::GCODE_HANDLER, h3);
+    TEST_ASSERT_TRUE(THEDISPATCHER->dispatch(gcodes[0], os));
+    TEST_ASSERT_TRUE(cb1);
+    TEST_ASSERT_FALSE(cb3);
+}
+
+static int motion_count;
+static bool motion_handler(GCode& gc, OutputStream& os) { ++motion_count; return true; }
+
+#include "stopwatch.h"
+
+// times dispatching G1 through the multimap, the flat tables and the motion fast path
+// with roughly the number of handlers a configured system has registered
+REGISTER_TESTF(Dispatcher, dispatch_benchmark)
+{
+    int count= 0;
+    auto fnc= [&count](GCode& gc, OutputStream& os) { ++count; return true; };
+    THEDISPATCHER->clear_handlers();
+    for (int i = 4; i < 100; i += 3) THEDISPATCHER->add_handler(Dispatcher::GCODE_HANDLER, i, fnc);
+    for (int i = 0; i < 1000; i += 12) THEDISPATCHER->add_handler(Dispatcher::MCODE_HANDLER, i, fnc);
+    THEDISPATCHER->add_handler(Dispatcher::GCODE_HANDLER, 1, fnc);
+
+    gcodes.clear();
+    TEST_ASSERT_TRUE(gp.parse("G1 X10.5 Y-20.25 F3000", gcodes));
+    GCode& g1= gcodes[0];
+    OutputStream os;
+    const int n= 10000;
+
+    StopWatch_Init();
+    uint32_t st= StopWatch_Start();
+    for (int i = 0; i < n; ++i) THEDISPATCHER->dispatch(g1, os, false);
+    uint32_t multimap_us= StopWatch_TicksToUs(StopWatch_Elapsed(st));
+    TEST_ASSERT_EQUAL_INT(n, count);
+
+    TEST_ASSERT_TRUE(THEDISPATCHER->build_dispatch_tables());
+    st= StopWatch_Start();
+    for (int i = 0; i < n; ++i) THEDISPATCHER->dispatch(g1, os, false);
+    uint32_t table_us= StopWatch_TicksToUs(StopWatch_Elapsed(st));
+    TEST_ASSERT_EQUAL_INT(2 * n, count);
+
+    // G1 goes to the motion handler only
+    THEDISPATCHER->clear_handlers();
+    for (int i = 4; i < 100; i += 3) THEDISPATCHER->add_handler(Dispatcher::GCODE_HANDLER, i, fnc);
+    for (int i = 0; i < 1000; i += 12) THEDISPATCHER->add_handler(Dispatcher::MCODE_HANDLER, i, fnc);
+    THEDISPATCHER->set_motion_handler(motion_handler);
+    TEST_ASSERT_TRUE(THEDISPATCHER->build_dispatch_tables());
+    motion_count= 0;
+    st= StopWatch_Start();
+    for (int i = 0; i < n; ++i) THEDISPATCHER->dispatch(g1, os, false);
+    uint32_t motion_us= StopWatch_TicksToUs(StopWatch_Elapsed(st));
+    TEST_ASSERT_EQUAL_INT(n, motion_count);
+
+    printf("%d G1 dispatches: multimap %lu us, tables %lu us, motion handler %lu us\n", n, multimap_us, table_us, motion_us);
+}
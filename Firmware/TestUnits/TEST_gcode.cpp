@@ -6,6 +6,8 @@
 #include "TestRegistry.h"
 
 #include <cstring>
+#include <map>
+#include <string>
 
 REGISTER_TEST(GCodeTest,basic)
 {
@@ -277,3 +279,86 @@ REGISTER_TEST(GCodeTest, nist_float_limits) {
     TEST_ASSERT_FLOAT_WITHIN(0.000000001, 1.12345678, f);
     TEST_ASSERT_TRUE(np == &p[24]);
 }
+
+REGISTER_TEST(GCodeTest, args_iteration) {
+    GCodeProcessor gp;
+    GCodeProcessor::GCodes_t gca;
+
+    bool ok= gp.parse("G1 Z3 X1 E5 Y2", gca);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL_INT(1, gca.size());
+
+    // iterates in letter order like the map did
+    const char *letters= "EXYZ";
+    float values[]= {5, 1, 2, 3};
+    int n= 0;
+    for(auto& i : gca[0].get_args()) {
+        TEST_ASSERT_EQUAL_INT(letters[n], i.first);
+        TEST_ASSERT_EQUAL_FLOAT(values[n], i.second);
+        ++n;
+    }
+    TEST_ASSERT_EQUAL_INT(4, n);
+
+    // can still be copied into a map, as M305 and M665 do
+    std::map<char, float> m(gca[0].get_args().begin(), gca[0].get_args().end());
+    TEST_ASSERT_EQUAL_INT(4, m.size());
+    TEST_ASSERT_EQUAL_FLOAT(3, m['Z']);
+
+    GCode::Args_t args= gca[0].get_args();
+    args.erase('X');
+    TEST_ASSERT_EQUAL_INT(3, args.size());
+    TEST_ASSERT_EQUAL_INT(0, args.count('X'));
+    TEST_ASSERT_EQUAL_INT(4, gca[0].get_num_args());
+
+    // the values after it move down
+    TEST_ASSERT_EQUAL_FLOAT(5, args.at('E'));
+    TEST_ASSERT_EQUAL_FLOAT(2, args.at('Y'));
+    TEST_ASSERT_EQUAL_FLOAT(3, args.at('Z'));
+    args['A']= 7;
+    TEST_ASSERT_EQUAL_INT(4, args.size());
+    TEST_ASSERT_EQUAL_INT('A', args.begin()->first);
+    TEST_ASSERT_EQUAL_FLOAT(7, args.at('A'));
+    TEST_ASSERT_EQUAL_FLOAT(5, args.at('E'));
+    TEST_ASSERT_EQUAL_FLOAT(3, args.at('Z'));
+}
+
+REGISTER_TEST(GCodeTest, too_many_args) {
+    GCodeProcessor gp;
+    GCodeProcessor::GCodes_t gcodes;
+
+    // only the letters given are held, so a gcode is smaller than a value for every letter would be
+    TEST_ASSERT_TRUE(sizeof(GCode) < 26 * sizeof(float));
+
+    const char *letters= "ABCDEFHIJKLPQRSUVWXYZ";
+    std::string line("G1");
+    for (size_t i = 0; i < GCode::MAX_ARGS; ++i) {
+        line.append(" ");
+        line.push_back(letters[i]);
+        line.append("1");
+    }
+    bool ok= gp.parse(line.c_str(), gcodes);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL_INT(GCode::MAX_ARGS, gcodes[0].get_num_args());
+
+    line.append(" ");
+    line.push_back(letters[GCode::MAX_ARGS]);
+    line.append("1");
+    gcodes.clear();
+    ok= gp.parse(line.c_str(), gcodes);
+    TEST_ASSERT_FALSE(ok);
+    TEST_ASSERT_TRUE(gcodes.back().has_error());
+}
+
+REGISTER_TEST(GCodeTest, too_many_commands_on_line) {
+    GCodeProcessor gp;
+    GCodeProcessor::GCodes_t gcodes;
+
+    std::string line;
+    for (size_t i = 0; i <= GCodeProcessor::MAX_GCODES_PER_LINE; ++i) {
+        line.append("M1 ");
+    }
+    bool ok= gp.parse(line.c_str(), gcodes);
+    TEST_ASSERT_FALSE(ok);
+    TEST_ASSERT_EQUAL_INT(GCodeProcessor::MAX_GCODES_PER_LINE, gcodes.size());
+    TEST_ASSERT_TRUE(gcodes.back().has_error());
+}
@@ -0,0 +1,207 @@
+#include "../Unity/src/unity.h"
+#include "TestRegistry.h"
+
+#include "LineQueue.h"
+#include "OutputStream.h"
+#include "MemoryPool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+REGISTER_TEST(LineQueue, channels)
+{
+    LineQueue q(2, 4);
+    TEST_ASSERT_EQUAL_INT(0, q.add_channel());
+    TEST_ASSERT_EQUAL_INT(1, q.add_channel());
+    TEST_ASSERT_EQUAL_INT(-1, q.add_channel());
+
+    TEST_ASSERT_EQUAL_INT(4, q.space(0));
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_TRUE(q.send(0, "G1 X1", nullptr, false));
+    }
+    TEST_ASSERT_FALSE(q.send(0, "G1 X1", nullptr, false));
+    TEST_ASSERT_EQUAL_INT(0, q.space(0));
+    TEST_ASSERT_EQUAL_INT(4, q.space(1));
+
+    // a received line still takes up room until it is released
+    char *line;
+    OutputStream *os;
+    TEST_ASSERT_TRUE(q.receive(&line, &os));
+    TEST_ASSERT_FALSE(q.send(0, "G1 X1", nullptr, false));
+    TEST_ASSERT_EQUAL_INT(0, q.release());
+    TEST_ASSERT_TRUE(q.send(0, "G1 X1", nullptr, false));
+    TEST_ASSERT_EQUAL_INT(-1, q.release());
+}
+
+// command_queue_size can be up to 255 lines, one more than that are in each ring
+REGISTER_TEST(LineQueue, largest_channel)
+{
+    LineQueue q(2, 255);
+    TEST_ASSERT_EQUAL_INT(0, q.add_channel());
+    TEST_ASSERT_EQUAL_INT(255, q.space(0));
+
+    char buf[32];
+    for (int i = 0; i < 255; ++i) {
+        snprintf(buf, sizeof(buf), "G1 X%d", i);
+        TEST_ASSERT_TRUE(q.send(0, buf, nullptr, false));
+    }
+    TEST_ASSERT_FALSE(q.send(0, "G1 X1", nullptr, false));
+    TEST_ASSERT_EQUAL_INT(0, q.space(0));
+
+    // and it goes round more than once
+    char *line;
+    OutputStream *os;
+    for (int i = 0; i < 600; ++i) {
+        TEST_ASSERT_TRUE(q.receive(&line, &os));
+        snprintf(buf, sizeof(buf), "G1 X%d", i);
+        TEST_ASSERT_EQUAL_STRING(buf, line);
+        TEST_ASSERT_EQUAL_INT(0, q.release());
+        snprintf(buf, sizeof(buf), "G1 X%d", i + 255);
+        TEST_ASSERT_TRUE(q.send(0, buf, nullptr, false));
+    }
+    TEST_ASSERT_EQUAL_INT(0, q.space(0));
+}
+
+REGISTER_TEST(LineQueue, rings_in_pool)
+{
+    // the first ring fits in the pool, the second goes on the heap
+    static uint8_t mem[1024];
+    MemoryPool pool(mem, sizeof(mem));
+    uint32_t before = pool.available();
+    {
+        LineQueue q(2, 4, &pool);
+        TEST_ASSERT_EQUAL_INT(0, q.add_channel());
+        TEST_ASSERT_TRUE(pool.available() < before);
+        uint32_t one = pool.available();
+        TEST_ASSERT_EQUAL_INT(1, q.add_channel());
+        TEST_ASSERT_EQUAL_INT(one, pool.available());
+        TEST_ASSERT_TRUE(q.send(1, "G1 X1", nullptr, false));
+    }
+    TEST_ASSERT_EQUAL_INT(before, pool.available());
+}
+
+REGISTER_TEST(LineQueue, round_robin)
+{
+    LineQueue q(3, 8);
+    OutputStream osa, osb;
+    int a = q.add_channel();
+    int b = q.add_channel();
+
+    // a is streaming a file and has filled its channel before b sends anything
+    char buf[32];
+    for (int i = 0; i < 8; ++i) {
+        snprintf(buf, sizeof(buf), "A%d", i);
+        TEST_ASSERT_TRUE(q.send(a, buf, &osa, false));
+    }
+    TEST_ASSERT_TRUE(q.send(b, "B0", &osb, false));
+    TEST_ASSERT_TRUE(q.send(b, "B1", &osb, false));
+
+    const char *expect[] = {"A0", "B0", "A1", "B1", "A2", "A3"};
+    for (auto e : expect) {
+        char *line;
+        OutputStream *os;
+        TEST_ASSERT_TRUE(q.receive(&line, &os));
+        TEST_ASSERT_EQUAL_STRING(e, line);
+        TEST_ASSERT_TRUE(os == (line[0] == 'A' ? &osa : &osb));
+        q.release();
+    }
+}
+
+REGISTER_TEST(LineQueue, priority)
+{
+    LineQueue q(3, 8);
+    int a = q.add_channel();
+    int b = q.add_channel();
+    int c = q.add_channel();
+
+    TEST_ASSERT_TRUE(q.send(a, "G1 X1", nullptr, false));
+    TEST_ASSERT_TRUE(q.send(a, "G1 X2", nullptr, false));
+    TEST_ASSERT_TRUE(q.send(b, "G1 Y1", nullptr, false));
+    TEST_ASSERT_TRUE(q.send(c, "$J X1", nullptr, true));
+
+    // the jog goes first, then the others in turn
+    const char *expect[] = {"$J X1", "G1 X1", "G1 Y1", "G1 X2"};
+    for (auto e : expect) {
+        char *line;
+        OutputStream *os;
+        TEST_ASSERT_TRUE(q.receive(&line, &os));
+        TEST_ASSERT_EQUAL_STRING(e, line);
+        q.release();
+    }
+
+    // a priority line does not jump ahead of the lines already sent on its own channel
+    TEST_ASSERT_TRUE(q.send(a, "G1 X3", nullptr, false));
+    TEST_ASSERT_TRUE(q.send(a, "$J X2", nullptr, true));
+    TEST_ASSERT_TRUE(q.send(b, "G1 Y2", nullptr, false));
+    char *line;
+    OutputStream *os;
+    TEST_ASSERT_TRUE(q.receive(&line, &os));
+    TEST_ASSERT_EQUAL_STRING("G1 Y2", line);
+    TEST_ASSERT_TRUE(q.receive(&line, &os));
+    TEST_ASSERT_EQUAL_STRING("G1 X3", line);
+    TEST_ASSERT_TRUE(q.receive(&line, &os));
+    TEST_ASSERT_EQUAL_STRING("$J X2", line);
+    TEST_ASSERT_FALSE(q.receive(&line, &os));
+}
+
+// producers that send numbered lines at random times into a consumer that holds a few lines
+// before releasing them, as the command thread does when it parses ahead
+REGISTER_TEST(LineQueue, simulated_producers)
+{
+    const int nproducers = 4, nlines = 500, max_held = 3;
+    LineQueue q(nproducers, 5);
+    int ch[nproducers], sent[nproducers], received[nproducers];
+    for (int i = 0; i < nproducers; ++i) {
+        ch[i] = q.add_channel();
+        sent[i] = received[i] = 0;
+    }
+
+    char *held[max_held];
+    int nheld = 0, total = 0, bulk_run = 0, max_bulk_run = 0;
+    srand(1234);
+    while(total < nproducers * nlines) {
+        int r = rand() % 10;
+        if(r < 6) {
+            // producer 0 always has a line ready, the others only sometimes
+            int p = (r < 3) ? 0 : rand() % nproducers;
+            if(sent[p] < nlines) {
+                char buf[32];
+                snprintf(buf, sizeof(buf), "P%d N%d", p, sent[p]);
+                if(q.send(ch[p], buf, nullptr, false)) ++sent[p];
+            }
+
+        } else if(nheld < max_held) {
+            char *line;
+            OutputStream *os;
+            if(q.receive(&line, &os)) {
+                int p, n;
+                TEST_ASSERT_EQUAL_INT(2, sscanf(line, "P%d N%d", &p, &n));
+                TEST_ASSERT_EQUAL_INT(received[p], n);
+                ++received[p];
+                ++total;
+                held[nheld++] = line;
+
+                // the busy producer never gets more than one line in a row while another has one waiting
+                bulk_run = (p == 0) ? bulk_run + 1 : 0;
+                bool others = false;
+                for (int i = 1; i < nproducers; ++i) {
+                    if(received[i] < sent[i]) others = true;
+                }
+                if(others && bulk_run > max_bulk_run) max_bulk_run = bulk_run;
+            }
+
+        } else {
+            // the held lines are still intact when they are released
+            int p, n;
+            TEST_ASSERT_EQUAL_INT(2, sscanf(held[0], "P%d N%d", &p, &n));
+            q.release();
+            memmove(&held[0], &held[1], sizeof(char*) * --nheld);
+        }
+    }
+
+    for (int i = 0; i < nproducers; ++i) {
+        TEST_ASSERT_EQUAL_INT(nlines, received[i]);
+    }
+    TEST_ASSERT_TRUE(max_bulk_run <= 1);
+}
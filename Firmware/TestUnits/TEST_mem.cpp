@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <malloc.h>
 #include <iostream>
+#include <string.h>
 
 #include "board.h"
 
@@ -113,6 +114,86 @@ REGISTER_TEST(MemoryTest, memory_pool)
     _RAM2->debug(os);
 }
 
+REGISTER_TEST(MemoryTest, pool_stats)
+{
+    static uint8_t buf[1024] __attribute__ ((aligned (4)));
+    MemoryPool pool(buf, sizeof(buf));
+
+    // only addresses in a pool are found
+    TEST_ASSERT_TRUE(MemoryPool::find(&buf[0]) == &pool);
+    TEST_ASSERT_TRUE(MemoryPool::find(&buf[1023]) == &pool);
+    TEST_ASSERT_NULL(MemoryPool::find(&buf[1024]));
+    int i;
+    TEST_ASSERT_NULL(MemoryPool::find(&i));
+
+    void *a= pool.alloc(100);
+    void *b= pool.alloc(200);
+    void *c= pool.alloc(100);
+    TEST_ASSERT_NOT_NULL(a); TEST_ASSERT_NOT_NULL(b); TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_EQUAL_INT(100+200+100+12, pool.get_max_used());
+
+    // freeing b leaves a hole so the free memory is in two blocks
+    pool.dealloc(b);
+    TEST_ASSERT_EQUAL_INT(1024-100-100-8, pool.available());
+    TEST_ASSERT_EQUAL_INT(1024-100-200-100-12, pool.largest_free());
+    TEST_ASSERT_EQUAL_INT(100+200+100+12, pool.get_max_used());
+
+    TEST_ASSERT_NULL(pool.alloc(1000));
+    TEST_ASSERT_EQUAL_INT(1, pool.get_failed());
+
+    pool.dealloc(a);
+    pool.dealloc(c);
+    TEST_ASSERT_EQUAL_INT(1024, pool.available());
+    TEST_ASSERT_EQUAL_INT(1024, pool.largest_free());
+}
+
+#include "SlabAllocator.h"
+REGISTER_TEST(MemoryTest, slab_allocator)
+{
+    static uint8_t buf[4096];
+    SlabAllocator slab(buf, sizeof(buf));
+
+    // too big for a slab
+    TEST_ASSERT_NULL(slab.alloc(SlabAllocator::max_size + 1));
+
+    void *p[8];
+    size_t sizes[8]= {1, 8, 9, 24, 33, 64, 100, 128};
+    for (int i = 0; i < 8; ++i) {
+        p[i]= slab.alloc(sizes[i]);
+        TEST_ASSERT_NOT_NULL(p[i]);
+        TEST_ASSERT_TRUE(slab.has(p[i]));
+        TEST_ASSERT_EQUAL_INT(0, (uintptr_t)p[i] & 7);
+        memset(p[i], i, sizes[i]);
+    }
+
+    // nothing was overwritten
+    for (int i = 0; i < 8; ++i) {
+        for (size_t j = 0; j < sizes[i]; ++j) {
+            TEST_ASSERT_EQUAL_INT(i, ((uint8_t*)p[i])[j]);
+        }
+    }
+
+    // a freed block is the next one given out of its size class
+    slab.dealloc(p[4]);
+    TEST_ASSERT_TRUE(slab.alloc(40) == p[4]);
+
+    for (int i = 0; i < 8; ++i) {
+        slab.dealloc(p[i]);
+    }
+
+    int i;
+    TEST_ASSERT_FALSE(slab.has(&i));
+
+    // the pages run out, then allocations fail and the caller uses malloc
+    int n= 0;
+    while(slab.alloc(128) != nullptr) ++n;
+    TEST_ASSERT_TRUE(n > 0 && n < 4096/128);
+    TEST_ASSERT_NULL(slab.alloc(100));
+
+    OutputStream os(&std::cout);
+    slab.debug(os);
+}
+
 #define _ramfunc_ __attribute__ ((section(".ramfunctions"),long_call,noinline))
 _ramfunc_ int testramfunc() { return 123; }
 REGISTER_TEST(MemoryTest, ramfunc)
@@ -0,0 +1,107 @@
+#include "../Unity/src/unity.h"
+#include "TestRegistry.h"
+
+#include "RasterBuffer.h"
+
+#include <string.h>
+
+static void fill(uint8_t *p, size_t n, uint8_t v)
+{
+    for (size_t i = 0; i < n; ++i) p[i] = v + i;
+}
+
+// the line is held as 16 bit values
+static void check_line(const uint8_t *px, const uint16_t *l, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) TEST_ASSERT_EQUAL_INT(px[i], l[i]);
+}
+
+REGISTER_TEST(RasterBuffer, lines_in_order)
+{
+    RasterBuffer rb(100);
+    TEST_ASSERT_TRUE(rb.is_valid());
+    TEST_ASSERT_EQUAL_PTR(&rb, RasterBuffer::getInstance());
+
+    uint16_t n;
+    TEST_ASSERT_NULL(rb.take(n, 0));
+    TEST_ASSERT_EQUAL_INT(0, n);
+
+    // a line can be added in pieces
+    uint8_t px[40];
+    fill(px, 40, 0);
+    TEST_ASSERT_TRUE(rb.add(px, 20));
+    TEST_ASSERT_TRUE(rb.add(&px[20], 20));
+    TEST_ASSERT_EQUAL_INT(40, rb.pending());
+    const uint16_t *l1 = rb.take(n, 0);
+    TEST_ASSERT_EQUAL_INT(40, n);
+    check_line(px, l1, 40);
+    TEST_ASSERT_EQUAL_INT(0, rb.pending());
+
+    uint8_t px2[50];
+    fill(px2, 50, 100);
+    TEST_ASSERT_TRUE(rb.add(px2, 50));
+    const uint16_t *l2 = rb.take(n, 0);
+    TEST_ASSERT_EQUAL_INT(50, n);
+    check_line(px2, l2, 50);
+
+    // no room at the end or the start until the first line is released
+    TEST_ASSERT_FALSE(rb.add(px, 20));
+    rb.release(l1 + 40);
+
+    // the line goes to the start of the buffer and stays contiguous
+    TEST_ASSERT_TRUE(rb.add(px, 20));
+    TEST_ASSERT_TRUE(rb.add(&px[20], 10));
+    const uint16_t *l3 = rb.take(n, 0);
+    TEST_ASSERT_EQUAL_INT(30, n);
+    TEST_ASSERT_TRUE(l3 + n <= l2);
+    check_line(px, l3, 30);
+
+    // the free space is now between the third and second lines
+    TEST_ASSERT_FALSE(rb.add(px, 10));
+    TEST_ASSERT_TRUE(rb.add(px, 9));
+    rb.release(l2 + 50);
+    rb.release(l3 + 30);
+    TEST_ASSERT_EQUAL_INT(9, rb.pending());
+}
+
+REGISTER_TEST(RasterBuffer, reset_when_idle)
+{
+    RasterBuffer rb(100);
+    uint8_t px[60];
+    fill(px, 60, 7);
+
+    uint16_t n;
+    TEST_ASSERT_TRUE(rb.add(px, 60));
+    const uint16_t *l1 = rb.take(n, 0);
+    rb.release(l1 + 60);
+
+    // with nothing in use there is room for a whole buffer, but only once it is reset
+    TEST_ASSERT_TRUE(rb.add(px, 30));
+    TEST_ASSERT_FALSE(rb.add(&px[30], 30));
+    rb.reset();
+    TEST_ASSERT_TRUE(rb.add(&px[30], 30));
+    const uint16_t *l2 = rb.take(n, 0);
+    TEST_ASSERT_EQUAL_INT(60, n);
+    check_line(px, l2, 60);
+}
+
+REGISTER_TEST(RasterBuffer, prepare_when_taken)
+{
+    RasterBuffer rb(100);
+    uint8_t px[10];
+    fill(px, 10, 0);
+
+    // the line is converted in place with the S value of the move that takes it
+    uint16_t s_seen = 0;
+    rb.prepare_fnc = [&s_seen](uint16_t *line, size_t n, uint16_t s_value) {
+        s_seen = s_value;
+        for (size_t i = 0; i < n; ++i) line[i] = line[i] * 1000;
+    };
+
+    uint16_t n;
+    TEST_ASSERT_TRUE(rb.add(px, 10));
+    const uint16_t *l = rb.take(n, 1 << 11);
+    TEST_ASSERT_EQUAL_INT(10, n);
+    TEST_ASSERT_EQUAL_INT(1 << 11, s_seen);
+    for (size_t i = 0; i < n; ++i) TEST_ASSERT_EQUAL_INT(i * 1000, l[i]);
+}
@@ -0,0 +1,67 @@
+#include "../Unity/src/unity.h"
+#include "TestRegistry.h"
+
+#include "StepPins.h"
+#include "Pin.h"
+
+#include <string.h>
+
+// StepPins writes to a GPIO block in memory so no real pins are changed
+REGISTER_TEST(StepPins, masks)
+{
+    LPC_GPIO_T gpio;
+    memset((void*)&gpio, 0, sizeof(gpio));
+    StepPins sp(&gpio);
+
+    Pin p0("GPIO1[4]");
+    Pin p1("GPIO1[5]!");
+    Pin p2("GPIO5[6]");
+    Pin p3("GPIO1[6]o");
+    Pin nc;
+    TEST_ASSERT_TRUE(p0.connected() && p1.connected() && p2.connected() && p3.connected());
+
+    TEST_ASSERT_TRUE(sp.add(0, p0));
+    TEST_ASSERT_TRUE(sp.add(1, p1));
+    TEST_ASSERT_TRUE(sp.add(2, p2));
+    TEST_ASSERT_EQUAL_INT(2, sp.get_num_ports());
+
+    // open drain and unconnected pins have to be set by the motor
+    TEST_ASSERT_FALSE(sp.add(3, p3));
+    TEST_ASSERT_FALSE(sp.add(3, nc));
+
+    // one SET and one CLR per port, the inverted pin is cleared to step
+    sp.step(0b111);
+    TEST_ASSERT_EQUAL_HEX32(1<<4, gpio.SET[1]);
+    TEST_ASSERT_EQUAL_HEX32(1<<5, gpio.CLR[1]);
+    TEST_ASSERT_EQUAL_HEX32(1<<6, gpio.SET[5]);
+    TEST_ASSERT_EQUAL_HEX32(0, gpio.CLR[5]);
+
+    memset((void*)&gpio, 0, sizeof(gpio));
+    sp.unstep(0b111);
+    TEST_ASSERT_EQUAL_HEX32(1<<5, gpio.SET[1]);
+    TEST_ASSERT_EQUAL_HEX32(1<<4, gpio.CLR[1]);
+    TEST_ASSERT_EQUAL_HEX32(0, gpio.SET[5]);
+    TEST_ASSERT_EQUAL_HEX32(1<<6, gpio.CLR[5]);
+
+    // only the ports of the motors that stepped are written
+    memset((void*)&gpio, 0, sizeof(gpio));
+    sp.step(0b100);
+    TEST_ASSERT_EQUAL_HEX32(0, gpio.SET[1]);
+    TEST_ASSERT_EQUAL_HEX32(0, gpio.CLR[1]);
+    TEST_ASSERT_EQUAL_HEX32(1<<6, gpio.SET[5]);
+
+    memset((void*)&gpio, 0, sizeof(gpio));
+    sp.step(0);
+    for (int i = 0; i < 8; ++i) {
+        TEST_ASSERT_EQUAL_HEX32(0, gpio.SET[i]);
+        TEST_ASSERT_EQUAL_HEX32(0, gpio.CLR[i]);
+    }
+
+    // re-adding a pin with the other polarity updates the polarity mask
+    p0.set_inverting(true);
+    TEST_ASSERT_TRUE(sp.add(0, p0));
+    memset((void*)&gpio, 0, sizeof(gpio));
+    sp.step(0b011);
+    TEST_ASSERT_EQUAL_HEX32(0, gpio.SET[1]);
+    TEST_ASSERT_EQUAL_HEX32((1<<4)|(1<<5), gpio.CLR[1]);
+}
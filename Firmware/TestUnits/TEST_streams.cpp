@@ -145,3 +145,77 @@ REGISTER_TEST(StreamsTest, OutputStream_long_line)
 	TEST_ASSERT_EQUAL_STRING("12345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890", oss.str().c_str());
 }
 
+
+static std::vector<std::string> writes;
+static int record_write_fnc(const char *buf, size_t len)
+{
+	writes.push_back(std::string(buf, len));
+	return len;
+}
+
+REGISTER_TEST(StreamsTest, OutputStream_buffered)
+{
+	writes.clear();
+	OutputStream os(record_write_fnc);
+	TEST_ASSERT_TRUE(os.set_buffered(16, 1000));
+	TEST_ASSERT_TRUE(os.is_buffered());
+
+	// held until flushed
+	os.puts("ok\n");
+	os.puts("ok\n");
+	os.printf("ok %d\n", 1);
+	TEST_ASSERT_TRUE(writes.empty());
+	TEST_ASSERT_TRUE(os.has_buffered_output());
+	os.flush_if_due();
+	TEST_ASSERT_TRUE(writes.empty());
+	os.flush();
+	TEST_ASSERT_EQUAL_INT(1, writes.size());
+	TEST_ASSERT_EQUAL_STRING("ok\nok\nok 1\n", writes[0].c_str());
+	TEST_ASSERT_FALSE(os.has_buffered_output());
+	os.flush();
+	TEST_ASSERT_EQUAL_INT(1, writes.size());
+
+	// written when it would not fit, or is full
+	writes.clear();
+	os.puts("0123456789");
+	os.puts("abcdefgh");
+	TEST_ASSERT_EQUAL_INT(1, writes.size());
+	TEST_ASSERT_EQUAL_STRING("0123456789", writes[0].c_str());
+	os.puts("ABCDEFGH");
+	TEST_ASSERT_EQUAL_INT(2, writes.size());
+	TEST_ASSERT_EQUAL_STRING("abcdefghABCDEFGH", writes[1].c_str());
+	TEST_ASSERT_FALSE(os.has_buffered_output());
+
+	// too big for the buffer goes straight out after what was held
+	writes.clear();
+	os.puts("ok\n");
+	os.puts("12345678901234567890");
+	TEST_ASSERT_EQUAL_INT(2, writes.size());
+	TEST_ASSERT_EQUAL_STRING("ok\n", writes[0].c_str());
+	TEST_ASSERT_EQUAL_STRING("12345678901234567890", writes[1].c_str());
+
+	// the ok prepend still works
+	writes.clear();
+	os.set_prepend_ok(true);
+	os.puts("result\n");
+	os.set_prepend_ok(false);
+	os.puts("ok ");
+	os.flush_prepend();
+	TEST_ASSERT_TRUE(writes.empty());
+	os.flush();
+	TEST_ASSERT_EQUAL_INT(1, writes.size());
+	TEST_ASSERT_EQUAL_STRING("ok result\n", writes[0].c_str());
+
+	// no delay allowed is the same as not buffered
+	writes.clear();
+	OutputStream os2(record_write_fnc);
+	TEST_ASSERT_TRUE(os2.set_buffered(16, 0));
+	os2.puts("ok\n");
+	os2.puts("ok\n");
+	TEST_ASSERT_EQUAL_INT(2, writes.size());
+
+	// only streams with a write fnc can be buffered
+	std::ostringstream oss;
+	OutputStream os3(&oss);
+	TEST_ASSERT_FALSE(os3.set_buffered(16, 10));
+}
@@ -0,0 +1,123 @@
+#include "../Unity/src/unity.h"
+#include "TestRegistry.h"
+
+#include "PiecewiseLinearTable.h"
+#include "predefined_thermistors.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <limits>
+
+// the same conversions as Thermistor::calculate_temperature()
+static float resistance(uint32_t adc, uint32_t max_adc, int r1, int r2)
+{
+    float r = r2 / (((float)max_adc / adc) - 1.0F);
+    if (r1 > 0.0F) r = (r1 * r) / (r1 - r);
+    return r;
+}
+
+static float beta_temperature(uint32_t adc, uint32_t max_adc, const thermistor_beta_table_t& t)
+{
+    if ((adc >= max_adc) || (adc == 0)) return std::numeric_limits<float>::infinity();
+    float r = resistance(adc, max_adc, t.r1, t.r2);
+    if(r > t.r0 * 8) return std::numeric_limits<float>::infinity();
+    float j = 1.0F / t.beta;
+    float k = 1.0F / (t.t0 + 273.15F);
+    return (1.0F / (k + (j * logf(r / t.r0)))) - 273.15F;
+}
+
+static float shh_temperature(uint32_t adc, uint32_t max_adc, const thermistor_table_t& t)
+{
+    if ((adc >= max_adc) || (adc == 0)) return std::numeric_limits<float>::infinity();
+    float r = resistance(adc, max_adc, t.r1, t.r2);
+    if(r > 100000.0F * 8) return std::numeric_limits<float>::infinity();
+    float l = logf(r);
+    return (1.0F / (t.c1 + t.c2 * l + t.c3 * powf(l, 3))) - 273.15F;
+}
+
+// every adc value in the table is within max_error of the equation, and out of range where the equation has no value
+static void check_table(std::function<float(uint32_t)> fnc, uint32_t max_adc, const char *name)
+{
+    const float max_error = 0.05F;
+    PiecewiseLinearTable table;
+    TEST_ASSERT_TRUE(table.build(max_adc, fnc, max_error, 256));
+
+    float worst = 0;
+    for (uint32_t adc = 0; adc < max_adc; ++adc) {
+        float t = fnc(adc);
+        float tt = table.get(adc);
+        if(!isfinite(t)) {
+            // open circuit, or a nan from a resistance below zero with a parallel resistor
+            TEST_ASSERT_TRUE(isinf(tt));
+        } else {
+            TEST_ASSERT_FALSE(isinf(tt));
+            float e = fabsf(t - tt);
+            if(e > worst) worst = e;
+        }
+    }
+    // allow for float rounding of the interpolation
+    TEST_ASSERT_TRUE(worst <= max_error * 1.01F);
+    printf("%s: %d points for %lu adc values, worst error %f\n", name, table.get_size(), (unsigned long)max_adc, worst);
+}
+
+REGISTER_TEST(ThermistorTable, beta_thermistors)
+{
+    for (auto& t : predefined_thermistors_beta) {
+        check_table([&t](uint32_t adc) { return beta_temperature(adc, 4096, t); }, 4096, t.name);
+    }
+}
+
+REGISTER_TEST(ThermistorTable, steinhart_hart_thermistors)
+{
+    for (auto& t : predefined_thermistors) {
+        check_table([&t](uint32_t adc) { return shh_temperature(adc, 4096, t); }, 4096, t.name);
+    }
+}
+
+REGISTER_TEST(ThermistorTable, other_resolutions)
+{
+    // no oversampling, and the most that can be configured
+    auto& t = predefined_thermistors_beta[0];
+    check_table([&t](uint32_t adc) { return beta_temperature(adc, 1024, t); }, 1024, "1024");
+    check_table([&t](uint32_t adc) { return beta_temperature(adc, 16384, t); }, 16384, "16384");
+}
+
+REGISTER_TEST(ThermistorTable, limits)
+{
+    PiecewiseLinearTable table;
+    TEST_ASSERT_FALSE(table.is_valid());
+    TEST_ASSERT_TRUE(isinf(table.get(100)));
+
+    // nothing finite
+    TEST_ASSERT_FALSE(table.build(100, [](uint32_t) { return std::numeric_limits<float>::infinity(); }, 0.1F, 10));
+    TEST_ASSERT_FALSE(table.is_valid());
+
+    // a straight line needs just the two ends
+    TEST_ASSERT_TRUE(table.build(100, [](uint32_t x) { return x < 10 ? std::numeric_limits<float>::infinity() : 2.0F * x + 1; }, 0.001F, 10));
+    TEST_ASSERT_EQUAL_INT(2, table.get_size());
+    TEST_ASSERT_TRUE(isinf(table.get(9)));
+    TEST_ASSERT_EQUAL_FLOAT(21.0F, table.get(10));
+    TEST_ASSERT_EQUAL_FLOAT(101.0F, table.get(50));
+    TEST_ASSERT_EQUAL_FLOAT(199.0F, table.get(99));
+
+    // too few points allowed
+    TEST_ASSERT_FALSE(table.build(1000, [](uint32_t x) { return sqrtf(x); }, 0.0001F, 4));
+    TEST_ASSERT_FALSE(table.is_valid());
+}
+
+REGISTER_TEST(ThermistorTable, swap)
+{
+    // a new table is built on the side and swapped in, the old one goes with the other table
+    PiecewiseLinearTable table, t;
+    TEST_ASSERT_TRUE(table.build(100, [](uint32_t x) { return 2.0F * x; }, 0.001F, 10));
+    TEST_ASSERT_TRUE(t.build(100, [](uint32_t x) { return 3.0F * x; }, 0.001F, 10));
+    table.swap(t);
+    TEST_ASSERT_EQUAL_FLOAT(150.0F, table.get(50));
+    TEST_ASSERT_EQUAL_FLOAT(100.0F, t.get(50));
+
+    // swapping with an empty table leaves it empty
+    t.clear();
+    table.swap(t);
+    TEST_ASSERT_FALSE(table.is_valid());
+    TEST_ASSERT_EQUAL_FLOAT(150.0F, t.get(50));
+}
@@ -7,6 +7,8 @@
 #include "TestRegistry.h"
 
 #include "LinearDeltaSolution.h"
+#include "RotaryDeltaSolution.h"
+#include "MorganSCARASolution.h"
 #include "ActuatorCoordinates.h"
 
 #include "ConfigReader.h"
@@ -68,3 +70,84 @@ REGISTER_TEST(ArmSolution, delta_ik_vs_fk)
 
     delete k;
 }
+
+REGISTER_TEST(ArmSolution, delta_ik_batch)
+{
+    /* Get RIT timer peripheral clock rate */
+    uint32_t timerFreq = Chip_Clock_GetRate(CLK_MX_RITIMER);
+
+    std::stringstream ss1(str);
+    ConfigReader cr(ss1);
+    BaseSolution* k= new LinearDeltaSolution(cr);
+
+    // the segments of a line, 16 at a time as Robot::append_line does
+    const int batch= 16;
+    static float xyz[3][batch], abc[3][batch];
+    const float *const cartesian[3]= {xyz[0], xyz[1], xyz[2]};
+    float *const actuator[3]= {abc[0], abc[1], abc[2]};
+    for (int i = 0; i < batch; ++i) {
+        xyz[0][i]= 10.0F + i * 0.1F;
+        xyz[1][i]= 20.0F - i * 0.1F;
+        xyz[2][i]= 100.0F;
+    }
+
+    uint32_t n= 100000 / batch;
+    systime_t st = clock_systimer();
+    for(uint32_t i=0;i<n;i++) k->cartesian_to_actuator_n(batch, cartesian, actuator);
+    systime_t en = clock_systimer();
+
+    printf("elapsed time %lu us over %lu points %1.4f us per point\n", TICK2USEC(en-st), n * batch, TICK2USEC(en-st)/(float)(n * batch));
+
+    delete k;
+
+    TEST_PASS();
+}
+
+// the batch transform gives the same actuator positions as transforming each point
+static void check_batch(BaseSolution* k)
+{
+    const int npts= 21 * 21;
+    static float xyz[3][npts], abc[3][npts];
+    const float *const cartesian[3]= {xyz[0], xyz[1], xyz[2]};
+    float *const actuator[3]= {abc[0], abc[1], abc[2]};
+
+    int n= 0;
+    for(float x= -50.0F; x <= 50.0F; x += 5.0F) {
+        for(float y= -50.0F; y <= 50.0F; y += 5.0F) {
+            xyz[0][n]= x;
+            xyz[1][n]= y;
+            xyz[2][n]= 10.0F + n * 0.1F;
+            ++n;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(npts, n);
+
+    k->cartesian_to_actuator_n(npts, cartesian, actuator);
+
+    for (int i = 0; i < npts; ++i) {
+        float mm[3]= {xyz[0][i], xyz[1][i], xyz[2][i]};
+        ActuatorCoordinates ac;
+        k->cartesian_to_actuator(mm, ac);
+        TEST_ASSERT_FLOAT_WITHIN(0.0001F, ac[0], abc[0][i]);
+        TEST_ASSERT_FLOAT_WITHIN(0.0001F, ac[1], abc[1][i]);
+        TEST_ASSERT_FLOAT_WITHIN(0.0001F, ac[2], abc[2][i]);
+    }
+}
+
+REGISTER_TEST(ArmSolution, ik_batch_vs_ik)
+{
+    std::stringstream ss1(str);
+    ConfigReader cr(ss1);
+
+    BaseSolution* k= new LinearDeltaSolution(cr);
+    check_batch(k);
+    delete k;
+
+    k= new RotaryDeltaSolution(cr);
+    check_batch(k);
+    delete k;
+
+    k= new MorganSCARASolution(cr);
+    check_batch(k);
+    delete k;
+}
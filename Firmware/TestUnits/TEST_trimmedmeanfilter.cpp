@@ -0,0 +1,138 @@
+#include "../Unity/src/unity.h"
+#include "TestRegistry.h"
+
+#include "TrimmedMeanFilter.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+// what the Adc used to do for each read, shift the buffer, then sort a copy of it and sum the middle
+struct SortFilter {
+    uint16_t buf[64];
+    int n, trim;
+
+    SortFilter(int n, int trim) : n(n), trim(trim) { memset(buf, 0, sizeof(buf)); }
+    void add(uint16_t v)
+    {
+        for (int i = 1; i < n; ++i) buf[i - 1] = buf[i];
+        buf[n - 1] = v;
+    }
+    uint32_t sum() const
+    {
+        uint16_t s[64];
+        memcpy(s, buf, sizeof(s));
+        std::sort(s, s + n);
+        uint32_t sum = 0;
+        for (int i = trim; i < n - trim; ++i) sum += s[i];
+        return sum;
+    }
+    uint16_t median() const
+    {
+        uint16_t s[64];
+        memcpy(s, buf, sizeof(s));
+        std::nth_element(s, s + n / 2, s + n);
+        return s[n / 2];
+    }
+};
+
+REGISTER_TEST(TrimmedMeanFilter, init)
+{
+    TrimmedMeanFilter f;
+    TEST_ASSERT_FALSE(f.is_valid());
+    TEST_ASSERT_FALSE(f.init(0, 0));
+    TEST_ASSERT_FALSE(f.init(8, 4));
+    TEST_ASSERT_TRUE(f.init(32, 8));
+    TEST_ASSERT_TRUE(f.is_valid());
+    TEST_ASSERT_EQUAL_INT(32, f.get_size());
+    TEST_ASSERT_EQUAL_INT(16, f.get_count());
+    TEST_ASSERT_EQUAL_INT(0, f.get_sum());
+
+    f.fill(100);
+    TEST_ASSERT_EQUAL_INT(1600, f.get_sum());
+    TEST_ASSERT_EQUAL_INT(100, f.get_median());
+}
+
+REGISTER_TEST(TrimmedMeanFilter, same_as_sorting)
+{
+    const int sizes[][2] = { {32, 8}, {8, 2}, {5, 1}, {64, 16}, {1, 0} };
+    srand(1234);
+    for (auto& sz : sizes) {
+        TrimmedMeanFilter f;
+        TEST_ASSERT_TRUE(f.init(sz[0], sz[1]));
+        SortFilter s(sz[0], sz[1]);
+
+        uint16_t v = 512;
+        for (int i = 0; i < 5000; ++i) {
+            // a noisy slowly changing reading with the odd spike and runs of the same value
+            if(i % 500 < 50) {
+                // same value
+            } else if(rand() % 50 == 0) {
+                v = rand() % 1024;
+            } else {
+                int d = (rand() % 9) - 4;
+                v = std::min(std::max((int)v + d, 0), 1023);
+            }
+
+            f.add(v);
+            s.add(v);
+            TEST_ASSERT_EQUAL_INT(s.sum(), f.get_sum());
+            TEST_ASSERT_EQUAL_INT(s.median(), f.get_median());
+        }
+    }
+}
+
+REGISTER_TEST(TrimmedMeanFilter, extremes)
+{
+    TrimmedMeanFilter f;
+    TEST_ASSERT_TRUE(f.init(32, 8));
+    SortFilter s(32, 8);
+
+    // alternate between the limits so every add moves across the whole window
+    for (int i = 0; i < 200; ++i) {
+        uint16_t v = (i & 1) ? 1023 : 0;
+        if(i % 7 == 0) v = 511;
+        f.add(v);
+        s.add(v);
+        TEST_ASSERT_EQUAL_INT(s.sum(), f.get_sum());
+        TEST_ASSERT_EQUAL_INT(s.median(), f.get_median());
+    }
+}
+
+REGISTER_TEST(TrimmedMeanFilter, refill_after_clear)
+{
+    TrimmedMeanFilter f;
+    TEST_ASSERT_TRUE(f.init(32, 8));
+    f.fill(100);
+
+    // only the samples added since the clear are used, with the trim scaled to how many there are
+    f.clear();
+    TEST_ASSERT_EQUAL_INT(0, f.get_samples());
+    f.add(500);
+    TEST_ASSERT_EQUAL_INT(1, f.get_count());
+    TEST_ASSERT_EQUAL_INT(500, f.get_sum());
+    TEST_ASSERT_EQUAL_INT(500, f.get_median());
+
+    uint16_t v[] = {400, 1000, 450, 0, 550, 480, 520};
+    for (auto i : v) f.add(i);
+    TEST_ASSERT_EQUAL_INT(8, f.get_samples());
+    TEST_ASSERT_EQUAL_INT(4, f.get_count());
+    TEST_ASSERT_EQUAL_INT(450 + 480 + 500 + 520, f.get_sum());
+
+    // once full it is a moving window again of just those samples
+    SortFilter s(32, 8);
+    s.add(500);
+    for (auto i : v) s.add(i);
+    for (int i = 8; i < 32; ++i) {
+        f.add(300 + i);
+        s.add(300 + i);
+    }
+    TEST_ASSERT_EQUAL_INT(32, f.get_samples());
+    for (int i = 0; i < 100; ++i) {
+        uint16_t x = (i * 37) % 1024;
+        f.add(x);
+        s.add(x);
+        TEST_ASSERT_EQUAL_INT(s.sum(), f.get_sum());
+        TEST_ASSERT_EQUAL_INT(s.median(), f.get_median());
+    }
+}
@@ -109,6 +109,11 @@ void safe_sleep(uint32_t ms)
     }
 }
 
+void safe_wait(uint32_t ms)
+{
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+}
+
 void print_to_all_consoles(const char *str)
 {
     printf("%s", str);
@@ -366,6 +371,8 @@ extern "C" void dispatch(void *pvParameters)
     MD5 md5;
     size_t cnt= 0, lcnt= 0;
     while(1) {
+        // done with the last line
+        release_message_queue();
         // now read lines and dispatch them
         if( receive_message_queue(&line, &os) ) {
             // if we are in the download mode (simulating M28)
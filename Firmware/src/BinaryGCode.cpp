@@ -0,0 +1,146 @@
+#include "BinaryGCode.h"
+#include "GCodeProcessor.h"
+
+#include <math.h>
+#include <string.h>
+
+const char BinaryGCode::letters[NWORDS] = {'X', 'Y', 'Z', 'E', 'F', 'I', 'J', 'S'};
+const float BinaryGCode::scale[NWORDS] = {1000, 1000, 1000, 100000, 10, 1000, 1000, 10000};
+
+void BinaryGCode::reset()
+{
+    memset(last, 0, sizeof(last));
+    need_reset = true;
+}
+
+uint16_t BinaryGCode::crc16(const uint8_t *p, size_t n)
+{
+    uint16_t crc = 0xFFFF;
+    while(n-- > 0) {
+        crc ^= (uint16_t)*p++ << 8;
+        for (int i = 0; i < 8; ++i) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+bool BinaryGCode::check_frame(const uint8_t *frame, size_t n)
+{
+    if(n < 4 || frame[0] != STX || frame_size(frame[1]) != n) return false;
+    uint16_t crc = crc16(&frame[1], n - 3);
+    return frame[n - 2] == (crc >> 8) && frame[n - 1] == (crc & 0xFF);
+}
+
+// exact for up to 24 bits as the division is correctly rounded, the same as the parser gives for the decimal
+float BinaryGCode::to_float(int32_t q, int w)
+{
+    if(q < (1 << 24) && q > -(1 << 24)) return (float)q / scale[w];
+    return (float)((double)q / scale[w]);
+}
+
+size_t BinaryGCode::encode(const GCode& gc, uint8_t *frame)
+{
+    if(!gc.has_g() || gc.get_code() > 3 || gc.get_subcode() != 0 || gc.has_error()) return 0;
+
+    int32_t q[NWORDS];
+    uint8_t words = 0;
+    for (auto& a : gc.get_args()) {
+        int w = 0;
+        while(w < NWORDS && letters[w] != a.first) ++w;
+        if(w == NWORDS) return 0;
+        double d = rint((double)a.second * scale[w]);
+        if(!(fabs(d) < 2147483647.0)) return 0;
+        q[w] = (int32_t)d;
+        if(to_float(q[w], w) != a.second) return 0; // not on a quantum
+        words |= 1 << w;
+    }
+
+    const int32_t *base = last;
+    int32_t zero[NWORDS] = {0};
+    if(need_reset) base = zero;
+
+    uint8_t *p = &frame[2];
+    *p++ = gc.get_code() | (need_reset ? 0x80 : 0);
+    *p++ = words;
+    for (int w = 0; w < NWORDS; ++w) {
+        if((words & (1 << w)) == 0) continue;
+        int64_t delta = (int64_t)q[w] - base[w];
+        if(delta > INT32_MAX || delta < INT32_MIN) return 0;
+        // zig zag so small negative differences are small too
+        uint32_t z = ((uint32_t)delta << 1) ^ (uint32_t)((int32_t)delta >> 31);
+        while(z >= 0x80) {
+            *p++ = z | 0x80;
+            z >>= 7;
+        }
+        *p++ = z;
+    }
+
+    if(need_reset) {
+        memset(last, 0, sizeof(last));
+        need_reset = false;
+    }
+    for (int w = 0; w < NWORDS; ++w) {
+        if(words & (1 << w)) last[w] = q[w];
+    }
+
+    size_t len = p - &frame[2];
+    frame[0] = STX;
+    frame[1] = len;
+    uint16_t crc = crc16(&frame[1], len + 1);
+    *p++ = crc >> 8;
+    *p++ = crc & 0xFF;
+    return p - frame;
+}
+
+bool BinaryGCode::decode(const uint8_t *payload, size_t n, GCode& gc)
+{
+    gc.clear();
+    if(n < 2 || (payload[0] & 0x7C) != 0) {
+        gc.set_error("Bad binary record");
+        return false;
+    }
+
+    bool reset = (payload[0] & 0x80) != 0;
+    if(!reset && !synced) {
+        gc.set_error("Binary record out of sync, waiting for a reset record");
+        return false;
+    }
+
+    int32_t q[NWORDS];
+    memcpy(q, last, sizeof(q));
+    if(reset) memset(q, 0, sizeof(q));
+
+    uint8_t words = payload[1];
+    const uint8_t *p = &payload[2];
+    const uint8_t *e = payload + n;
+    for (int w = 0; w < NWORDS; ++w) {
+        if((words & (1 << w)) == 0) continue;
+        uint32_t z = 0;
+        int shift = 0;
+        do {
+            if(p >= e || shift > 28) {
+                gc.set_error("Bad binary record");
+                return false;
+            }
+            z |= (uint32_t)(*p & 0x7F) << shift;
+            shift += 7;
+        } while(*p++ & 0x80);
+        q[w] = (int32_t)((uint32_t)q[w] + ((z >> 1) ^ -(z & 1)));
+    }
+    if(p != e) {
+        gc.set_error("Bad binary record");
+        return false;
+    }
+
+    memcpy(last, q, sizeof(last));
+    synced = true;
+    gc.set_command('G', payload[0] & 0x03);
+    for (int w = 0; w < NWORDS; ++w) {
+        if(words & (1 << w)) gc.add_arg(letters[w], to_float(q[w], w));
+    }
+
+    // text lines that follow with just the words are moves of the same type
+    GCodeProcessor::set_group1_modal_code(gc.get_code());
+    return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "GCode.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Binary records for the G0-G3 moves that make up most of a job, so they can be sent without
+ * being formatted as text and parsed again.
+ *
+ * A record is framed as
+ *   STX len payload[len] crc_hi crc_lo
+ * where crc is the CRC-16/CCITT (start 0xFFFF) of len and the payload. The payload is
+ *   flags   bits 0-1 are the G code 0-3, bit 7 resets the last values to 0 before this record
+ *   words   a bit for each of X Y Z E F I J S in the record, X is bit 0
+ * then for each word in the record the difference in quanta from the value that word had in the
+ * last record, as a zig zag varint. The quanta are 0.001mm for XYZIJ, 0.00001mm for E,
+ * 0.1mm/min for F and 0.0001 for S.
+ *
+ * Records can be mixed with text lines, a record is handled as if the line it was made from had
+ * been sent. Each host (output stream) has its own decoder.
+ *
+ * Resync: if a record is lost the values the host and the firmware have as the last ones differ,
+ * so after a record fails its CRC, or a record is received while halted, the decoder is out of
+ * sync and rejects every record without the reset flag until one with it arrives. A host should
+ * send its next record with the reset flag after any error reply to a record, or after a halt. The encoder only makes a record of a gcode that decodes to exactly the same floats
+ * as the parser gives for the line, everything else is sent as text.
+ */
+class BinaryGCode
+{
+public:
+    BinaryGCode() { reset(); }
+
+    static const uint8_t STX = 0x02;
+    static const size_t MAX_PAYLOAD = 48;
+    static const size_t MAX_FRAME = MAX_PAYLOAD + 4;
+
+    // the next record encoded is sent with the reset flag, decoding starts from 0
+    void reset();
+
+    // puts the frame for gc in frame, returns its size or 0 if gc can not be sent as a record
+    size_t encode(const GCode& gc, uint8_t *frame);
+    // the gcode in the payload of a frame, false if it is not a valid record or the decoder is out of sync
+    bool decode(const uint8_t *payload, size_t n, GCode& gc);
+    // a record may have been lost, only a record with the reset flag is decoded next
+    void desync() { synced = false; }
+    bool is_synced() const { return synced; }
+
+    // size of a frame from its len byte, 0 if len is too big
+    static size_t frame_size(uint8_t len) { return len <= MAX_PAYLOAD ? len + 4 : 0; }
+    // true if the n bytes are a whole frame with a good crc
+    static bool check_frame(const uint8_t *frame, size_t n);
+    static uint16_t crc16(const uint8_t *p, size_t n);
+
+private:
+    static const int NWORDS = 8;
+    static const char letters[NWORDS];
+    static const float scale[NWORDS];     // quanta per unit
+
+    static float to_float(int32_t q, int w);
+
+    int32_t last[NWORDS];
+    bool need_reset;
+    bool synced{true};
+};
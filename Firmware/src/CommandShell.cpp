@@ -7,6 +7,7 @@
 #include "AutoPushPop.h"
 #include "StepperMotor.h"
 #include "main.h"
+#include "SlabAllocator.h"
 #include "TemperatureControl.h"
 #include "ConfigWriter.h"
 #include "Conveyor.h"
@@ -398,13 +399,23 @@ bool CommandShell::mem_cmd(std::string& params, OutputStream& os)
     os.printf("malloc:      total       used       free    largest\n");
     os.printf("Mem:   %11d%11d%11d%11d\n", mem.arena, mem.uordblks, mem.fordblks, mem.ordblks);
 
-    os.printf("RAM2: %lu used, %lu bytes free\n", _RAM2->get_size() - _RAM2->available(), _RAM2->available());
-    os.printf("RAM3: %lu used, %lu bytes free\n", _RAM3->get_size() - _RAM3->available(), _RAM3->available());
-    os.printf("RAM4: %lu used, %lu bytes free\n", _RAM4->get_size() - _RAM4->available(), _RAM4->available());
-    os.printf("RAM5: %lu used, %lu bytes free\n", _RAM5->get_size() - _RAM5->available(), _RAM5->available());
+    MemoryPool *pools[]= {_RAM2, _RAM3, _RAM4, _RAM5};
+    os.printf("pool:     used       free   max used    largest  frag  failed\n");
+    for (int i = 0; i < 4; ++i) {
+        MemoryPool *m= pools[i];
+        uint32_t avail= m->available();
+        uint32_t largest= m->largest_free();
+        // fragmentation is the part of the free memory that is not in the largest free block
+        os.printf("RAM%d: %9lu  %9lu  %9lu  %9lu  %3lu%%  %6lu\n", i + 2, m->get_size() - avail, avail, m->get_max_used(),
+                  largest, avail > 0 ? 100 - (largest * 100) / avail : 0, m->get_failed());
+    }
     os.printf("Total available RAM: %lu\n", xPortGetFreeHeapSize() +
               _RAM2->available() + _RAM3->available() + _RAM4->available() + _RAM5->available());
 
+    if(SlabAllocator::getInstance() != nullptr) {
+        SlabAllocator::getInstance()->debug(os);
+    }
+
     if(!params.empty()) {
         os.printf("-- RAM2 --\n"); _RAM2->debug(os);
         os.printf("-- RAM3 --\n"); _RAM3->debug(os);
@@ -1368,7 +1379,7 @@ bool CommandShell::ry_cmd(std::string& params, OutputStream& os)
     }
 
 
-    YModem ymodem([&os](char c){os.write(&c, 1);});
+    YModem ymodem([&os](char c){os.write(&c, 1); os.flush();});
     // check we did not run out of memory
     if(!ymodem.is_ok()) {
         os.printf("error: not enough memory\n");
@@ -67,43 +67,86 @@ std::string ConfigReader::strip_comments(std::string& s)
     return "";
 }
 
-// just extract the key/values from the specified section
-bool ConfigReader::get_section(const char *section, section_map_t& config)
+// read the whole stream once and keep every section and key/value in it, in file order
+void ConfigReader::build_index()
 {
+    text.clear();
+    entries.clear();
+    sections.clear();
+
+    auto add_text= [this](const std::string& str) {
+        uint32_t off= text.size();
+        text.append(str);
+        text.push_back('\0');
+        return off;
+    };
+
     reset();
-    current_section =  section;
-    bool in_section = false;
     std::string s;
     while (std::getline(is, s)) {
         s = stringutils::trim(s);
         if(s.empty()) continue;
 
         // only check lines that are not blank and are not all comments
-        if (s.size() > 0 && s[0] != '#') {
-            strip_comments(s);
-
-            std::string sec;
+        if (s[0] == '#') continue;
+        strip_comments(s);
 
-            if (match_section(s.c_str(), sec)) {
-                // if this is the section we are looking for
-                if(sec == section) {
-                    in_section = true;
+        std::string sec;
+        if (match_section(s.c_str(), sec)) {
+            sections.push_back({add_text(sec), (uint32_t)entries.size(), (uint32_t)entries.size()});
+        }
 
-                } else if(in_section) {
-                    // we are no longer in the section we want
-                    break;
-                }
+        // anything before the first section is ignored
+        if(sections.empty()) continue;
+
+        std::string key;
+        std::string value;
+        if(extract_key_value(s.c_str(), key, value)) {
+            entry_t e;
+            e.key= add_text(key);
+            e.value= add_text(value);
+
+            std::string key1;
+            std::string key2;
+            if(extract_sub_key_value(s.c_str(), key1, key2, value)) {
+                e.key1= add_text(key1);
+                e.key2= add_text(key2);
+            } else {
+                e.key1= e.key2= no_sub_key;
             }
 
-            if(in_section) {
-                std::string key;
-                std::string value;
-                // extract all key/values from this section
-                if(extract_key_value(s.c_str(), key, value)) {
-                    // set this as a key value pair on the current name
-                    config[key] = value;
-                }
+            entries.push_back(e);
+            sections.back().last= entries.size();
+        }
+    }
+
+    text.shrink_to_fit();
+    entries.shrink_to_fit();
+    indexed= true;
+}
+
+// returns the index of the first header for the section or -1
+int ConfigReader::find_section(const char *section) const
+{
+    for (size_t i = 0; i < sections.size(); ++i) {
+        if(strcmp(text_at(sections[i].name), section) == 0) return i;
+    }
+    return -1;
+}
+
+// just extract the key/values from the specified section
+bool ConfigReader::get_section(const char *section, section_map_t& config)
+{
+    if(!indexed) build_index();
+    current_section =  section;
 
+    int i= find_section(section);
+    if(i >= 0) {
+        // a header repeated straight after itself continues the section, any other header ends it
+        for (; i < (int)sections.size() && strcmp(text_at(sections[i].name), section) == 0; ++i) {
+            for (uint32_t j = sections[i].first; j < sections[i].last; ++j) {
+                // set this as a key value pair on the current name
+                config[text_at(entries[j].key)] = text_at(entries[j].value);
             }
         }
     }
@@ -114,67 +157,31 @@ bool ConfigReader::get_section(const char *section, section_map_t& config)
 // just extract the key/values from the specified section and split them into sub sections
 bool ConfigReader::get_sub_sections(const char *section, sub_section_map_t& config)
 {
-    reset();
+    if(!indexed) build_index();
     current_section =  section;
-    bool in_section = false;
-    std::string s;
-    while (std::getline(is, s)) {
-        s = stringutils::trim(s);
-        if(s.empty()) continue;
-
-        // only check lines that are not blank and are not all comments
-        if (s.size() > 0 && s[0] != '#') {
-            strip_comments(s);
-            std::string sec;
-
-            if (match_section(s.c_str(), sec)) {
-                // if this is the section we are looking for
-                if(sec == section) {
-                    in_section = true;
-
-                } else if(in_section) {
-                    // we are no longer in the section we want
-                    break;
-                }
-            }
-
-            if(in_section) {
-                std::string key1;
-                std::string key2;
-                std::string value;
-                // extract all key/values from this section
-                // and split them into subsections
-                if(extract_sub_key_value(s.c_str(), key1, key2, value)) {
-                    // set this as a key value pair on the current name
-                    config[key1][key2] = value;
-                }
 
+    int i= find_section(section);
+    if(i >= 0) {
+        for (; i < (int)sections.size() && strcmp(text_at(sections[i].name), section) == 0; ++i) {
+            for (uint32_t j = sections[i].first; j < sections[i].last; ++j) {
+                const entry_t& e= entries[j];
+                if(e.key1 == no_sub_key) continue;
+                config[text_at(e.key1)][text_at(e.key2)] = text_at(e.value);
             }
         }
     }
+
     return !config.empty();
 }
 
 // just extract the sections
 bool ConfigReader::get_sections(sections_t& config)
 {
-    reset();
+    if(!indexed) build_index();
     current_section =  "";
 
-    std::string s;
-    while (std::getline(is, s)) {
-        s = stringutils::trim(s);
-        if(s.empty()) continue;
-
-        // only check lines that are not blank and are not all comments
-        if (s.size() > 0 && s[0] != '#') {
-            strip_comments(s);
-            std::string sec;
-
-            if (match_section(s.c_str(), sec)) {
-                config.insert(sec);
-            }
-        }
+    for(auto& s : sections) {
+        config.insert(text_at(s.name));
     }
 
     return !config.empty();
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 #include <map>
 #include <set>
 #include <istream>
+#include <vector>
 
 class ConfigWriter;
 
@@ -14,6 +16,9 @@ public:
     ~ConfigReader(){};
 
     void reset() { is.clear(); is.seekg (0); }
+    // the stream is read once, the first time a section is asked for, after that the sections
+    // are found in the index. Call this if the stream has changed since.
+    void reindex() { indexed = false; }
     using section_map_t = std::map<std::string, std::string>;
     using sub_section_map_t =  std::map<std::string, section_map_t>;
     using sections_t = std::set<std::string>;
@@ -34,8 +39,33 @@ private:
     static bool extract_sub_key_value(const char *line, std::string& key1, std::string& key2, std::string& value);
     static std::string strip_comments(std::string& s);
 
+    void build_index();
+    int find_section(const char *section) const;
+    const char *text_at(uint32_t off) const { return &text[off]; }
+
     std::istream& is;
     std::string current_section;
 
+    // every key and value in the file, each is nul terminated in text and referred to by its offset
+    struct entry_t {
+        uint32_t key;
+        uint32_t value;
+        uint32_t key1; // key split at the . for sub sections, or no_sub_key
+        uint32_t key2;
+    };
+    static const uint32_t no_sub_key= UINT32_MAX;
+
+    // the entries of a section header up to the next header
+    struct section_t {
+        uint32_t name;
+        uint32_t first;
+        uint32_t last;
+    };
+
+    std::string text;
+    std::vector<entry_t> entries;
+    std::vector<section_t> sections;
+    bool indexed{false};
+
     friend ConfigWriter;
 };
@@ -8,6 +8,7 @@
 #include <ctype.h>
 #include <cmath>
 #include <string.h>
+#include <stdio.h>
 #include <cstdarg>
 
 using namespace std;
@@ -63,16 +64,37 @@ bool Dispatcher::dispatch(GCode& gc, OutputStream& os, bool need_ok) const
 		}
 	}
 
-	auto& handler = gc.has_g() ? gcode_handlers : mcode_handlers;
-	const auto& f = handler.equal_range(gc.get_code());
+	uint16_t code = gc.get_code();
 	bool ret = false;
 
-	for (auto it = f.first; it != f.second; ++it) {
-		if(it->second(gc, os)) {
-			ret = true;
-		} else {
-			// not really useful as many handlers will only process if certain params are set, so not an error unless no handler deals with it.
-			DEBUG_WARNING("//INFO: handler did not handle %c%d\n", gc.has_g() ? 'G' : 'M', gc.get_code());
+	// fast path for G0-G3 which are most of what gets dispatched
+	if(motion_handler != nullptr && gc.has_g() && code <= 3) {
+		ret = motion_handler(gc, os);
+	}
+
+	if(tables_built) {
+		const DispatchTable& t = gc.has_g() ? gcode_table : mcode_table;
+		if(code + 1U < t.index.size()) {
+			for (uint8_t i = t.index[code]; i < t.index[code + 1]; ++i) {
+				if((*t.handlers[i])(gc, os)) {
+					ret = true;
+				} else {
+					DEBUG_WARNING("//INFO: handler did not handle %c%d\n", gc.has_g() ? 'G' : 'M', code);
+				}
+			}
+		}
+
+	} else {
+		auto& handler = gc.has_g() ? gcode_handlers : mcode_handlers;
+		const auto& f = handler.equal_range(code);
+
+		for (auto it = f.first; it != f.second; ++it) {
+			if(it->second(gc, os)) {
+				ret = true;
+			} else {
+				// not really useful as many handlers will only process if certain params are set, so not an error unless no handler deals with it.
+				DEBUG_WARNING("//INFO: handler did not handle %c%d\n", gc.has_g() ? 'G' : 'M', code);
+			}
 		}
 	}
 
@@ -178,6 +200,7 @@ Dispatcher::Handlers_t::iterator Dispatcher::add_handler(HANDLER_NAME gcode, uin
 		case GCODE_HANDLER: ret = gcode_handlers.insert( Handlers_t::value_type(code, fnc) ); break;
 		case MCODE_HANDLER: ret = mcode_handlers.insert( Handlers_t::value_type(code, fnc) ); break;
 	}
+	if(tables_built) build_dispatch_tables();
 	return ret;
 }
 
@@ -187,6 +210,7 @@ void Dispatcher::remove_handler(HANDLER_NAME gcode, Handlers_t::iterator i)
 		case GCODE_HANDLER: gcode_handlers.erase(i); break;
 		case MCODE_HANDLER: mcode_handlers.erase(i); break;
 	}
+	if(tables_built) build_dispatch_tables();
 }
 
 Dispatcher::CommandHandlers_t::iterator Dispatcher::add_handler(std::string cmd, CommandHandler_t fnc)
@@ -200,4 +224,45 @@ void Dispatcher::clear_handlers()
 	gcode_handlers.clear();
 	mcode_handlers.clear();
 	command_handlers.clear();
+	gcode_table.clear();
+	mcode_table.clear();
+	motion_handler = nullptr;
+	tables_built = false;
+}
+
+bool Dispatcher::DispatchTable::build(const Handlers_t& h)
+{
+	clear();
+	if(h.empty()) return true;
+
+	// the index is a byte so there can only be 255 handlers
+	if(h.size() > UINT8_MAX) return false;
+
+	uint16_t max_code = h.rbegin()->first;
+	index.reserve(max_code + 2);
+	handlers.reserve(h.size());
+
+	// the multimap is ordered by code then insertion order, so this keeps the order the handlers are called in
+	auto it = h.begin();
+	for (uint32_t c = 0; c <= max_code; ++c) {
+		index.push_back(handlers.size());
+		for (; it != h.end() && it->first == c; ++it) {
+			handlers.push_back(&it->second);
+		}
+	}
+	index.push_back(handlers.size());
+	return true;
+}
+
+// Called once all the modules have registered their handlers, after this a handler is found by indexing
+// the tables rather than searching the multimaps. If the tables cannot be built the multimaps are used.
+bool Dispatcher::build_dispatch_tables()
+{
+	tables_built = gcode_table.build(gcode_handlers) && mcode_table.build(mcode_handlers);
+	if(!tables_built) {
+		gcode_table.clear();
+		mcode_table.clear();
+		printf("WARNING: Dispatcher: too many handlers for the dispatch tables\n");
+	}
+	return tables_built;
 }
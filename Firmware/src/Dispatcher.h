@@ -4,6 +4,7 @@
 #include <functional>
 #include <string>
 #include <set>
+#include <vector>
 #include <stdint.h>
 
 #define THEDISPATCHER Dispatcher::getInstance()
@@ -28,6 +29,10 @@ public:
     enum HANDLER_NAME { GCODE_HANDLER, MCODE_HANDLER };
     Handlers_t::iterator add_handler(HANDLER_NAME gcode, uint16_t code, Handler_t fnc);
 
+    // G0-G3 go straight to this rather than through the handler tables
+    using MotionHandler_t = bool (*)(GCode&, OutputStream&);
+    void set_motion_handler(MotionHandler_t fnc) { motion_handler= fnc; }
+
     using CommandHandler_t = std::function<bool(std::string&, OutputStream&)>;
     using CommandHandlers_t = std::multimap<std::string, CommandHandler_t>;
     CommandHandlers_t::iterator add_handler(std::string cmd, CommandHandler_t fnc);
@@ -38,6 +43,7 @@ public:
     bool dispatch(const char *line, OutputStream& os) const;
     bool load_configuration() const;
     void clear_handlers();
+    bool build_dispatch_tables();
     bool is_grbl_mode() const { return grbl_mode; }
     void set_grbl_mode(bool flg) { grbl_mode= flg; }
 
@@ -48,6 +54,19 @@ private:
     Handlers_t gcode_handlers;
     Handlers_t mcode_handlers;
     CommandHandlers_t command_handlers;
+
+    // flat tables indexed by the code, the handlers for code c are handlers[index[c]] to handlers[index[c+1]-1]
+    // they point into the multimaps above so are rebuilt whenever a handler is added or removed
+    struct DispatchTable {
+        std::vector<uint8_t> index;
+        std::vector<const Handler_t*> handlers;
+        bool build(const Handlers_t& h);
+        void clear() { index.clear(); handlers.clear(); }
+    };
+    DispatchTable gcode_table;
+    DispatchTable mcode_table;
+    MotionHandler_t motion_handler{nullptr};
+    bool tables_built{false};
     bool grbl_mode{false};
 };
 
@@ -2,6 +2,8 @@
 
 #include "OutputStream.h"
 
+#include <string.h>
+
 GCode::GCode()
 {
 	clear();
@@ -16,11 +18,44 @@ void GCode::clear()
 	is_immediate= false;
 	is_error= false;
 	error_message= nullptr;
-	argbitmap= 0;
 	args.clear();
 	code= subcode= 0;
 }
 
+bool GCode::Args_t::set(char c, float f)
+{
+	size_t i= slot(c);
+	if((bitmap & bit(c)) == 0) {
+		size_t n= size();
+		if(n >= MAX_ARGS) return false;
+		// make room for it in letter order
+		memmove(&values[i + 1], &values[i], (n - i) * sizeof(float));
+		bitmap |= bit(c);
+	}
+	values[i]= f;
+	return true;
+}
+
+void GCode::Args_t::erase(char c)
+{
+	if((bitmap & bit(c)) == 0) return;
+	size_t i= slot(c);
+	memmove(&values[i], &values[i + 1], (size() - i - 1) * sizeof(float));
+	bitmap &= ~bit(c);
+}
+
+float& GCode::Args_t::operator[](char c)
+{
+	// like std::map it adds the letter with a value of 0 if it is not there
+	if((bitmap & bit(c)) == 0 && !set(c, 0)) {
+		// there is no room for it, so it is not kept
+		static float none;
+		none= 0;
+		return none;
+	}
+	return values[slot(c)];
+}
+
 bool GCode::dump(OutputStream &o) const
 {
 	o.printf("%s%u", is_g?"G":is_m?"M":"", code);
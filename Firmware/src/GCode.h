@@ -1,8 +1,10 @@
 #pragma once
 
-#include <map>
 #include <stdint.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <iterator>
+#include <utility>
 
 class OutputStream;
 
@@ -14,10 +16,69 @@ public:
 
 	void clear();
 
-	using Args_t = std::map<char,float>;
+	// the most argument letters one G or M code can have
+	static const size_t MAX_ARGS= 12;
 
-	bool has_arg(char c) const { return (argbitmap & (1<<(c-'A'))) != 0; }
-	bool has_no_args() const { return argbitmap == 0; }
+	// the values of the argument letters given, held in letter order with a bit per letter set if it was given,
+	// so parsing a word does not allocate and only the letters given take room. The value of a letter is at the
+	// number of bits set below its bit. Iterates over the (letter, value) pairs in letter order like the std::map it replaced
+	class Args_t
+	{
+	public:
+		Args_t() : bitmap(0) {}
+
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::pair<char, float>;
+			using difference_type = ptrdiff_t;
+			using pointer = const value_type*;
+			using reference = const value_type&;
+
+			const_iterator(const Args_t *a, uint32_t b) : args(a), bits(b), index(0) { load(); }
+			reference operator*() const { return current; }
+			pointer operator->() const { return &current; }
+			const_iterator& operator++() { bits &= bits - 1; ++index; load(); return *this; }
+			const_iterator operator++(int) { const_iterator t(*this); ++(*this); return t; }
+			bool operator==(const const_iterator& o) const { return bits == o.bits; }
+			bool operator!=(const const_iterator& o) const { return bits != o.bits; }
+
+		private:
+			void load()
+			{
+				if(bits != 0) current = value_type('A' + __builtin_ctz(bits), args->values[index]);
+			}
+			const Args_t *args;
+			uint32_t bits; // the letters not reached yet
+			int index;
+			value_type current;
+		};
+
+		const_iterator begin() const { return const_iterator(this, bitmap); }
+		const_iterator end() const { return const_iterator(this, 0); }
+		size_t size() const { return __builtin_popcount(bitmap); }
+		bool empty() const { return bitmap == 0; }
+		void clear() { bitmap = 0; }
+		size_t count(char c) const { return (bitmap & bit(c)) != 0 ? 1 : 0; }
+		void erase(char c);
+		float at(char c) const { return (bitmap & bit(c)) != 0 ? values[slot(c)] : 0; }
+		float& operator[](char c);
+		// returns false if the letter is new and there are already MAX_ARGS
+		bool set(char c, float f);
+
+	private:
+		friend class GCode;
+		static uint32_t bit(char c) { return 1UL << (c - 'A'); }
+		size_t slot(char c) const { return __builtin_popcount(bitmap & (bit(c) - 1)); }
+
+		// one bit per argument letter, for quick lookup to see if a specific argument is specified
+		uint32_t bitmap;
+		float values[MAX_ARGS];
+	};
+
+	bool has_arg(char c) const { return (args.bitmap & Args_t::bit(c)) != 0; }
+	bool has_no_args() const { return args.bitmap == 0; }
 	float get_arg(char c) const { return args.at(c); }
 	int get_int_arg(char c) const { return (int)args.at(c); }
 	const Args_t& get_args() const { return args; }
@@ -35,19 +96,14 @@ public:
 	uint16_t get_subcode() const { return subcode; }
 
 	GCode& set_command(char c, uint16_t cd, uint16_t scode=0) { is_g= c=='G'; is_m= c=='M'; this->code= cd; this->subcode= scode; return *this; }
-	GCode& add_arg(char c, float f) { args[c]= f; set_arg(c); return *this; }
+	GCode& add_arg(char c, float f) { args.set(c, f); return *this; }
 
 	bool dump(OutputStream&) const;
 	bool dump(FILE*) const;
 	//friend std::ostream& operator<<(std::ostream& o, const GCode& f) { f.dump(); return o; }
 
 private:
-	void set_arg(char c) { argbitmap |= (1<<(c-'A')); }
-
-	// one bit per argument letter, for quick lookup to see if a specific argument is specified
-	uint64_t argbitmap;
-
-	// map of actual argument/value pairs
+	// the actual argument values
 	Args_t args;
 	uint16_t code, subcode;
 	const char *error_message;
@@ -4,8 +4,6 @@
 #include "GCode.h"
 #include "nist_float.h"
 
-#include <map>
-#include <vector>
 #include <stdint.h>
 #include <ctype.h>
 #include <cmath>
@@ -125,6 +123,12 @@ bool GCodeProcessor::parse(const char *line, GCodes_t& gcodes)
 
         // see if we have another G or M code on the same line
         if((c == 'G' || c == 'M') && !start) {
+            if(gcodes.size() + 1 >= gcodes.max_size()) {
+                // need to leave room for this one
+                gc.set_error("Too many commands on line");
+                gcodes.push_back(gc);
+                return false;
+            }
             gcodes.push_back(gc);
             gc.clear();
             start = true;
@@ -179,6 +183,11 @@ bool GCodeProcessor::parse(const char *line, GCodes_t& gcodes)
         // parse argument word (X-1.23)
         char *np;
         float f = parse_float(p, &np);
+        if(!gc.has_arg(c) && gc.get_num_args() >= GCode::MAX_ARGS) {
+            gc.set_error("Too many parameters");
+            gcodes.push_back(gc);
+            return false;
+        }
         gc.add_arg(c, f);
         p= np;
     }
@@ -1,9 +1,9 @@
 #pragma once
 
-#include <vector>
 #include <tuple>
 
 #include "GCode.h"
+#include "FixedVector.h"
 
 class GCodeProcessor
 {
@@ -11,11 +11,14 @@ public:
 	GCodeProcessor();
 	~GCodeProcessor();
 
-	using GCodes_t = std::vector<GCode>;
+	// the most G and M codes there can be on one line
+	static const size_t MAX_GCODES_PER_LINE= 8;
+	using GCodes_t = FixedVector<GCode, MAX_GCODES_PER_LINE>;
 
 	bool parse(const char *line, GCodes_t& gcodes);
 	int get_line_number() const { return line_no; }
 	static int get_group1_modal_code() { return group1.get_code(); }
+	static void set_group1_modal_code(uint16_t code) { group1.set_command('G', code); }
     static std::tuple<uint16_t, uint16_t> parse_code(const char *&p);
 
 private:
@@ -0,0 +1,50 @@
+#include "BilinearGrid.h"
+
+#include <stdlib.h>
+
+BilinearGrid::~BilinearGrid()
+{
+    free(patches);
+}
+
+bool BilinearGrid::allocate(int max_points)
+{
+    free(patches);
+    // a grid of n points never has more than n cells
+    patches = (patch_t *)malloc(max_points * sizeof(patch_t));
+    max_cells = patches == nullptr ? 0 : max_points;
+    return patches != nullptr;
+}
+
+void BilinearGrid::set(const float *grid, int nx, int ny, float x_start, float y_start, float x_size, float y_size)
+{
+    cells_x = nx - 1;
+    last_x = nx - 2;
+    last_y = ny - 2;
+    if(cells_x * (ny - 1) > max_cells) return; // can't happen when allocated for the configured grid
+
+    this->x_start = x_start;
+    this->y_start = y_start;
+    x_scale = (nx - 1) / x_size;
+    y_scale = (ny - 1) / y_size;
+
+    // size may be negative
+    min_x = std::min(x_start, x_start + x_size);
+    max_x = std::max(x_start, x_start + x_size);
+    min_y = std::min(y_start, y_start + y_size);
+    max_y = std::max(y_start, y_start + y_size);
+
+    for (int y = 0; y <= last_y; ++y) {
+        for (int x = 0; x <= last_x; ++x) {
+            float z1 = grid[x + y * nx];
+            float z2 = grid[x + (y + 1) * nx];
+            float z3 = grid[(x + 1) + y * nx];
+            float z4 = grid[(x + 1) + (y + 1) * nx];
+            patch_t& p = patches[x + y * cells_x];
+            p.a = z1;
+            p.b = z3 - z1;
+            p.c = z2 - z1;
+            p.d = z1 - z2 - z3 + z4;
+        }
+    }
+}
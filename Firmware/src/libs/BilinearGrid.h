@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+
+/*
+ * Bilinear interpolation of the heights of a rectangular grid of probed points.
+ *
+ * The coefficients of the bilinear patch of each cell are worked out once when the grid is set,
+ * and kept together per cell, so getting a height is one lookup of the cell and a couple of
+ * multiply adds instead of fetching four points from two rows and interpolating them each time.
+ */
+class BilinearGrid
+{
+public:
+    BilinearGrid() {}
+    ~BilinearGrid();
+
+    // room for the cells of a grid of up to max_points points, returns false if out of memory
+    bool allocate(int max_points);
+
+    // grid is nx by ny heights, x first, the points are spaced evenly from start to start + size
+    void set(const float *grid, int nx, int ny, float x_start, float y_start, float x_size, float y_size);
+
+    // the height at x, y, points outside the grid get the height of the nearest edge
+    float get_z(float x, float y) const
+    {
+        float gx = (std::min(std::max(x, min_x), max_x) - x_start) * x_scale;
+        float gy = (std::min(std::max(y, min_y), max_y) - y_start) * y_scale;
+        if(gx < 0.001F) gx = 0.001F;
+        if(gy < 0.001F) gy = 0.001F;
+        int ix = std::min((int)gx, last_x);
+        int iy = std::min((int)gy, last_y);
+        float u = gx - ix;
+        float v = gy - iy;
+        const patch_t& p = patches[ix + iy * cells_x];
+        return p.a + u * p.b + v * (p.c + u * p.d);
+    }
+
+private:
+    // z= a + b*u + c*v + d*u*v, with u and v from 0 to 1 across the cell
+    struct patch_t { float a, b, c, d; };
+
+    patch_t *patches{nullptr};
+    int max_cells{0};
+    int cells_x{0}, last_x{0}, last_y{0};
+    float x_start{0}, y_start{0};
+    float x_scale{0}, y_scale{0};   // cells per mm
+    float min_x{0}, max_x{0}, min_y{0}, max_y{0};
+};
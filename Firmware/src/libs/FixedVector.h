@@ -0,0 +1,48 @@
+//
+//  Simple fixed capacity vector, the elements are held inline so it never allocates.
+//  Has the subset of the std::vector interface that is needed.
+//
+
+#pragma once
+
+#include <stddef.h>
+
+template <class kind, size_t capacity>
+class FixedVector
+{
+public:
+    FixedVector() : count(0) {}
+
+    using iterator = kind*;
+    using const_iterator = const kind*;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == capacity; }
+    static constexpr size_t max_size() { return capacity; }
+    void clear() { count = 0; }
+
+    // returns false if there is no room, the caller should check full() first
+    bool push_back(const kind& k)
+    {
+        if(full()) return false;
+        items[count++] = k;
+        return true;
+    }
+
+    void pop_back() { if(count > 0) --count; }
+
+    kind& back() { return items[count - 1]; }
+    const kind& back() const { return items[count - 1]; }
+    kind& operator[](size_t i) { return items[i]; }
+    const kind& operator[](size_t i) const { return items[i]; }
+
+    iterator begin() { return items; }
+    iterator end() { return items + count; }
+    const_iterator begin() const { return items; }
+    const_iterator end() const { return items + count; }
+
+private:
+    kind items[capacity];
+    size_t count;
+};
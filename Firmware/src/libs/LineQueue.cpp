@@ -0,0 +1,117 @@
+#include "LineQueue.h"
+
+#include "BinaryGCode.h"
+#include "MemoryPool.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+LineQueue::LineQueue(uint8_t max_channels, uint8_t lines_per_channel, MemoryPool *pool)
+{
+    this->pool = pool;
+    this->max_channels = max_channels;
+    ring_size = lines_per_channel + 1;
+    channels = new channel_t[max_channels];
+    held_size = max_channels * lines_per_channel;
+    held = new uint8_t[held_size];
+}
+
+LineQueue::~LineQueue()
+{
+    for (uint8_t i = 0; i < max_channels; ++i) {
+        line_t *l = channels[i].lines;
+        if(l == nullptr) continue;
+        if(pool != nullptr && pool->has(l)) pool->dealloc(l);
+        else free(l);
+    }
+    delete [] channels;
+    delete [] held;
+}
+
+int LineQueue::add_channel()
+{
+    uint8_t ch = nchannels.fetch_add(1);
+    if(ch >= max_channels) {
+        nchannels.store(max_channels);
+        return -1;
+    }
+
+    // the ring goes in the pool if there is room
+    line_t *l = pool == nullptr ? nullptr : (line_t *)pool->alloc(ring_size * sizeof(line_t));
+    if(l == nullptr) {
+        l = (line_t *)malloc(ring_size * sizeof(line_t));
+        if(l == nullptr) return -1;
+    }
+    channels[ch].lines = l;
+
+    // the command thread only looks at the channel once it is set up
+    channels[ch].active.store(true, std::memory_order_release);
+    return ch;
+}
+
+bool LineQueue::send(int ch, const char *line, OutputStream *os, bool priority)
+{
+    channel_t& c = channels[ch];
+    uint16_t h = c.head.load(std::memory_order_relaxed);
+    uint16_t n = (h + 1) % ring_size;
+    if(n == c.tail.load(std::memory_order_acquire)) return false;
+
+    line_t& l = c.lines[h];
+    if(line[0] == BinaryGCode::STX && (uint8_t)line[1] <= BinaryGCode::MAX_PAYLOAD) {
+        // a binary record (STX len payload) can have nuls in it
+        memcpy(l.line, line, (uint8_t)line[1] + 2);
+    } else {
+        strcpy(l.line, line);
+    }
+    l.os = os;
+    l.priority = priority;
+
+    c.head.store(n, std::memory_order_release);
+    return true;
+}
+
+size_t LineQueue::space(int ch) const
+{
+    const channel_t& c = channels[ch];
+    uint16_t h = c.head.load(std::memory_order_relaxed);
+    uint16_t t = c.tail.load(std::memory_order_acquire);
+    return ring_size - 1 - ((h + ring_size - t) % ring_size);
+}
+
+bool LineQueue::receive(char **line, OutputStream **os)
+{
+    // a priority line goes first, otherwise the first channel in turn that has a line
+    int ch = -1;
+    for (uint8_t i = 0; i < max_channels; ++i) {
+        uint8_t k = (next_channel + i) % max_channels;
+        channel_t& c = channels[k];
+        if(!c.active.load(std::memory_order_acquire)) continue;
+        if(c.next == c.head.load(std::memory_order_acquire)) continue;
+        if(c.lines[c.next].priority) {
+            ch = k;
+            break;
+        }
+        if(ch < 0) ch = k;
+    }
+
+    if(ch < 0) return false;
+
+    next_channel = (ch + 1) % max_channels;
+    channel_t& c = channels[ch];
+    *line = c.lines[c.next].line;
+    *os = c.lines[c.next].os;
+    c.next = (c.next + 1) % ring_size;
+    held[(held_first + held_count++) % held_size] = ch;
+    return true;
+}
+
+int LineQueue::release()
+{
+    if(held_count == 0) return -1;
+    uint8_t ch = held[held_first];
+    channel_t& c = channels[ch];
+    held_first = (held_first + 1) % held_size;
+    --held_count;
+    c.tail.store((c.tail.load(std::memory_order_relaxed) + 1) % ring_size, std::memory_order_release);
+    return ch;
+}
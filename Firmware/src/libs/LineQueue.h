@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+class OutputStream;
+class MemoryPool;
+
+/*
+ * The lines waiting for the command thread, in a ring for each channel that sends lines.
+ *
+ * A channel only ever has one task sending to it and the command thread is the only receiver, so
+ * each ring is single producer single consumer and needs no lock. A line is copied into its ring
+ * when sent and is processed in place until the command thread releases it.
+ *
+ * The command thread takes a line from each channel in turn so one channel streaming a file can not
+ * hold up the others. A channel whose next line is a priority line (jogging, suspend) is served first,
+ * the lines of one channel are always received in the order they were sent.
+ */
+class LineQueue
+{
+public:
+    static const size_t LINE_SIZE = 132;
+
+    // the rings are allocated from pool if there is room in it, otherwise from the heap
+    LineQueue(uint8_t max_channels, uint8_t lines_per_channel, MemoryPool *pool= nullptr);
+    ~LineQueue();
+
+    // returns the new channel or -1 if there are no more, safe to call from several tasks
+    int add_channel();
+
+    // only called by the task that sends to the channel, false if it is full
+    bool send(int ch, const char *line, OutputStream *os, bool priority);
+    size_t space(int ch) const;
+
+    // only called by the command thread, the line stays valid until it is released
+    bool receive(char **line, OutputStream **os);
+    // releases the oldest line received, returns its channel or -1 if none are held
+    int release();
+
+private:
+    using line_t = struct {
+        char line[LINE_SIZE];
+        OutputStream *os;
+        bool priority;
+    };
+
+    struct channel_t {
+        line_t *lines{nullptr};             // ring of lines_per_channel + 1 with one slot always empty
+        std::atomic<uint16_t> head{0};      // next line to be sent, only written by the sender
+        std::atomic<uint16_t> tail{0};      // oldest line not yet released, only written by the command thread
+        uint16_t next{0};                   // next line to be received
+        std::atomic<bool> active{false};
+    };
+
+    channel_t *channels;
+    std::atomic<uint8_t> nchannels{0};
+    MemoryPool *pool;
+    uint8_t max_channels;
+    uint16_t ring_size;         // 16 bits as lines_per_channel + 1 does not fit in 8 when it is 255
+
+    // channel of each line the command thread holds, oldest first
+    uint8_t *held;
+    uint16_t held_size;
+    uint16_t held_first{0};
+    uint16_t held_count{0};
+
+    uint8_t next_channel{0};    // round robin start
+};
@@ -1,4 +1,5 @@
 #include "MemoryPool.h"
+#include "SlabAllocator.h"
 #include "OutputStream.h"
 
 #include "FreeRTOS.h" // defines public interface we're implementing here
@@ -10,6 +11,13 @@
     #define MDEBUG(...)
 #endif
 
+// heap corruption is fatal, stop in the debugger (or abort when run on a host)
+#ifdef __arm__
+    #define HEAP_CORRUPTED() __asm("bkpt #0")
+#else
+    #define HEAP_CORRUPTED() abort()
+#endif
+
 class AutoLock
 {
 public:
@@ -17,20 +25,38 @@ public:
     ~AutoLock(){ xTaskResumeAll(); }
 };
 
+// small objects come from the slab if there is one, everything else from malloc
+void* operator new(size_t nbytes)
+{
+    SlabAllocator* slab = SlabAllocator::getInstance();
+    if (slab != NULL && nbytes <= SlabAllocator::max_size)
+    {
+        void* p = slab->alloc(nbytes);
+        if (p != NULL) return p;
+    }
+
+    return malloc(nbytes);
+}
+
 // this catches all usages of delete blah. The object's destructor is called before we get here
-// it first checks if the deleted object is part of a pool, and uses free otherwise.
+// it first checks if the deleted object is from the slab or part of a pool, and uses free otherwise.
 void  operator delete(void* p)
 {
-    MemoryPool* m = MemoryPool::first;
-    while (m)
+    if (p == NULL) return;
+
+    SlabAllocator* slab = SlabAllocator::getInstance();
+    if (slab != NULL && slab->has(p))
     {
-        if (m->has(p))
-        {
-            MDEBUG("Pool %p has %p, using dealloc()\n", m, p);
-            m->dealloc(p);
-            return;
-        }
-        m = m->next;
+        slab->dealloc(p);
+        return;
+    }
+
+    MemoryPool* m = MemoryPool::find(p);
+    if (m != NULL)
+    {
+        MDEBUG("Pool %p has %p, using dealloc()\n", m, p);
+        m->dealloc(p);
+        return;
     }
 
     MDEBUG("no pool has %p, using free()\n", p);
@@ -49,6 +75,8 @@ typedef struct __attribute__ ((packed))
 } _poolregion;
 
 MemoryPool* MemoryPool::first = NULL;
+void* MemoryPool::lowest = NULL;
+void* MemoryPool::highest = NULL;
 
 MemoryPool::MemoryPool(void* _base, uint32_t _size)
 {
@@ -61,6 +89,7 @@ MemoryPool::MemoryPool(void* _base, uint32_t _size)
     // insert ourselves into head of LL
     next = first;
     first = this;
+    update_range();
 }
 
 MemoryPool::~MemoryPool()
@@ -71,6 +100,7 @@ MemoryPool::~MemoryPool()
     if (first == this)
     {   // special case: we're first
         first = this->next;
+        update_range();
         return;
     }
 
@@ -81,15 +111,42 @@ MemoryPool::~MemoryPool()
         if (m->next == this)
         {
             m->next = next;
+            update_range();
             return;
         }
         m = m->next;
     }
 }
 
+// the range of addresses covered by all the pools
+void MemoryPool::update_range()
+{
+    lowest = highest = NULL;
+    for (MemoryPool* m = first; m != NULL; m = m->next)
+    {
+        void* e = ((uint8_t*) m->base) + m->size;
+        if (lowest == NULL || m->base < lowest) lowest = m->base;
+        if (highest == NULL || e > highest) highest = e;
+    }
+}
+
+MemoryPool* MemoryPool::find(void* p)
+{
+    // most deletes are of heap memory which is not in any pool
+    if (p < lowest || p >= highest) return NULL;
+
+    // there are only ever a few pools
+    for (MemoryPool* m = first; m != NULL; m = m->next)
+    {
+        if (m->has(p)) return m;
+    }
+
+    return NULL;
+}
+
 void* MemoryPool::alloc(size_t nbytes)
 {
-    AutoLock lock();
+    AutoLock lock;
 
     // nbytes = ceil(nbytes / 4) * 4
     if (nbytes & 3)
@@ -131,10 +188,13 @@ void* MemoryPool::alloc(size_t nbytes)
                 {
                     // captain, we have a problem!
                     // this can only happen if something has corrupted our heap, since we should simply fail to find a free block if it's full
-                    __asm("bkpt #0");
+                    HEAP_CORRUPTED();
                 }
             }
 
+            used += p->next;
+            if (used > max_used) max_used = used;
+
             // then return the data region for the block
             return &p->data;
         }
@@ -146,14 +206,16 @@ void* MemoryPool::alloc(size_t nbytes)
     } while (p < (_poolregion*) (((uint8_t*)base) + size));
 
     // fell off the end of the region!
+    failed++;
     return NULL;
 }
 
 void MemoryPool::dealloc(void* d)
 {
-    AutoLock lock();
+    AutoLock lock;
     _poolregion* p = (_poolregion*) (((uint8_t*) d) - sizeof(_poolregion));
     p->used = 0;
+    used -= p->next;
 
     MDEBUG("\tdeallocating %p (%+d, %db)\n", p, offset(p), p->next);
 
@@ -173,7 +235,7 @@ void MemoryPool::dealloc(void* d)
         {
             // captain, we have a problem!
             // this can only happen if something has corrupted our heap, since we should simply fail to find a free block if it's full
-            __asm("bkpt #0");
+            HEAP_CORRUPTED();
         }
 
         p->next += q->next;
@@ -197,7 +259,7 @@ void MemoryPool::dealloc(void* d)
                 {
                     // captain, we have a problem!
                     // this can only happen if something has corrupted our heap, since we should simply fail to find a free block if it's full
-                    __asm("bkpt #0");
+                    HEAP_CORRUPTED();
                 }
             }
 
@@ -234,7 +296,7 @@ void MemoryPool::debug(OutputStream& os)
             free += p->next;
         if ((offset(p) + p->next >= size) || (p->next <= sizeof(_poolregion)))
         {
-            os.printf("End: total %lub, free: %lub\n", tot, free);
+            os.printf("End: total %lub, free: %lub, max used: %lub, failed allocs: %lu\n", tot, free, max_used, failed);
             return;
         }
         p = (_poolregion*) (((uint8_t*) p) + p->next);
@@ -263,6 +325,25 @@ uint32_t MemoryPool::available()
     } while (1);
 }
 
+uint32_t MemoryPool::largest_free()
+{
+    uint32_t largest = 0;
+
+    _poolregion* p = (_poolregion*) base;
+
+    do {
+        if (p->used == 0 && p->next > largest)
+            largest = p->next;
+        if (offset(p) + p->next >= size)
+            break;
+        if (p->next <= sizeof(_poolregion))
+            break;
+        p = (_poolregion*) (((uint8_t*) p) + p->next);
+    } while (1);
+
+    return largest;
+}
+
 // convenience routines to allow alloc/dealloc in _RAMx from C
 #include "main.h"
 
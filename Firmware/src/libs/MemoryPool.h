@@ -22,15 +22,31 @@ public:
     void  debug(OutputStream&);
     bool  has(void*);
     uint32_t available(void);
+    uint32_t largest_free(void); // size of the largest free block including its header, like available()
     uint32_t get_size(void) const { return size; };
+    uint32_t get_max_used(void) const { return max_used; };
+    uint32_t get_failed(void) const { return failed; };
+
+    // returns the pool p was allocated from or NULL, memory outside all the pools is rejected
+    // by one range check so deleting heap memory does not have to ask each pool
+    static MemoryPool* find(void* p);
 
     MemoryPool* next;
 
     static MemoryPool* first;
 
 private:
+    static void update_range();
+    static void* lowest;
+    static void* highest;
+
     void* base;
     uint32_t size;
+
+    // stats
+    uint32_t used{0};
+    uint32_t max_used{0};
+    uint32_t failed{0};
 };
 
 // this overloads "placement new"
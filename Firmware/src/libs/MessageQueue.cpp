@@ -1,45 +1,118 @@
 #include "MessageQueue.h"
+#include "LineQueue.h"
 #include "OutputStream.h"
+#include "main.h"
+
+#include "task.h"
+#include "semphr.h"
 
 #include <string.h>
+#include <stdlib.h>
+
+static_assert(LineQueue::LINE_SIZE == MAX_LINE_LENGTH, "line sizes must match");
 
-static QueueHandle_t queue_handle;
+// Each task that sends lines gets its own channel in the line queue the first time it sends, so a
+// task that is waiting for room in its channel does not hold up the other tasks. A task that exits
+// frees its channel with release_message_channel() and the next new task to send reuses it.
+#define MAX_CHANNELS 8
+static LineQueue *line_queue;
+static SemaphoreHandle_t lines_waiting;             // counts the lines the command thread has not received
+static TaskHandle_t channel_task[MAX_CHANNELS];     // the task that sends to each channel
+static SemaphoreHandle_t channel_room[MAX_CHANNELS]; // given when a line of the channel is released
+static uint8_t channel_size= 0;
 
-bool create_message_queue()
+bool create_message_queue(uint8_t size)
 {
-    // create queue for dispatch of lines, can be sent to by several tasks
-    queue_handle = xQueueCreate( 10, sizeof( comms_msg_t ) );
-    if( queue_handle == 0 ) {
-        // Failed to create the queue.
+    // the lines go in RAM3 if there is room
+    line_queue= new LineQueue(MAX_CHANNELS, size, _RAM3);
+    channel_size= size;
+    lines_waiting= xSemaphoreCreateCounting(MAX_CHANNELS * size, 0);
+    if(line_queue == nullptr || lines_waiting == 0) {
         printf("ERROR: failed to create dispatch queue\n");
-       	return false;
+        return false;
     }
 
     return true;
 }
 
-QueueHandle_t get_message_queue()
+// the channel of the calling task, it is added if the task has not sent before
+static int get_channel()
+{
+    TaskHandle_t t= xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < MAX_CHANNELS; ++i) {
+        if(channel_task[i] == t) return i;
+    }
+
+    // reuse a freed channel, it only ever has the one sender so any lines the task that freed it
+    // left in it are still received before the lines of this task
+    int ch= -1;
+    taskENTER_CRITICAL();
+    for (int i = 0; i < MAX_CHANNELS; ++i) {
+        if(channel_task[i] == nullptr && channel_room[i] != nullptr) {
+            channel_task[i]= t;
+            ch= i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+    if(ch >= 0) return ch;
+
+    // only this task can add its channel so it can not be added twice
+    SemaphoreHandle_t room= xSemaphoreCreateBinary();
+    ch= line_queue->add_channel();
+    if(ch < 0 || room == 0) {
+        printf("ERROR: no more dispatch channels\n");
+        return -1;
+    }
+    // the task is set first so the channel is not seen as free
+    channel_task[ch]= t;
+    channel_room[ch]= room;
+    return ch;
+}
+
+// called by a task that has sent lines before it exits so its channel can be reused
+void release_message_channel()
 {
-	return queue_handle;
+    TaskHandle_t t= xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < MAX_CHANNELS; ++i) {
+        if(channel_task[i] == t) channel_task[i]= nullptr;
+    }
+}
+
+// lines that jump ahead of the lines from other channels
+static bool is_priority_line(const char *line)
+{
+    return strncmp(line, "$J", 2) == 0 || strncmp(line, "suspend", 7) == 0 ||
+           strncmp(line, "abort", 5) == 0 || strncmp(line, "M600", 4) == 0;
 }
 
 int get_message_queue_space()
 {
-    return uxQueueSpacesAvailable(queue_handle);
+    int ch= get_channel();
+    if(ch < 0) return 0;
+    return line_queue->space(ch);
 }
 
 // can be called by several threads to submit messages to the dispatcher
-// the line is copied into the message so can be on the stack
-// This call will block until there is room in the queue unless wait is false
+// the line is copied into the channel of the calling thread so can be on the stack
+// This call will block until there is room in the channel unless wait is false
 // in which case it will only wait for 100ms
 bool send_message_queue(char *pline, OutputStream *pos, bool wait)
 {
-    comms_msg_t msg_buffer;
-	strcpy(msg_buffer.pline, pline);
-	msg_buffer.pos= pos;
+    int ch= get_channel();
+    if(ch < 0) return false;
+
+    bool priority= is_priority_line(pline);
     TickType_t waitms = wait ? portMAX_DELAY : pdMS_TO_TICKS(100);
-	BaseType_t r= xQueueSend( queue_handle, ( void * )&msg_buffer, waitms);
-    return r == pdTRUE;
+    while(!line_queue->send(ch, pline, pos, priority)) {
+        // a line of this channel has been released since the last give if it is taken straight away
+        if(xSemaphoreTake(channel_room[ch], waitms) != pdTRUE) {
+            return false;
+        }
+    }
+
+    xSemaphoreGive(lines_waiting);
+    return true;
 }
 
 bool send_message_queue(char *pline, void *pos)
@@ -48,17 +121,24 @@ bool send_message_queue(char *pline, void *pos)
 }
 
 // Only called by the command thread to receive incoming lines to process
-bool receive_message_queue(char **ppline, OutputStream **ppos)
+// the line returned is valid until it is released by release_message_queue()
+// if wait is false it returns immediately if there are no lines, otherwise it waits up to 100ms
+bool receive_message_queue(char **ppline, OutputStream **ppos, bool wait)
 {
-    const TickType_t waitms = pdMS_TO_TICKS( 100 );
-    static comms_msg_t msg_buffer;
-    if( xQueueReceive( queue_handle, &msg_buffer, waitms) ) {
-	    *ppline = msg_buffer.pline;
-	    *ppos = msg_buffer.pos;
-
-    }else{
-    	return false;
+    const TickType_t waitms = wait ? pdMS_TO_TICKS( 100 ) : 0;
+    if(line_queue == nullptr) return false;
+
+    if(xSemaphoreTake(lines_waiting, waitms) != pdTRUE) {
+        return false;
     }
 
-    return true;
+    // the line is always there as it is sent before the semaphore is given
+    return line_queue->receive(ppline, ppos);
+}
+
+// releases the oldest line received by the command thread so it can be reused
+void release_message_queue()
+{
+    int ch= line_queue->release();
+    if(ch >= 0) xSemaphoreGive(channel_room[ch]);
 }
@@ -3,22 +3,25 @@
 #include "FreeRTOS.h"
 #include "queue.h"
 
+#include <stdint.h>
+
 #define MAX_LINE_LENGTH 132
+#define DEFAULT_MESSAGE_QUEUE_SIZE 10
 #ifdef __cplusplus
 class OutputStream;
 using comms_msg_t = struct {char pline[MAX_LINE_LENGTH]; OutputStream *pos; };
 extern "C" {
+bool create_message_queue(uint8_t size= DEFAULT_MESSAGE_QUEUE_SIZE);
 bool send_message_queue(char *pline, OutputStream *pos, bool wait=true);
-bool receive_message_queue(char **ppline, OutputStream **ppos);
+bool receive_message_queue(char **ppline, OutputStream **ppos, bool wait=true);
+void release_message_queue();
 int get_message_queue_space();
+void release_message_channel();
 #else
 // for c calls
 bool send_message_queue(char *pline, void *pos);
 #endif
 
-bool create_message_queue();
-QueueHandle_t get_message_queue();
-
 #ifdef __cplusplus
 }
 #endif
@@ -1,4 +1,5 @@
 #include "OutputStream.h"
+#include "BinaryGCode.h"
 
 #include <cstdarg>
 #include <cstring>
@@ -7,8 +8,9 @@
 
 #include "FreeRTOS.h"
 #include "semphr.h"
+#include "task.h"
 
-OutputStream::OutputStream(wrfnc f) : deleteos(true)
+OutputStream::OutputStream(wrfnc f) : fnc(f), deleteos(true)
 {
 	clear_flags();
 	stop_request= false;
@@ -27,8 +29,65 @@ OutputStream::~OutputStream()
 		delete fdbuf;
 	if(xWriteMutex != nullptr)
 		vSemaphoreDelete(xWriteMutex);
+	free(obuf);
+	delete decoder;
 };
 
+BinaryGCode *OutputStream::get_decoder()
+{
+	if(decoder == nullptr) decoder= new BinaryGCode();
+	return decoder;
+}
+
+bool OutputStream::set_buffered(size_t size, uint32_t delay_ms)
+{
+	if(!fnc || obuf != nullptr || size == 0) return false;
+	obuf = (char *)malloc(size);
+	if(obuf == nullptr) return false;
+	obuf_size = size;
+	obuf_len = 0;
+	obuf_delay = pdMS_TO_TICKS(delay_ms);
+	return true;
+}
+
+// called with the write mutex held
+void OutputStream::flush_buffer()
+{
+	size_t len = obuf_len;
+	obuf_len = 0;
+	if(closed || len == 0) return;
+	// fnc is expected to write everything
+	if(fnc(obuf, len) != len) {
+		::printf("OutputStream error: write fnc failed\n");
+		closed = true;
+	}
+}
+
+bool OutputStream::is_due() const
+{
+	return obuf_len > 0 && (xTaskGetTickCount() - obuf_time) >= obuf_delay;
+}
+
+void OutputStream::flush()
+{
+	if(obuf == nullptr) return;
+	if(xWriteMutex != nullptr)
+		xSemaphoreTake(xWriteMutex, portMAX_DELAY);
+	flush_buffer();
+	if(xWriteMutex != nullptr)
+		xSemaphoreGive(xWriteMutex);
+}
+
+void OutputStream::flush_if_due()
+{
+	if(obuf == nullptr || obuf_len == 0) return;
+	if(xWriteMutex != nullptr)
+		xSemaphoreTake(xWriteMutex, portMAX_DELAY);
+	if(is_due()) flush_buffer();
+	if(xWriteMutex != nullptr)
+		xSemaphoreGive(xWriteMutex);
+}
+
 int OutputStream::flush_prepend()
 {
 	int n = prepending.size();
@@ -49,6 +108,23 @@ int OutputStream::write(const char *buffer, size_t size)
 		xSemaphoreTake(xWriteMutex, portMAX_DELAY);
 	if(prepend_ok) {
 		prepending.append(buffer, size);
+
+	} else if(obuf != nullptr) {
+		// buffered, so bypass the ostream and collect the output to be written out in one go
+		if(obuf_len + size > obuf_size) flush_buffer();
+		if(size >= obuf_size) {
+			// would not fit anyway
+			if(!closed && fnc(buffer, size) != size) {
+				::printf("OutputStream error: write fnc failed\n");
+				closed = true;
+			}
+		} else {
+			if(obuf_len == 0) obuf_time = xTaskGetTickCount();
+			memcpy(&obuf[obuf_len], buffer, size);
+			obuf_len = obuf_len + size;
+			if(obuf_len == obuf_size || is_due()) flush_buffer();
+		}
+
 	} else {
 		// this is expected to always write everything out
 		os->write(buffer, size);
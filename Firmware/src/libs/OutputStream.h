@@ -6,6 +6,8 @@
 #include <unistd.h>
 #include <functional>
 
+class BinaryGCode;
+
 /**
 	Handles an output stream from gcode/mcode handlers
 	can be told to append a NL at end, and also to prepend or postpend the ok
@@ -34,6 +36,17 @@ public:
 	bool is_prepend_ok() const { return prepend_ok; }
 	bool is_no_response() const { return no_response; }
 	int flush_prepend();
+
+	// hold the output in a buffer of size bytes and write it out in one go, when the buffer is full,
+	// when flush() is called, or on the next write or flush_if_due() once it has been held for delay_ms.
+	// only for a stream created with a write fnc, returns false if it is not or out of memory
+	bool set_buffered(size_t size, uint32_t delay_ms);
+	bool is_buffered() const { return obuf != nullptr; }
+	bool has_buffered_output() const { return obuf_len > 0; }
+	uint32_t get_buffer_delay() const { return obuf_delay; }
+	// write out any held output
+	void flush();
+	void flush_if_due();
 	void clear_flags() { append_nl= prepend_ok= no_response= done= false; }
 	void set_closed() { closed= true; }
 	bool is_closed() const { return closed; }
@@ -43,6 +56,8 @@ public:
     bool is_uploading() const { return uploading; }
     void set_stop_request(bool flg) { stop_request= flg; }
     bool get_stop_request() const { return stop_request; }
+    // the decoder for the binary records from this stream, made when the first one is received
+    BinaryGCode *get_decoder();
 
 private:
 	// Hack to allow us to create a ostream writing to a supplied write function
@@ -55,11 +70,23 @@ private:
 		OutputStream *parent;
 		wrfnc fnc;
 	};
+	void flush_buffer();
+	bool is_due() const;
+
 	void *xWriteMutex;
 
 	std::ostream *os;
 	FdBuf *fdbuf;
+	wrfnc fnc;
+
+	// output held in buffered mode
+	char *obuf{nullptr};
+	size_t obuf_size{0};
+	volatile size_t obuf_len{0};
+	uint32_t obuf_delay{0}; // ticks
+	uint32_t obuf_time{0};  // tick when the oldest output held was written
 	std::string prepending;
+	BinaryGCode *decoder{nullptr};
 	bool closed{false};
 	bool uploading{false};
 	struct {
@@ -0,0 +1,108 @@
+#include "PiecewiseLinearTable.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <limits>
+
+PiecewiseLinearTable::~PiecewiseLinearTable()
+{
+    free(points);
+}
+
+void PiecewiseLinearTable::clear()
+{
+    free(points);
+    points = nullptr;
+    npoints = 0;
+}
+
+bool PiecewiseLinearTable::build(uint32_t nx, std::function<float(uint32_t)> fnc, float max_error, uint16_t max_points)
+{
+    clear();
+    if(nx == 0 || nx > 65536 || max_points < 2) return false;
+
+    // the function is evaluated once for each x while finding the breakpoints
+    float *y = (float *)malloc(nx * sizeof(float));
+    if(y == nullptr) return false;
+    for (uint32_t x = 0; x < nx; ++x) {
+        y[x] = fnc(x);
+    }
+
+    // the first run of finite values
+    uint32_t lo = 0;
+    while(lo < nx && !isfinite(y[lo])) ++lo;
+    uint32_t hi = lo;
+    while(hi + 1 < nx && isfinite(y[hi + 1])) ++hi;
+    if(lo >= nx) {
+        free(y);
+        return false;
+    }
+
+    point_t *pts = (point_t *)malloc(max_points * sizeof(point_t));
+    if(pts == nullptr) {
+        free(y);
+        return false;
+    }
+
+    uint16_t n = 0;
+    uint32_t s = lo;
+    bool ok = true;
+    while(true) {
+        if(n >= max_points) {
+            ok = false;
+            break;
+        }
+        pts[n].x = s;
+        pts[n].y = y[s];
+        pts[n].slope = 0;
+        ++n;
+        if(s >= hi) break;
+
+        // extend the segment from s until a point between would be too far from the line
+        uint32_t e = s + 1;
+        while(e < hi) {
+            uint32_t ne = e + 1;
+            float slope = (y[ne] - y[s]) / (ne - s);
+            bool fits = true;
+            for (uint32_t x = s + 1; x < ne; ++x) {
+                if(fabsf(y[s] + slope * (x - s) - y[x]) > max_error) {
+                    fits = false;
+                    break;
+                }
+            }
+            if(!fits) break;
+            e = ne;
+        }
+
+        pts[n - 1].slope = (y[e] - y[s]) / (e - s);
+        s = e;
+    }
+
+    free(y);
+    if(!ok) {
+        free(pts);
+        return false;
+    }
+
+    // give back what was not needed
+    point_t *p = (point_t *)realloc(pts, n * sizeof(point_t));
+    points = p == nullptr ? pts : p;
+    npoints = n;
+    return true;
+}
+
+float PiecewiseLinearTable::get(uint32_t x) const
+{
+    if(npoints == 0 || x < points[0].x || x > points[npoints - 1].x) return std::numeric_limits<float>::infinity();
+
+    // the last breakpoint at or below x
+    int lo = 0, hi = npoints - 1;
+    while(lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if(points[mid].x <= x) lo = mid;
+        else hi = mid - 1;
+    }
+
+    const point_t& p = points[lo];
+    return p.y + p.slope * (x - p.x);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <utility>
+
+/*
+ * A piecewise linear approximation of a function of an integer, eg a temperature from an ADC reading.
+ *
+ * The function is evaluated for every input once when the table is built, and the breakpoints are
+ * placed as far apart as they can be while every input between them stays within max_error of the
+ * function, so steep parts of the curve get more points and flat parts fewer. Getting a value is then
+ * a binary search of the breakpoints and one multiply add.
+ */
+class PiecewiseLinearTable
+{
+public:
+    PiecewiseLinearTable() {}
+    ~PiecewiseLinearTable();
+
+    // approximates fnc for 0 <= x < nx over the first run of x for which fnc is finite,
+    // returns false if that needs more than max_points breakpoints, or out of memory
+    bool build(uint32_t nx, std::function<float(uint32_t)> fnc, float max_error, uint16_t max_points);
+    void clear();
+    // exchanges the breakpoints with o, the caller makes it atomic if the table is being read elsewhere
+    void swap(PiecewiseLinearTable& o) { std::swap(points, o.points); std::swap(npoints, o.npoints); }
+
+    // infinity for x outside the range where fnc was finite
+    float get(uint32_t x) const;
+
+    bool is_valid() const { return npoints > 0; }
+    uint16_t get_size() const { return npoints; }
+
+private:
+    struct point_t { uint16_t x; float y; float slope; };
+
+    point_t *points{nullptr};
+    uint16_t npoints{0};
+};
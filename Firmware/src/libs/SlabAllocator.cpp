@@ -0,0 +1,96 @@
+#include "SlabAllocator.h"
+#include "OutputStream.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+SlabAllocator* SlabAllocator::instance= nullptr;
+
+const uint16_t SlabAllocator::class_size[num_classes]= {8, 16, 24, 32, 48, 64, 96, 128};
+
+// size class for (nbytes+7)/8
+const uint8_t SlabAllocator::size_class[max_size/8 + 1]= {
+    0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7
+};
+
+SlabAllocator::SlabAllocator(void* _base, uint32_t _size)
+{
+    // blocks are 8 byte aligned
+    uintptr_t b= ((uintptr_t)_base + 7) & ~7;
+    _size -= b - (uintptr_t)_base;
+
+    // the page table goes at the start of the region
+    num_pages= _size / (page_size + 1);
+    page_class= (uint8_t*)b;
+    base= (uint8_t*)((b + num_pages + 7) & ~7);
+    if(base + num_pages * page_size > (uint8_t*)b + _size) --num_pages;
+    end= base + num_pages * page_size;
+
+    for (int i = 0; i < num_classes; ++i) {
+        free_list[i]= nullptr;
+        stats[i]= {0, 0, 0, 0};
+    }
+}
+
+// cuts the next free page into blocks of class c
+bool SlabAllocator::add_page(int c)
+{
+    if(pages_used >= num_pages) return false;
+
+    uint32_t n= pages_used++;
+    page_class[n]= c;
+    ++stats[c].pages;
+
+    uint32_t sz= class_size[c];
+    uint8_t* p= base + n * page_size;
+    uint8_t* e= p + (page_size / sz) * sz;
+    for (; p < e; p += sz) {
+        free_block_t* f= (free_block_t*)p;
+        f->next= free_list[c];
+        free_list[c]= f;
+    }
+
+    return true;
+}
+
+void* SlabAllocator::alloc(size_t nbytes)
+{
+    if(nbytes > max_size) return nullptr;
+
+    int c= size_class[(nbytes + 7) >> 3];
+    void* p= nullptr;
+
+    vTaskSuspendAll();
+    if(free_list[c] != nullptr || add_page(c)) {
+        free_block_t* f= free_list[c];
+        free_list[c]= f->next;
+        if(++stats[c].used > stats[c].max_used) stats[c].max_used= stats[c].used;
+        p= f;
+    } else {
+        ++stats[c].failed;
+    }
+    xTaskResumeAll();
+
+    return p;
+}
+
+void SlabAllocator::dealloc(void* d)
+{
+    int c= page_class[((uint8_t*)d - base) / page_size];
+    free_block_t* f= (free_block_t*)d;
+
+    vTaskSuspendAll();
+    f->next= free_list[c];
+    free_list[c]= f;
+    --stats[c].used;
+    xTaskResumeAll();
+}
+
+void SlabAllocator::debug(OutputStream& os)
+{
+    os.printf("Slab: %lu of %lu pages of %lu bytes used\n", pages_used, num_pages, page_size);
+    os.printf(" size  pages   used    max  failed\n");
+    for (int i = 0; i < num_classes; ++i) {
+        os.printf("%5u%7u%7lu%7lu%8lu\n", class_size[i], stats[i].pages, stats[i].used, stats[i].max_used, stats[i].failed);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+class OutputStream;
+
+/*
+ * Fixed size blocks for the small allocations that make up most of the heap traffic
+ * (strings, std::function captures, map and list nodes).
+ *
+ * The region is split into pages, a page is given to a size class the first time the class
+ * runs out and is then cut into blocks of that size which go on the class free list.
+ * alloc and dealloc are O(1), the size class of a block is found from the page it is in.
+ * Pages are never given back, so small allocations can not fragment the general heap.
+ */
+
+class SlabAllocator
+{
+public:
+    SlabAllocator(void* base, uint32_t size);
+
+    // returns NULL if nbytes is too big for a slab or the slab is full, the caller uses malloc then
+    void* alloc(size_t nbytes);
+    void  dealloc(void* p);
+    bool  has(void* p) const { return p >= base && p < end; }
+    void  debug(OutputStream&);
+
+    static const size_t max_size= 128;  // largest allocation served from a slab
+
+    // the slab used by operator new, there is none until this is called
+    static void set_instance(SlabAllocator* s) { instance= s; }
+    static SlabAllocator* getInstance() { return instance; }
+
+private:
+    static SlabAllocator* instance;
+
+    static const int num_classes= 8;
+    static const uint32_t page_size= 512;
+    static const uint16_t class_size[num_classes];
+    static const uint8_t size_class[max_size/8 + 1];
+
+    struct free_block_t { free_block_t* next; };
+
+    bool add_page(int c);
+
+    uint8_t* base;
+    uint8_t* end;           // end of the last whole page
+    uint8_t* page_class;    // size class of each page
+    uint32_t num_pages;
+    uint32_t pages_used{0};
+
+    free_block_t* free_list[num_classes];
+
+    struct {
+        uint32_t used;      // blocks in use
+        uint32_t max_used;
+        uint32_t failed;    // allocations that did not fit and went to malloc
+        uint16_t pages;
+    } stats[num_classes];
+};
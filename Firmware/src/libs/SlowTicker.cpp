@@ -1,5 +1,7 @@
 #include "SlowTicker.h"
 
+#include <stdio.h>
+
 
 // timers are specified in milliseconds
 #define BASE_FREQUENCY 1000
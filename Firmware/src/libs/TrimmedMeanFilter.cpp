@@ -0,0 +1,88 @@
+#include "TrimmedMeanFilter.h"
+
+#include <stdlib.h>
+
+TrimmedMeanFilter::~TrimmedMeanFilter()
+{
+    free(history);
+}
+
+bool TrimmedMeanFilter::init(uint8_t n, uint8_t trim)
+{
+    free(history);
+    history = sorted = nullptr;
+    size = 0;
+    if(n == 0 || 2 * trim >= n) return false;
+
+    // both windows in one allocation
+    history = (uint16_t *)malloc(2 * n * sizeof(uint16_t));
+    if(history == nullptr) return false;
+
+    sorted = history + n;
+    size = n;
+    this->trim = trim;
+    fill(0);
+    return true;
+}
+
+void TrimmedMeanFilter::fill(uint16_t v)
+{
+    for (int i = 0; i < size; ++i) {
+        history[i] = sorted[i] = v;
+    }
+    next = 0;
+    count = size;
+}
+
+void TrimmedMeanFilter::add(uint16_t v)
+{
+    if(count < size) {
+        // not full yet so nothing is replaced, just insert it in the sorted window
+        history[next] = v;
+        if(++next >= size) next = 0;
+        int i = count++;
+        while(i > 0 && sorted[i - 1] > v) {
+            sorted[i] = sorted[i - 1];
+            --i;
+        }
+        sorted[i] = v;
+        return;
+    }
+
+    uint16_t old = history[next];
+    history[next] = v;
+    if(++next >= size) next = 0;
+
+    // find the oldest sample in the sorted window
+    int lo = 0, hi = size - 1;
+    while(lo < hi) {
+        int mid = (lo + hi) / 2;
+        if(sorted[mid] < old) lo = mid + 1;
+        else hi = mid;
+    }
+
+    // and slide the new sample along from there to where it belongs
+    int i = lo;
+    if(v > old) {
+        while(i < size - 1 && sorted[i + 1] < v) {
+            sorted[i] = sorted[i + 1];
+            ++i;
+        }
+    } else {
+        while(i > 0 && sorted[i - 1] > v) {
+            sorted[i] = sorted[i - 1];
+            --i;
+        }
+    }
+    sorted[i] = v;
+}
+
+uint32_t TrimmedMeanFilter::get_sum() const
+{
+    uint32_t sum = 0;
+    int t = get_trim();
+    for (int i = t; i < count - t; ++i) {
+        sum += sorted[i];
+    }
+    return sum;
+}
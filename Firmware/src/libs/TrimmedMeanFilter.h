@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * A moving window of the last n samples kept both in the order they arrived and in sorted order.
+ *
+ * Each new sample replaces the oldest one in the sorted window by moving the entries between the
+ * two of them up or down by one, so adding a sample only touches as many entries as the value
+ * changed by in rank, and the trimmed sum or the median are read straight from the sorted window
+ * without copying and sorting all the samples each time.
+ *
+ * After clear() the window only holds the samples added since, until it is full again the trim is
+ * scaled down to the number of samples it has.
+ */
+class TrimmedMeanFilter
+{
+public:
+    TrimmedMeanFilter() {}
+    ~TrimmedMeanFilter();
+
+    // a window of n samples (up to 255) with trim samples dropped from each end, returns false if out of memory
+    bool init(uint8_t n, uint8_t trim);
+    // fill the window with v
+    void fill(uint16_t v);
+    // empty the window, it then fills up again from the samples added
+    void clear() { count = 0; next = 0; }
+    void add(uint16_t v);
+
+    // the sum of the samples left in the sorted window after the trim at both ends
+    uint32_t get_sum() const;
+    // the number of samples in the sum
+    uint8_t get_count() const { return count - 2 * get_trim(); }
+    uint16_t get_median() const { return sorted[count / 2]; }
+    uint8_t get_size() const { return size; }
+    // the number of samples in the window
+    uint8_t get_samples() const { return count; }
+    bool is_valid() const { return sorted != nullptr; }
+
+private:
+    uint8_t get_trim() const { return count * trim / size; }
+
+    uint16_t *history{nullptr}; // the samples in the order they were added
+    uint16_t *sorted{nullptr};
+    uint8_t size{0};
+    uint8_t trim{0};
+    uint8_t next{0};            // the oldest sample in history
+    uint8_t count{0};           // samples in the window, size once it is full
+};
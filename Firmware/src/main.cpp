@@ -25,8 +25,10 @@
 #include "Module.h"
 #include "OutputStream.h"
 #include "MessageQueue.h"
+#include "SlabAllocator.h"
 #include "GCode.h"
 #include "GCodeProcessor.h"
+#include "BinaryGCode.h"
 #include "Dispatcher.h"
 #include "Robot.h"
 #include "RingBuffer.h"
@@ -37,7 +39,12 @@
 static bool system_running= false;
 static bool rpi_port_enabled= false;
 static uint32_t rpi_baudrate= 115200;
+static uint8_t command_queue_size= DEFAULT_MESSAGE_QUEUE_SIZE;
 static Pin *aux_play_led = nullptr;
+// replies to the USB host are collected into this many bytes and sent when the command thread is idle,
+// the buffer is full, or they have been held for usb_reply_delay ms
+static uint16_t usb_reply_buffer= 256;
+static uint16_t usb_reply_delay= 10;
 
 // for ?, $I or $S queries
 // for ? then query_line will be nullptr
@@ -53,10 +60,14 @@ static std::string config_error_msg;
 
 // TODO maybe move to Dispatcher
 static GCodeProcessor gp;
+static bool binary_gcode= false;
 static bool loaded_configuration= false;
 static bool config_override= false;
 const char *OVERRIDE_FILE= "/sd/config-override";
 
+// size of the slab for small allocations, taken from RAM2
+#define SLAB_SIZE (16 * 1024)
+
 MemoryPool *_RAM2;
 MemoryPool *_RAM3;
 MemoryPool *_RAM4;
@@ -81,6 +92,12 @@ void setup_memory_pool()
     _RAM3= new MemoryPool(&__end_bss_RAM3, &__top_RAM3 - &__end_bss_RAM3);
     _RAM4= new MemoryPool(&__end_bss_RAM4, &__top_RAM4 - &__end_bss_RAM4);
     _RAM5= new MemoryPool(&__end_bss_RAM5, &__top_RAM5 - &__end_bss_RAM5);
+
+    // small allocations from new come from the slab in RAM2, so they do not fragment the heap
+    void *slab= _RAM2->alloc(SLAB_SIZE);
+    if(slab != nullptr) {
+        SlabAllocator::set_instance(new SlabAllocator(slab, SLAB_SIZE));
+    }
 }
 
 // load configuration from override file
@@ -115,9 +132,52 @@ static bool load_config_override(OutputStream& os)
     return true;
 }
 
+// true if dispatch_line() parses the line as gcode rather than handling it as a command
+static bool is_gcode_line(const char *line)
+{
+    if(islower(line[0]) || line[0] == '$') return false;
+    return !(strncmp(line, "M23 ", 4) == 0 || strncmp(line, "M30 ", 4) == 0 || strncmp(line, "M32 ", 4) == 0 ||
+             strncmp(line, "M117 ", 5) == 0 || strncmp(line, "M28 ", 4) == 0);
+}
+
+static bool dispatch_gcodes(OutputStream& os, const char *line, bool parsed_ok, int line_no, GCodeProcessor::GCodes_t& gcodes);
+
+// a record with no payload is queued in place of one that failed its CRC, so the decoder is
+// put out of sync in order with the records before it, it has already been replied to
+static bool is_lost_record(const char *line)
+{
+    return line[0] == BinaryGCode::STX && line[1] == 0;
+}
+
+// parses a line, or decodes it with the decoder of os if it is a binary record (STX len payload)
+static bool parse_gcode_line(OutputStream& os, const char *line, GCodeProcessor::GCodes_t& gcodes)
+{
+    if(line[0] == BinaryGCode::STX) {
+        BinaryGCode *bg= os.get_decoder();
+        if(is_lost_record(line)) {
+            bg->desync();
+            return true;
+        }
+        // a record ignored while halted is lost too
+        if(Module::is_halted()) bg->desync();
+        GCode gc;
+        bool ok= bg->decode((const uint8_t *)&line[2], (uint8_t)line[1], gc);
+        gcodes.push_back(gc);
+        return ok;
+    }
+    return gp.parse(line, gcodes);
+}
+
 // can be called by modules when in command thread context
 bool dispatch_line(OutputStream& os, const char *ln)
 {
+    if(is_gcode_line(ln)) {
+        // Parse gcode
+        GCodeProcessor::GCodes_t gcodes;
+        bool ok= parse_gcode_line(os, ln, gcodes);
+        return dispatch_gcodes(os, ln, ok, gp.get_line_number(), gcodes);
+    }
+
     // need a mutable copy
     std::string line(ln);
 
@@ -141,32 +201,33 @@ bool dispatch_line(OutputStream& os, const char *ln)
         return true;
     }
 
-    // see if a command
-    if(islower(line[0]) || line[0] == '$') {
-        // dispatch command
-        if(!THEDISPATCHER->dispatch(line.c_str(), os)) {
-            if(line[0] == '$') {
-                os.puts("error:Invalid statement\n");
-            } else {
-                os.printf("error:Unsupported command - %s\n", line.c_str());
-            }
-
-        }else if(!os.is_no_response()) {
-            os.puts("ok\n");
+    // dispatch command
+    if(!THEDISPATCHER->dispatch(line.c_str(), os)) {
+        if(line[0] == '$') {
+            os.puts("error:Invalid statement\n");
+        } else {
+            os.printf("error:Unsupported command - %s\n", line.c_str());
         }
-        os.set_no_response(false);
 
-        return true;
+    }else if(!os.is_no_response()) {
+        os.puts("ok\n");
     }
+    os.set_no_response(false);
 
-    // Handle Gcode
-    GCodeProcessor::GCodes_t gcodes;
+    return true;
+}
+
+// dispatches the gcodes parsed from line, parsed_ok and line_no are what the parser returned
+static bool dispatch_gcodes(OutputStream& os, const char *line, bool parsed_ok, int line_no, GCodeProcessor::GCodes_t& gcodes)
+{
+    if(is_lost_record(line)) return true;
+    bool is_record= line[0] == BinaryGCode::STX;
+    if(is_record) line= "(binary record)";
 
-    // Parse gcode
-    if(!gp.parse(line.c_str(), gcodes)) {
+    if(!parsed_ok) {
         if(gcodes.empty()) {
             // line failed checksum, send resend request
-            os.printf("rs N%d\n", gp.get_line_number() + 1);
+            os.printf("rs N%d\n", line_no + 1);
             return true;
         }
 
@@ -175,9 +236,9 @@ bool dispatch_line(OutputStream& os, const char *ln)
         if(g.has_error()) {
             // Word parse Error
             if(THEDISPATCHER->is_grbl_mode()) {
-                os.printf("error:gcode parse failed %s - %s\n", g.get_error_message(), line.c_str());
+                os.printf("error:gcode parse failed %s - %s\n", g.get_error_message(), line);
             }else{
-                os.printf("// WARNING gcode parse failed %s - %s\n", g.get_error_message(), line.c_str());
+                os.printf("// WARNING gcode parse failed %s - %s\n", g.get_error_message(), line);
             }
             // TODO add option to HALT in this case
         }else{
@@ -190,7 +251,7 @@ bool dispatch_line(OutputStream& os, const char *ln)
     // if we are uploading (M28) just save entire line, we do this here to take advantage
     // of the line resend if needed
     if(os.is_uploading()) {
-        if(line == "M29") {
+        if(strcmp(line, "M29") == 0) {
             // done uploading, close file
             fclose(upload_fp);
             upload_fp = nullptr;
@@ -198,10 +259,15 @@ bool dispatch_line(OutputStream& os, const char *ln)
             os.printf("Done saving file.\nok\n");
             return true;
         }
+        if(is_record) {
+            // there is no text to save
+            os.printf("error:binary records can not be uploaded\n");
+            return true;
+        }
         // just save the line to the file
         if(upload_fp != nullptr) {
             // write out line
-            if(fputs(line.c_str(), upload_fp) < 0 || fputc('\n', upload_fp) < 0) {
+            if(fputs(line, upload_fp) < 0 || fputc('\n', upload_fp) < 0) {
                 // we got an error
                 fclose(upload_fp);
                 upload_fp= nullptr;
@@ -314,7 +380,38 @@ bool process_command_buffer(size_t n, char *rx_buf, OutputStream *os, char *line
             continue;
         }
 
-        if(line[cnt] == 24) { // ^X
+        if(cnt > 0 && line[0] == BinaryGCode::STX) {
+            // in a binary record, any byte can be in the payload so nothing else is checked until it is all here
+            ++cnt;
+            size_t fs= BinaryGCode::frame_size(line[1]);
+            if(fs == 0) {
+                // drop the rest of it up to the next newline
+                os->puts("error:Binary record too long\n");
+                discard = true;
+                cnt = 0;
+                // it is lost as well
+                line[1]= 0;
+                if(!send_message_queue(line, os, wait)) return false;
+
+            } else if(cnt == fs) {
+                cnt = 0;
+                if(!BinaryGCode::check_frame((uint8_t *)line, fs)) {
+                    os->puts("error:Binary record CRC failed\n");
+                    // the host has moved on from the values in it, the next record must be a reset
+                    line[1]= 0;
+                }
+                os->clear_flags();
+                if(!send_message_queue(line, os, wait)) {
+                    // as for a line the caller will resubmit it
+                    return false;
+                }
+            }
+
+        } else if(cnt == 0 && line[0] == BinaryGCode::STX && !discard) {
+            // start of a binary record, ignored unless they are enabled
+            if(binary_gcode) cnt = 1;
+
+        } else if(line[cnt] == 24) { // ^X
             if(!Module::is_halted()) {
                 Module::broadcast_halt(true);
                 os->puts("ALARM: Abort during cycle\n");
@@ -466,6 +563,9 @@ static void usb_comms(void *)
 
     // create an output stream that writes to the cdc
     static OutputStream os([](const char *buf, size_t len) { return write_cdc(buf, len); });
+    if(usb_reply_buffer > 0 && !os.set_buffered(usb_reply_buffer, usb_reply_delay)) {
+        printf("WARNING: no memory to buffer USB replies\n");
+    }
     output_streams.insert(&os);
 
     // now read lines and dispatch them
@@ -481,7 +581,8 @@ static void usb_comms(void *)
     while(!abort_comms) {
         // Wait to be notified that there has been a received vcom packet.
         // treat as a counting semaphore, so will only block if count is zero.
-        uint32_t ulNotificationValue = ulTaskNotifyTake( pdFALSE, waitms );
+        // if replies are being held we wake up in time to send them
+        uint32_t ulNotificationValue = ulTaskNotifyTake( pdFALSE, os.has_buffered_output() ? pdMS_TO_TICKS(usb_reply_delay) : waitms );
 
         if( ulNotificationValue == 0 ) {
             /* The call to ulTaskNotifyTake() timed out. check anyway */
@@ -493,8 +594,10 @@ static void usb_comms(void *)
                 process_command_buffer(n, usb_rx_buf, &os, line, cnt, discard);
             }
         } while(n > 0);
+        os.flush_if_due();
     }
     output_streams.erase(&os);
+    release_message_channel();
     printf("DEBUG: USB Comms thread exiting\n");
     vTaskDelete(NULL);
 }
@@ -528,6 +631,7 @@ static void uart_comms(void *)
         }
     }
     output_streams.erase(&os);
+    release_message_channel();
     printf("DEBUG: UART Comms thread exiting\n");
     vTaskDelete(NULL);
 }
@@ -562,6 +666,7 @@ static void uart3_comms(void *)
         }
     }
     output_streams.erase(&os);
+    release_message_channel();
     printf("DEBUG: UART3 Comms thread exiting\n");
     vTaskDelete(NULL);
 }
@@ -573,6 +678,16 @@ void print_to_all_consoles(const char *str)
 {
     for(auto i : output_streams) {
         i->puts(str);
+        i->flush();
+    }
+}
+
+// send any replies being held by buffered output streams, or just the ones that have been held too long
+static void flush_output_streams(bool all)
+{
+    for(auto i : output_streams) {
+        if(all) i->flush();
+        else i->flush_if_due();
     }
 }
 
@@ -600,6 +715,44 @@ static void handle_query(bool need_done)
     }
 }
 
+// Lines taken from the message queue and parsed while the command thread is waiting in safe_sleep()
+// (usually for room in the planner queue), so the parse is done by the time they are dispatched.
+// The lines are held in the message queue line pool until they are dispatched.
+#define PARSE_AHEAD_LINES 2
+struct parsed_line_t
+{
+    char *line;
+    OutputStream *os;
+    bool is_gcode;  // false if dispatch_line() handles it as a command
+    bool parsed_ok;
+    int line_no;
+    GCodeProcessor::GCodes_t gcodes;
+};
+static parsed_line_t parsed_lines[PARSE_AHEAD_LINES];
+static uint8_t parsed_first= 0;
+static uint8_t parsed_count= 0;
+static TaskHandle_t command_thread= nullptr;
+
+static void parse_ahead()
+{
+    // other threads (like the player) can wait in safe_sleep() too, only the command thread takes lines and uses the parser
+    if(xTaskGetCurrentTaskHandle() != command_thread) return;
+
+    while(parsed_count < PARSE_AHEAD_LINES) {
+        parsed_line_t& p= parsed_lines[(parsed_first + parsed_count) % PARSE_AHEAD_LINES];
+        if(!receive_message_queue(&p.line, &p.os, false)) break;
+
+        // the parser keeps the modal state and line number so the lines must be parsed in order
+        p.is_gcode= is_gcode_line(p.line);
+        if(p.is_gcode) {
+            p.gcodes.clear();
+            p.parsed_ok= parse_gcode_line(*p.os, p.line, p.gcodes);
+            p.line_no= gp.get_line_number();
+        }
+        ++parsed_count;
+    }
+}
+
 extern "C" bool DFU_requested_detach();
 /*
  * All commands must be executed in the context of this thread. It is equivalent to the main_loop in v1.
@@ -614,15 +767,48 @@ static void command_handler()
         char *line;
         OutputStream *os= nullptr;
         bool idle = false;
+        bool got_line = false;
+        bool filling = false;
+
+        if(parsed_count == 0) {
+            got_line = receive_message_queue(&line, &os, false);
+            if(!got_line) {
+                // nothing more to do right now so send any replies being held before waiting
+                flush_output_streams(true);
+                if(Conveyor::getInstance() != nullptr && Conveyor::getInstance()->is_filling()) {
+                    // the look-ahead is only moved into the block queue by this thread, so wait for a block to be
+                    // released rather than for a line, any lines that come in meanwhile are parsed ahead
+                    Conveyor::getInstance()->wait_for_block_release();
+                    filling = true;
+                } else {
+                    // This will timeout after 100 ms
+                    got_line = receive_message_queue(&line, &os);
+                }
+            }
+        }
+
+        if(parsed_count > 0) {
+            // the next line was parsed while we were waiting
+            parsed_line_t& p= parsed_lines[parsed_first];
+            if(p.is_gcode) {
+                dispatch_gcodes(*p.os, p.line, p.parsed_ok, p.line_no, p.gcodes);
+            } else {
+                dispatch_line(*p.os, p.line);
+            }
+            handle_query(false);
+            p.os->set_done(); // set after all possible output
+            parsed_first= (parsed_first + 1) % PARSE_AHEAD_LINES;
+            --parsed_count;
+            release_message_queue();
 
-        // This will timeout after 100 ms
-        if(receive_message_queue(&line, &os)) {
+        } else if(got_line) {
             //printf("DEBUG: got line: %s\n", line);
             dispatch_line(*os, line);
             handle_query(false);
             os->set_done(); // set after all possible output
+            release_message_queue();
 
-        } else {
+        } else if(!filling) {
             // timed out or other error
             idle = true;
             if(config_error_msg.empty()) {
@@ -656,13 +842,15 @@ static void command_handler()
     }
 }
 
-// called only in command thread context, it will sleep (and yield) thread but will also
-// process things like instant query
+// called mostly in command thread context, it will sleep (and yield) thread but will also
+// process things like instant query, and in the command thread parse the next lines while it waits
 void safe_sleep(uint32_t ms)
 {
     // here we need to sleep (and yield) for 10ms then check if we need to handle the query command
     TickType_t delayms = pdMS_TO_TICKS(10); // 10 ms sleep
     while(ms > 0) {
+        parse_ahead();
+        flush_output_streams(false);
         vTaskDelay(delayms);
         // presumably there is a long running command that
         // may need Outputstream which will set done flag when it is done
@@ -676,6 +864,15 @@ void safe_sleep(uint32_t ms)
     }
 }
 
+// called only in command thread context when waiting for something that notifies it (eg the conveyor releasing a block)
+void safe_wait(uint32_t ms)
+{
+    parse_ahead();
+    flush_output_streams(false);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+    handle_query(false);
+}
+
 #include "CommandShell.h"
 #include "SlowTicker.h"
 #include "FastTicker.h"
@@ -729,6 +926,18 @@ int get_voltage_monitor_names(const char *names[])
     return i;
 }
 
+#ifdef STEPTICKER_TRACE
+#include "StepTrace.h"
+// drains the step trace to the sdcard, lower priority than the command thread
+static void steptrace_drain(void *)
+{
+    for(;;) {
+        StepTrace::getInstance()->drain();
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+#endif
+
 // this is used to add callback functions to be called once the system is running
 static std::vector<StartupFunc_t> startup_fncs;
 void register_startup(StartupFunc_t sf)
@@ -811,6 +1020,14 @@ static void smoothie_startup(void *)
                 rpi_port_enabled= cr.get_bool(m, "rpi_port_enable", false);
                 rpi_baudrate= cr.get_int(m, "rpi_baudrate", 115200);
                 printf("INFO: rpi port is %senabled, at baudrate: %lu\n", rpi_port_enabled ? "" : "not ", rpi_baudrate);
+                binary_gcode= cr.get_bool(m, "binary_gcode", false);
+                printf("INFO: binary gcode records are %senabled\n", binary_gcode ? "" : "not ");
+                int qs= cr.get_int(m, "command_queue_size", DEFAULT_MESSAGE_QUEUE_SIZE);
+                command_queue_size= qs < 2 ? 2 : qs > 255 ? 255 : qs;
+                int rb= cr.get_int(m, "usb_reply_buffer", usb_reply_buffer);
+                usb_reply_buffer= rb < 0 ? 0 : rb > 4096 ? 4096 : rb;
+                usb_reply_delay= cr.get_int(m, "usb_reply_delay_ms", usb_reply_delay);
+                if(usb_reply_buffer > 0) printf("INFO: USB replies are buffered in %u bytes for up to %u ms\n", usb_reply_buffer, usb_reply_delay);
                 std::string p = cr.get_string(m, "aux_play_led", "nc");
                 aux_play_led = new Pin(p.c_str(), Pin::AS_OUTPUT);
                 if(!aux_play_led->connected()) {
@@ -932,6 +1149,18 @@ static void smoothie_startup(void *)
     CommandShell *shell = new CommandShell();
     shell->initialize();
 
+    // all the modules have registered their gcode handlers now
+    THEDISPATCHER->build_dispatch_tables();
+
+#ifdef STEPTICKER_TRACE
+    StepTrace *step_trace = new StepTrace();
+    if(!step_trace->initialize()) {
+        printf("ERROR: failed to allocate the step trace buffer\n");
+    } else {
+        xTaskCreate(steptrace_drain, "StepTraceThread", 1000/4, NULL, (tskIDLE_PRIORITY + 1UL), (TaskHandle_t *) NULL);
+    }
+#endif
+
     if(ok) {
         // start the timers
         if(!slow_ticker->start()) {
@@ -958,7 +1187,7 @@ static void smoothie_startup(void *)
     }
 
     // create queue for incoming buffers from the I/O ports
-    if(!create_message_queue()) {
+    if(!create_message_queue(command_queue_size)) {
         // Failed to create the queue.
         printf("Error: failed to create comms i/o queue\n");
     }
@@ -1048,7 +1277,7 @@ int main(int argc, char *argv[])
     // set to be lower priority than comms, although it maybe better to invert them as we don;t really
     // want the commandthread preempted by the comms thread everytime it gets data.
     // 10000 Bytes stack
-    xTaskCreate(smoothie_startup, "CommandThread", 10000/4, NULL, (tskIDLE_PRIORITY + CMDTHRD_PRI), (TaskHandle_t *) NULL);
+    xTaskCreate(smoothie_startup, "CommandThread", 10000/4, NULL, (tskIDLE_PRIORITY + CMDTHRD_PRI), &command_thread);
 
     /* Start the scheduler */
     vTaskStartScheduler();
@@ -1097,6 +1326,11 @@ extern "C" void vApplicationTickHook( void )
     added here, but the tick hook is called from an interrupt context, so
     code must not attempt to block, and only the interrupt safe FreeRTOS API
     functions can be used (those that end in FromISR()). */
+
+    // the stepticker cannot call the RTOS so the command thread is woken from here when it releases a block
+    if(Conveyor::getInstance() != nullptr) {
+        Conveyor::getInstance()->notify_block_release();
+    }
 }
 
 extern "C" void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName )
@@ -20,6 +20,8 @@ extern "C" void set_abort_comms();
 
 // sleep for given ms, but don't block things like ?
 void safe_sleep(uint32_t ms);
+// like safe_sleep() but returns early if the thread is sent a task notification
+void safe_wait(uint32_t ms);
 // get the vmotor and vfet voltages
 float get_voltage_monitor(const char* name);
 int get_voltage_monitor_names(const char *names[]);
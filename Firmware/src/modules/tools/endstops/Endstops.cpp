@@ -13,6 +13,7 @@
 #include "Dispatcher.h"
 #include "main.h"
 #include "BaseSolution.h"
+#include "stopwatch.h"
 
 #include <ctype.h>
 #include <algorithm>
@@ -97,6 +98,14 @@ bool Endstops::configure(ConfigReader& cr)
     using std::placeholders::_1;
     using std::placeholders::_2;
 
+    // homing endstops are triggered from a pin interrupt where one is available, limits are always polled
+    for(auto& h : homing_axis) {
+        if(h.pin_info == nullptr) continue;
+        if(!h.pin_info->irq.attach(h.pin_info->pin, std::bind(&Endstops::endstop_edge, this, (int)h.axis_index, _1))) {
+            printf("INFO: configure-endstop: no pin interrupt available for %c endstop, it is polled\n", h.axis);
+        }
+    }
+
     Dispatcher::getInstance()->add_handler(Dispatcher::GCODE_HANDLER, 28, std::bind(&Endstops::handle_G28, this, _1, _2));
 
     Dispatcher::getInstance()->add_handler(Dispatcher::MCODE_HANDLER, 119, std::bind(&Endstops::handle_mcode, this, _1, _2));
@@ -172,6 +181,10 @@ bool Endstops::load_endstops(ConfigReader& cr)
 
         // init pin struct
         pin_info->debounce= 0;
+        pin_info->trigger_steps= 0;
+        pin_info->edge_time= 0;
+        pin_info->triggered= false;
+        pin_info->edge_pending= false;
         pin_info->axis= toupper(axis[0]);
         pin_info->axis_index= a;
 
@@ -320,6 +333,50 @@ bool Endstops::load_endstops(ConfigReader& cr)
     return true;
 }
 
+// record where the actuator is when the endstop is first seen to trigger
+void Endstops::latch_endstop(endstop_info_t *e)
+{
+    e->trigger_steps= STEPPER[e->axis_index]->get_current_step();
+    e->edge_time= StopWatch_Start();
+    e->edge_pending= true;
+}
+
+// stop the motor(s) for the endstop, called from read_endstops or the pin interrupt
+void Endstops::trigger_endstop(endstop_info_t *e)
+{
+    int m= e->axis_index;
+    if(is_corexy && (m == X_AXIS || m == Y_AXIS)) {
+        // corexy when moving in X or Y we need to stop both the X and Y motors
+        STEPPER[X_AXIS]->stop_moving();
+        STEPPER[Y_AXIS]->stop_moving();
+
+    }else{
+        // we signal the motor to stop, which will preempt any moves on that axis
+        STEPPER[m]->stop_moving();
+    }
+    e->triggered= true;
+}
+
+// Called from the pin interrupt on every edge of a homing endstop, this is the same priority as the step ticker
+// so the actuator position is latched exactly when the endstop triggered, and with no debounce the motor is stopped right here
+void Endstops::endstop_edge(int m, bool on)
+{
+    endstop_info_t *e= homing_axis[m].pin_info;
+
+    if(!on) {
+        // released, or bounced before it was debounced
+        e->edge_pending= false;
+        return;
+    }
+
+    if(this->status != MOVING_TO_ENDSTOP_SLOW && this->status != MOVING_TO_ENDSTOP_FAST) return;
+    if(is_corexy && (m == X_AXIS || m == Y_AXIS) && !axis_to_home[m]) return;
+    if(e->edge_pending || !STEPPER[m]->is_moving()) return;
+
+    latch_endstop(e);
+    if(debounce_ms == 0) trigger_endstop(e);
+}
+
 // Called every 10 milliseconds from the timer thread
 void Endstops::read_endstops()
 {
@@ -338,25 +395,26 @@ void Endstops::read_endstops()
         if(STEPPER[m]->is_moving()) {
             // if it is moving then we check the associated endstop, and debounce it
             if(e.pin_info->pin.get()) {
-                if(e.pin_info->debounce < debounce_ms) {
+                if(e.pin_info->irq.is_attached()) {
+                    // debounced from the time the edge was latched, latch it now if the edge was missed
+                    if(!e.pin_info->edge_pending) latch_endstop(e.pin_info);
+                    if(StopWatch_TicksToMs(StopWatch_Elapsed(e.pin_info->edge_time)) >= debounce_ms) {
+                        trigger_endstop(e.pin_info);
+                    }
+
+                } else if(e.pin_info->debounce < debounce_ms) {
+                    if(e.pin_info->debounce == 0) latch_endstop(e.pin_info);
                     e.pin_info->debounce+=10; // as each iteration is 10ms
 
                 } else {
-                    if(is_corexy && (m == X_AXIS || m == Y_AXIS)) {
-                        // corexy when moving in X or Y we need to stop both the X and Y motors
-                        STEPPER[X_AXIS]->stop_moving();
-                        STEPPER[Y_AXIS]->stop_moving();
-
-                    }else{
-                        // we signal the motor to stop, which will preempt any moves on that axis
-                        STEPPER[m]->stop_moving();
-                    }
-                    e.pin_info->triggered= true;
+                    if(e.pin_info->debounce == 0) latch_endstop(e.pin_info);
+                    trigger_endstop(e.pin_info);
                 }
 
             } else {
                 // The endstop was not hit yet
                 e.pin_info->debounce= 0;
+                e.pin_info->edge_pending= false;
             }
         }
     }
@@ -523,6 +581,7 @@ void Endstops::home(axis_bitmap_t a)
     for(auto& e : endstops) {
        e->debounce= 0;
        e->triggered= false;
+       e->edge_pending= false;
     }
 
     if (is_scara) {
@@ -624,7 +683,11 @@ void Endstops::home(axis_bitmap_t a)
     // wait until finished
     Conveyor::getInstance()->wait_for_idle();
 
-    // Start moving the axes towards the endstops slowly
+    // Start moving the axes towards the endstops slowly, the trigger position is latched again
+    for(auto& e : endstops) {
+       e->debounce= 0;
+       e->edge_pending= false;
+    }
     this->status = MOVING_TO_ENDSTOP_SLOW;
     for (auto& i : homing_axis) {
         int c= i.axis_index;
@@ -821,7 +884,14 @@ void Endstops::process_home_command(GCode& gcode, OutputStream& os)
         // so XY are at a known consistent position.  (especially true if using a proximity probe)
         for (auto &p : homing_axis) {
             if (haxis[p.axis_index]) { // if we requested this axis to home
-                Robot::getInstance()->reset_axis_position(p.homing_position + p.home_offset, p.axis_index);
+                // the homing position is where the endstop triggered, so add on how far it went past that while stopping
+                // NOTE corexy and scara actuators do not map to a single axis so are not corrected
+                float overrun= 0;
+                if(!is_corexy && !is_scara && p.pin_info->triggered) {
+                    StepperMotor *a= STEPPER[p.axis_index];
+                    overrun= (int32_t)(a->get_current_step() - p.pin_info->trigger_steps) / a->get_steps_per_mm();
+                }
+                Robot::getInstance()->reset_axis_position(p.homing_position + p.home_offset + overrun, p.axis_index);
                 // set flag indicating axis was homed, it stays set once set until H/W reset or unhomed
                 p.homed= true;
             }
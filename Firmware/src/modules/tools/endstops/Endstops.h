@@ -2,6 +2,7 @@
 
 #include "Module.h"
 #include "Pin.h"
+#include "PinInterrupt.h"
 
 #include <bitset>
 #include <array>
@@ -24,6 +25,7 @@ class Endstops : public Module
     private:
         bool load_endstops(ConfigReader& cr);
         void read_endstops();
+        void endstop_edge(int axis, bool on);
         void check_limits();
 
         using axis_bitmap_t = std::bitset<6>;
@@ -47,15 +49,22 @@ class Endstops : public Module
         // per endstop settings
         using endstop_info_t = struct {
             Pin pin;
+            PinInterrupt irq; // only attached for homing endstops
+            int32_t trigger_steps; // actuator position when the endstop triggered
+            volatile uint32_t edge_time; // stopwatch ticks when the endstop triggered
             struct {
                 uint16_t debounce:16;
                 char axis:8; // one of XYZABC
                 uint8_t axis_index:3;
                 bool limit_enable:1;
-                bool triggered:1;
+                volatile bool triggered:1;
+                volatile bool edge_pending:1; // the trigger position has been latched, waiting for debounce
             };
         };
 
+        void latch_endstop(endstop_info_t *e);
+        void trigger_endstop(endstop_info_t *e);
+
         using homing_info_t = struct {
             float homing_position;
             float home_offset;
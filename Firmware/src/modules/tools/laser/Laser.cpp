@@ -8,12 +8,16 @@
 #include "Pwm.h"
 #include "Pin.h"
 #include "StepTicker.h"
+#include "Conveyor.h"
+#include "RasterBuffer.h"
 #include "ConfigReader.h"
 #include "GCode.h"
 #include "OutputStream.h"
 #include "StringUtils.h"
 
 #include <algorithm>
+#include <stdlib.h>
+#include <math.h>
 
 #define enable_key "enable"
 #define pwm_pin_key "pwm_pin"
@@ -23,10 +27,15 @@
 #define minimum_power_key "minimum_power"
 #define maximum_s_value_key "maximum_s_value"
 #define default_power_key "default_power"
+#define raster_buffer_size_key "raster_buffer_size"
 
 // as long as we only update at 100Hz we do not need to put stuff in ramfunc
 //#define _ramfunc_ __attribute__ ((section(".ramfunctions"),long_call,noinline))
 #define _ramfunc_
+// the raster pixels are set from the step ticker ISR so that path does need to be in RAM
+#define _isr_ramfunc_ __attribute__ ((section(".ramfunctions"),long_call,noinline))
+
+Laser *Laser::instance= nullptr;
 
 REGISTER_MODULE(Laser, Laser::create)
 
@@ -47,6 +56,7 @@ Laser::Laser() : Module("laser")
     laser_on = false;
     scale= 1;
     manual_fire= false;
+    instance= this;
 }
 
 bool Laser::configure(ConfigReader& cr)
@@ -101,8 +111,23 @@ bool Laser::configure(ConfigReader& cr)
     // register command handlers
     using std::placeholders::_1;
     using std::placeholders::_2;
+    using std::placeholders::_3;
 
     THEDISPATCHER->add_handler( "fire", std::bind( &Laser::handle_fire_cmd, this, _1, _2) );
+
+    // the raster lines are held until the blocks using them have been stepped, 0 disables raster mode
+    int raster_size= cr.get_int(m, raster_buffer_size_key, 4096);
+    if(raster_size > 0) {
+        RasterBuffer *rb= new RasterBuffer(raster_size);
+        if(rb->is_valid()) {
+            THEDISPATCHER->add_handler( "raster", std::bind( &Laser::handle_raster_cmd, this, _1, _2) );
+            rb->prepare_fnc= std::bind(&Laser::prepare_raster, this, _1, _2, _3);
+            StepTicker::getInstance()->raster_fnc= &Laser::set_raster_duty;
+        } else {
+            printf("configure-laser: ERROR not enough memory for the raster buffer\n");
+            delete rb;
+        }
+    }
     THEDISPATCHER->add_handler(Dispatcher::MCODE_HANDLER, 221, std::bind(&Laser::handle_M221, this, _1, _2));
 
     // no point in updating the power more than the PWM frequency, but no more than 100Hz
@@ -161,6 +186,55 @@ bool Laser::handle_fire_cmd( std::string& params, OutputStream& os )
     return true;
 }
 
+bool Laser::handle_raster_cmd( std::string& params, OutputStream& os )
+{
+    HELP("set the pixels of the next G1: raster hexpixels (00-ff each)");
+
+    if(Module::is_halted()) {
+        os.printf("ignored while in ALARM state\n");
+        return true;
+    }
+
+    std::string hex = stringutils::shift_parameter( params );
+    if(hex.empty() || (hex.size() & 1) != 0) {
+        os.printf("Usage: raster hexpixels\n");
+        return true;
+    }
+
+    RasterBuffer *rb= RasterBuffer::getInstance();
+    uint8_t pixels[64];
+    size_t i= 0;
+    while(i < hex.size()) {
+        size_t n= 0;
+        for (; n < sizeof(pixels) && i < hex.size(); i += 2) {
+            char *e;
+            char b[3]= {hex[i], hex[i+1], 0};
+            pixels[n++]= strtol(b, &e, 16);
+            if(*e != 0) {
+                os.printf("error:raster pixels must be hex\n");
+                return true;
+            }
+        }
+
+        // wait for the blocks using the buffer to finish, if nothing is queued the line will never fit
+        while(!rb->add(pixels, n)) {
+            if(Conveyor::getInstance()->is_idle()) {
+                rb->reset();
+                if(rb->add(pixels, n)) break;
+                os.printf("error:raster line is longer than the raster buffer (%u)\n", (unsigned)rb->get_size());
+                uint16_t discard;
+                rb->take(discard, 0);
+                return true;
+            }
+            Conveyor::getInstance()->check_queue(true);
+            Conveyor::getInstance()->wait_for_block_release();
+            if(Module::is_halted()) return true;
+        }
+    }
+
+    return true;
+}
+
 // returns instance
 bool Laser::request(const char *key, void *value)
 {
@@ -230,6 +304,10 @@ _ramfunc_ void Laser::set_proportional_power(void)
 {
     if(manual_fire) return;
 
+    // the power of a raster line is set by the step ticker as it gets to each pixel
+    const Block *block = StepTicker::getInstance()->get_current_block();
+    if(block != nullptr && block->is_ready && block->raster_size > 0) return;
+
     float power;
     if(get_laser_power(power)) {
         // adjust power to maximum power and actual velocity
@@ -243,6 +321,44 @@ _ramfunc_ void Laser::set_proportional_power(void)
     return;
 }
 
+// called on the command thread when a G1 takes a raster line, converts each pixel in place to the
+// PWM duty (1.15 fixed point, 0 is off) so the step ticker ISR only has to write it. The pixel scales
+// the S value of the block, the speed ratio is not applied, the line should be run at a constant speed (overscan)
+void Laser::prepare_raster(uint16_t *line, size_t n, uint16_t s_value)
+{
+    float power = ((float)s_value/(1<<11)) / this->laser_maximum_s_value * scale / 255.0F;
+    for (size_t i = 0; i < n; ++i) {
+        if(line[i] == 0) continue;
+
+        float p = ( (this->laser_maximum_power - this->laser_minimum_power) * power * line[i] ) + this->laser_minimum_power;
+        if(p > 1) p= 1;
+        if(p > 0.00001F) {
+            long d = lroundf(p * 0x8000);
+            line[i] = d < 1 ? 1 : d;
+        } else {
+            line[i] = 0;
+        }
+    }
+}
+
+// called from the step ticker ISR as each pixel of a raster line is reached with its precomputed duty
+_isr_ramfunc_ void Laser::set_raster_duty(uint16_t duty)
+{
+    Laser *l= instance;
+    if(l->manual_fire) return;
+
+    if(duty == 0) {
+        l->pwm_pin->set_duty(l->pwm_inverting ? 0x8000 : 0);
+        if (l->ttl_used) l->ttl_pin->set(false);
+        l->laser_on = false;
+
+    } else {
+        l->pwm_pin->set_duty(l->pwm_inverting ? 0x8000 - duty : duty);
+        if(!l->laser_on && l->ttl_used) l->ttl_pin->set(true);
+        l->laser_on = true;
+    }
+}
+
 _ramfunc_ bool Laser::set_laser_power(float power)
 {
     // Ensure power is >=0 and <= 1
@@ -4,6 +4,7 @@
 
 #include <stdint.h>
 #include <string>
+#include <stddef.h>
 
 class Pin;
 class Pwm;
@@ -28,11 +29,16 @@ class Laser : public Module
         float get_current_power() const;
 
     private:
+        static Laser *instance;
+
         void on_halt(bool flg);
         bool handle_M221(GCode& gcode, OutputStream& os);
         bool handle_fire_cmd( std::string& params, OutputStream& os );
+        bool handle_raster_cmd( std::string& params, OutputStream& os );
 
         void set_proportional_power(void);
+        void prepare_raster(uint16_t *line, size_t n, uint16_t s_value);
+        static void set_raster_duty(uint16_t duty);
         bool get_laser_power(float& power) const;
         float current_speed_ratio(const Block *block) const;
 
@@ -324,7 +324,7 @@ bool TemperatureControl::handle_mcode(GCode & gcode, OutputStream & os)
 
     if (gcode.get_code() == 305) { // set or get sensor settings
         if (gcode.has_arg('S') && (gcode.get_int_arg('S') == this->tool_id)) {
-            TempSensor::sensor_options_t args = gcode.get_args();
+            TempSensor::sensor_options_t args(gcode.get_args().begin(), gcode.get_args().end());
             args.erase('S'); // don't include the S
             if(args.size() > 0) {
                 // set the new options
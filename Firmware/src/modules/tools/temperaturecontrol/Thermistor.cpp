@@ -5,6 +5,9 @@
 #include "StringUtils.h"
 #include "Adc.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
+
 // a const list of predefined thermistors
 #include "predefined_thermistors.h"
 
@@ -22,14 +25,22 @@
 #define r1_key             "r1"
 #define r2_key             "r2"
 #define thermistor_pin_key "thermistor_pin"
+#define adc_samples_key    "adc_samples"
+#define adc_oversample_key "adc_oversample"
 #define rt_curve_key       "rt_curve"
 #define coefficients_key   "coefficients"
 #define use_beta_table_key "use_beta_table"
+#define use_lookup_table_key "use_lookup_table"
+
+// the most the lookup table may differ from the equations in °C, and the most points it may use to do so
+#define lookup_table_max_error 0.05F
+#define lookup_table_max_points 256
 
 
 Thermistor::Thermistor()
 {
     this->use_steinhart_hart = false;
+    this->use_lookup_table = true;
     this->beta = 0.0F; // not used by default
     min_temp = 999;
     max_temp = 0;
@@ -54,6 +65,9 @@ bool Thermistor::configure(ConfigReader& cr, ConfigReader::section_map_t& m)
     // force use of beta perdefined thermistor table based on betas
     bool use_beta_table = cr.get_bool(m, use_beta_table_key, false);
 
+    // convert readings with a table built from the equations rather than evaluating them for each reading
+    this->use_lookup_table = cr.get_bool(m, use_lookup_table_key, true);
+
     bool found = false;
     int cnt = 0;
     // load a predefined thermistor name if found
@@ -120,7 +134,10 @@ bool Thermistor::configure(ConfigReader& cr, ConfigReader::section_map_t& m)
 
     // for the dedicated ADC pins use ADC0_n where n is channel to use 0-7
     // or use a valid pin specification for an ADC dual function pin eg P7.5 for ADC0_3
-    if(this->thermistor_pin->from_string(cr.get_string(m, thermistor_pin_key, "nc")) == nullptr) {
+    // the number of readings filtered and the extra bits of resolution from them can be set for each thermistor, defaults are 32 and 2
+    int samples = cr.get_int(m, adc_samples_key, 32);
+    int oversample = cr.get_int(m, adc_oversample_key, 2);
+    if(this->thermistor_pin->from_string(cr.get_string(m, thermistor_pin_key, "nc"), samples, oversample) == nullptr) {
         printf("config-thermistor: no thermistor pin defined, or invalid ADC pin or bad format\n");
         return false;
     }
@@ -181,9 +198,29 @@ bool Thermistor::configure(ConfigReader& cr, ConfigReader::section_map_t& m)
         return false;
     }
 
+    build_table();
+
     return true;
 }
 
+// build the lookup table from the current equation, falls back to the equation if it can't be built.
+// The readings are converted in the slow ticker while this runs (eg from M305) so the new table is built
+// on the side and swapped in, the old one is freed once nothing can be reading it
+void Thermistor::build_table()
+{
+    PiecewiseLinearTable t;
+    if(use_lookup_table) {
+        using std::placeholders::_1;
+        if(!t.build(thermistor_pin->get_max_value(), std::bind(&Thermistor::calculate_temperature, this, _1), lookup_table_max_error, lookup_table_max_points)) {
+            printf("WARNING: config-thermistor: could not build the lookup table, using the equation\n");
+        }
+    }
+
+    taskENTER_CRITICAL();
+    table.swap(t);
+    taskEXIT_CRITICAL();
+}
+
 // print out predefined thermistors
 void Thermistor::print_predefined_thermistors(OutputStream& os)
 {
@@ -252,7 +289,7 @@ float Thermistor::get_temperature()
 void Thermistor::get_raw(OutputStream& os)
 {
     int adc_value = new_thermistor_reading();
-    const uint32_t max_adc_value = Adc::get_max_value();
+    const uint32_t max_adc_value = thermistor_pin->get_max_value();
 
     // resistance of the thermistor in ohms
     float r = r2 / (((float)max_adc_value / adc_value) - 1.0F);
@@ -271,6 +308,10 @@ void Thermistor::get_raw(OutputStream& os)
         os.printf("beta temp= %f, min= %f, max= %f, delta= %f\n", t, min_temp, max_temp, max_temp - min_temp);
     }
 
+    if(table.is_valid()) {
+        os.printf("lookup table of %d points, temp= %f\n", table.get_size(), table.get(adc_value));
+    }
+
     // if using a predefined thermistor show its name and which table it is from
     if(thermistor_number != 0) {
         std::string name = (thermistor_number & 0x80) ? predefined_thermistors_beta[(thermistor_number & 0x7F) - 1].name :  predefined_thermistors[thermistor_number - 1].name;
@@ -283,7 +324,20 @@ void Thermistor::get_raw(OutputStream& os)
 
 float Thermistor::adc_value_to_temperature(uint32_t adc_value)
 {
-    const uint32_t max_adc_value = Adc::get_max_value();
+    // the slow ticker runs below the command thread so the table must not be swapped while it is being read
+    float t;
+    taskENTER_CRITICAL();
+    bool valid = table.is_valid();
+    if(valid) t = table.get(adc_value);
+    taskEXIT_CRITICAL();
+
+    if(valid) return t;
+    return calculate_temperature(adc_value);
+}
+
+float Thermistor::calculate_temperature(uint32_t adc_value) const
+{
+    const uint32_t max_adc_value = thermistor_pin->get_max_value();
     if ((adc_value >= max_adc_value) || (adc_value == 0))
         return std::numeric_limits<float>::infinity();
 
@@ -352,6 +406,7 @@ bool Thermistor::set_optional(const sensor_options_t& options)
             use_steinhart_hart = false;
             if(!calc_jk()) return false;
             thermistor_number = predefined;
+            build_table();
             return true;
 
         } else {
@@ -369,6 +424,7 @@ bool Thermistor::set_optional(const sensor_options_t& options)
             this->r2 = i.r2;
             use_steinhart_hart = true;
             thermistor_number = predefined;
+            build_table();
             return true;
         }
     }
@@ -394,6 +450,7 @@ bool Thermistor::set_optional(const sensor_options_t& options)
         return false;
     }
 
+    build_table();
     return true;
 }
 
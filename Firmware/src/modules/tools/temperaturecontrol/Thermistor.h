@@ -1,6 +1,7 @@
 #pragma once
 
 #include "TempSensor.h"
+#include "PiecewiseLinearTable.h"
 
 #include <tuple>
 
@@ -27,6 +28,8 @@ class Thermistor : public TempSensor
     private:
         int new_thermistor_reading();
         float adc_value_to_temperature(uint32_t adc_value);
+        float calculate_temperature(uint32_t adc_value) const;
+        void build_table();
         bool calc_jk();
 
         // Thermistor computation settings using beta, not used if using Steinhart-Hart
@@ -53,8 +56,12 @@ class Thermistor : public TempSensor
 
         Adc *thermistor_pin{nullptr};
 
+        // temperature for every adc value, built from the beta or Steinhart-Hart equation when they are set
+        PiecewiseLinearTable table;
+
         float min_temp, max_temp;
 
         bool use_steinhart_hart;
+        bool use_lookup_table;
         uint8_t thermistor_number;
 };
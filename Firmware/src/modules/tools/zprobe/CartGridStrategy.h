@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ZProbeStrategy.h"
+#include "BilinearGrid.h"
 
 #include <string>
 #include <tuple>
@@ -39,6 +40,7 @@ private:
     std::string before_probe, after_probe;
 
     float *grid;
+    BilinearGrid bilinear; // the grid as it is used for compensation
     std::tuple<float, float, float> probe_offsets;
     float x_start,y_start;
     float x_size,y_size;
@@ -13,6 +13,7 @@
 #include "StepTicker.h"
 #include "Dispatcher.h"
 #include "OutputStream.h"
+#include "stopwatch.h"
 
 // strategies we know about
 #include "ThreePointStrategy.h"
@@ -83,6 +84,14 @@ bool ZProbe::configure(ConfigReader& cr)
 
     this->debounce_ms = cr.get_float(m, debounce_ms_key, 0);
 
+    // the probe is triggered from the pin interrupt if one is available, otherwise it is polled
+    using std::placeholders::_1;
+    if(pin_irq.attach(this->pin, std::bind(&ZProbe::probe_edge, this, _1))) {
+        printf("INFO: config-zprobe: probe is interrupt driven\n");
+    } else {
+        printf("INFO: config-zprobe: no pin interrupt available, probe is polled\n");
+    }
+
     // see if a levellng strategy defined
     std::string leveling = cr.get_string(m, leveling_key, "");
 
@@ -142,7 +151,6 @@ bool ZProbe::configure(ConfigReader& cr)
     this->dwell_before_probing = cr.get_float(m, dwell_before_probing_key, 0); // dwell time in seconds before probing
 
     // register gcodes and mcodes
-    using std::placeholders::_1;
     using std::placeholders::_2;
 
     // G Code handlers
@@ -165,22 +173,89 @@ bool ZProbe::configure(ConfigReader& cr)
     return true;
 }
 
+// record where all the actuators are, called when the probe is first seen to trigger
+void ZProbe::latch_position()
+{
+    auto& actuators = Robot::getInstance()->actuators;
+    for (size_t i = 0; i < actuators.size() && i < trigger_steps.size(); ++i) {
+        trigger_steps[i] = actuators[i]->get_current_step();
+    }
+}
+
+// signal the motors to stop, which will preempt any moves on that axis
+void ZProbe::trigger()
+{
+    // we do all motors as it may be a delta
+    for(auto &a : Robot::getInstance()->actuators) a->stop_moving();
+    probe_detected = true;
+    edge_pending = false;
+    debounce = 0;
+}
+
+float ZProbe::get_trigger_position(int actuator) const
+{
+    return (float)trigger_steps[actuator] / STEPS_PER_MM(actuator);
+}
+
+// called from the pin interrupt on every edge of the probe pin, this has the same priority as the step ticker
+// so the positions latched here are exactly where the actuators were when the probe triggered
+void ZProbe::probe_edge(bool on)
+{
+    if(!probing || probe_detected) return;
+
+    if(!on) {
+        // released before the debounce time was up
+        edge_pending = false;
+        return;
+    }
+
+    if(edge_pending) return;
+
+    if(STEPPER[X_AXIS]->is_moving() || STEPPER[Y_AXIS]->is_moving() || STEPPER[Z_AXIS]->is_moving()) {
+        latch_position();
+        if(debounce_ms == 0) {
+            // no debounce so stop right now, rather than on the next poll
+            trigger();
+        } else {
+            edge_time = StopWatch_Start();
+            edge_pending = true;
+        }
+    }
+}
+
 void ZProbe::read_probe()
 {
     if(!probing || probe_detected) return;
 
     // we check all axis as it maybe a G38.2 X10 for instance, not just a probe in Z
     if(STEPPER[X_AXIS]->is_moving() || STEPPER[Y_AXIS]->is_moving() || STEPPER[Z_AXIS]->is_moving()) {
+        if(pin_irq.is_attached()) {
+            // the edge was seen and latched in the interrupt, we stop once the probe has stayed on for debounce_ms
+            if(this->pin.get()) {
+                if(!edge_pending) {
+                    // missed the edge (eg it was already on when probing started) so latch it now
+                    latch_position();
+                    edge_time = StopWatch_Start();
+                    edge_pending = true;
+                }
+                if(StopWatch_TicksToMs(StopWatch_Elapsed(edge_time)) >= debounce_ms) {
+                    trigger();
+                }
+
+            } else {
+                edge_pending = false;
+            }
+            return;
+        }
+
         // if it is moving then we check the probe, and debounce it
         if(this->pin.get()) {
+            if(debounce == 0) latch_position();
             if(debounce < debounce_ms) {
                 debounce++;
 
-            } else {// we signal the motors to stop, which will preempt any moves on that axis
-                // we do all motors as it may be a delta
-                for(auto &a : Robot::getInstance()->actuators) a->stop_moving();
-                probe_detected = true;
-                debounce = 0;
+            } else {
+                trigger();
             }
 
         } else {
@@ -203,9 +278,10 @@ bool ZProbe::run_probe(float& mm, float feedrate, float max_dist, bool reverse)
 
     float maxz = max_dist < 0 ? this->max_travel : max_dist;
 
-    probing = true;
     probe_detected = false;
+    edge_pending = false;
     debounce = 0;
+    probing = true;
 
     // save current actuator position so we can report how far we moved
     float z_start_pos = Robot::getInstance()->actuators[Z_AXIS]->get_current_position();
@@ -221,9 +297,10 @@ bool ZProbe::run_probe(float& mm, float feedrate, float max_dist, bool reverse)
     // wait until finished
     Conveyor::getInstance()->wait_for_idle();
 
-    // now see how far we moved, get delta in z we moved
+    // now see how far we moved, get delta in z we moved, to where the probe triggered rather than where it stopped
     // NOTE this works for deltas as well as all three actuators move the same amount in Z
-    mm = z_start_pos - Robot::getInstance()->actuators[Z_AXIS]->get_current_position();
+    float z_end_pos = probe_detected ? get_trigger_position(Z_AXIS) : Robot::getInstance()->actuators[Z_AXIS]->get_current_position();
+    mm = z_start_pos - z_end_pos;
 
     // set the last probe position to the actuator units moved during this home
     Robot::getInstance()->set_last_probe_position(std::make_tuple(0, 0, mm, probe_detected ? 1 : 0));
@@ -299,8 +376,10 @@ bool ZProbe::handle_gcode(GCode& gcode, OutputStream& os)
                 os.printf("Z:%1.4f\n", mm);
 
                 if(set_z) {
-                    // set current Z to the specified value, shortcut for G92 Znnn
-                    THEDISPATCHER->dispatch(os, 'G', 92, 'Z', gcode.get_arg('Z'), 0);
+                    // set Z where the probe triggered to the specified value, shortcut for G92 Znnn. The actuators
+                    // stopped a little past the trigger so that overrun is added, the same as homing does
+                    float overrun = Robot::getInstance()->actuators[Z_AXIS]->get_current_position() - get_trigger_position(Z_AXIS);
+                    THEDISPATCHER->dispatch(os, 'G', 92, 'Z', gcode.get_arg('Z') + overrun, 0);
                 }
 
             } else {
@@ -464,9 +543,11 @@ void ZProbe::probe_XYZ(GCode& gcode, OutputStream& os, uint8_t axismask)
         return;
     }
 
-    // enable the probe checking in the timer
-    probing = true;
+    // enable the probe checking in the timer and pin interrupt
     probe_detected = false;
+    edge_pending = false;
+    debounce = 0;
+    probing = true;
 
     // get probe feedrate in mm/min and convert to mm/sec if specified
     float rate = (gcode.has_arg('F')) ? gcode.get_arg('F') / 60 : this->slow_feedrate;
@@ -493,6 +574,13 @@ void ZProbe::probe_XYZ(GCode& gcode, OutputStream& os, uint8_t axismask)
 
     uint8_t probeok = this->probe_detected ? 1 : 0;
 
+    if(probeok) {
+        // report where the probe triggered, the actuators will have moved a little further while stopping
+        ActuatorCoordinates ap{get_trigger_position(X_AXIS), get_trigger_position(Y_AXIS), get_trigger_position(Z_AXIS)};
+        Robot::getInstance()->arm_solution->actuator_to_cartesian(ap, pos);
+        if(Robot::getInstance()->compensationTransform) Robot::getInstance()->compensationTransform(pos, true); // get inverse compensation transform
+    }
+
     // print results using the GRBL format
     os.printf("[PRB:%1.3f,%1.3f,%1.3f:%d]\n", pos[X_AXIS], pos[Y_AXIS], pos[Z_AXIS], probeok);
     Robot::getInstance()->set_last_probe_position(std::make_tuple(pos[X_AXIS], pos[Y_AXIS], pos[Z_AXIS], probeok));
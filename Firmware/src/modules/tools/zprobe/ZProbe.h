@@ -2,6 +2,10 @@
 
 #include "Module.h"
 #include "Pin.h"
+#include "PinInterrupt.h"
+#include "ActuatorCoordinates.h"
+
+#include <array>
 
 // defined here as they are used in multiple files
 #define leveling_strategy_key "leveling-strategy"
@@ -42,6 +46,10 @@ private:
     bool handle_mcode(GCode& gcode, OutputStream& os);
     void probe_XYZ(GCode& gc, OutputStream& os, uint8_t axismask);
     void read_probe(void);
+    void probe_edge(bool on);
+    void latch_position();
+    void trigger();
+    float get_trigger_position(int actuator) const;
 
     float slow_feedrate;
     float fast_feedrate;
@@ -51,16 +59,22 @@ private:
     float dwell_before_probing;
 
     Pin pin;
+    PinInterrupt pin_irq;
     ZProbeStrategy *leveling_strategy{nullptr};
     ZProbeStrategy *calibration_strategy{nullptr};
 
     uint16_t debounce_ms;
     uint16_t debounce{0};
 
+    // actuator positions when the probe was triggered, latched in the pin interrupt at the edge
+    std::array<int32_t, k_max_actuators> trigger_steps;
+    volatile uint32_t edge_time{0}; // stopwatch ticks
+
     volatile struct {
         bool probing:1;
         bool reverse_z:1;
         bool invert_override:1;
         volatile bool probe_detected:1;
+        volatile bool edge_pending:1; // the probe was triggered and is waiting for the debounce time
     };
 };
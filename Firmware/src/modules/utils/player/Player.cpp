@@ -10,6 +10,7 @@
 #include "TemperatureControl.h"
 #include "main.h"
 #include "MessageQueue.h"
+#include "ReadAheadFile.h"
 
 #include "FreeRTOS.h"
 #include "task.h"
@@ -245,6 +246,8 @@ bool Player::handle_gcode(GCode& gcode, OutputStream& os)
 void Player::play_thread(void*)
 {
     instance->player_thread();
+    // a new thread is started for each file played
+    release_message_channel();
     vTaskDelete(NULL);
 }
 
@@ -433,11 +436,18 @@ void Player::player_thread()
     printf("DEBUG: Player thread starting\n");
 
     start_ticks = xTaskGetTickCount();
-    char buf[130]; // lines upto 128 characters are allowed, anything longer is discarded
-    bool discard = false;
     uint32_t linecnt= 0;
 
-    while(fgets(buf, sizeof(buf), this->current_file_handler) != NULL) {
+    // the file is read ahead by another task so the sdcard does not hold up the lines
+    ReadAheadFile reader;
+    if(!reader.start(this->current_file_handler)) {
+        if(this->current_os != nullptr) { this->current_os->printf("Error: could not start reading file\n"); }
+    }
+
+    char *line;
+    size_t n;
+    bool too_long;
+    while((line= reader.get_line(n, too_long)) != nullptr) {
         while(!playing_file && !abort_thread && !Module::is_halted()) {
             // we must be paused
             vTaskDelay(pdMS_TO_TICKS(200)); // sleep and yield
@@ -449,43 +459,34 @@ void Player::player_thread()
             break;
         }
 
-        int len = strlen(buf);
-        if(len == 0) continue; // empty line? should not be possible
-        if(buf[len - 1] == '\n' || feof(this->current_file_handler)) {
-            if(discard) { // we are discarding a long line
-                discard = false;
-                continue;
-            }
-            if(len == 1) continue; // empty line
-
-            if(current_os != nullptr) {
-                current_os->puts(buf);
-            }
-
-            buf[len - 1] = '\0'; // remove the \n and nul terminate
+        played_cnt += n;
 
-            // we do not want to fill the message queue, so leave some space in it
-            //while(get_message_queue_space() < 2) vTaskDelay(pdMS_TO_TICKS(1));
+        if(too_long) {
+            // discard long line
+            if(this->current_os != nullptr) { this->current_os->printf("Warning: Discarded long line\n"); }
+            continue;
+        }
 
-            // don't fill block queue so don't let planner stall on a full queue
-            Conveyor::getInstance()->wait_for_room();
+        if(line[0] == '\0') continue; // empty line
 
-            send_message_queue(buf, &nullos);
+        if(current_os != nullptr) {
+            current_os->printf("%s\n", line);
+        }
 
-            played_cnt += len;
+        // don't fill block queue so don't let planner stall on a full queue
+        Conveyor::getInstance()->wait_for_room();
 
-            if((++linecnt % 100) == 0) {
-                // yield to some other threads every 100 lines or so
-                vTaskDelay(pdMS_TO_TICKS(1));
-            }
+        send_message_queue(line, &nullos);
 
-        } else {
-            // discard long line
-            if(this->current_os != nullptr) { this->current_os->printf("Warning: Discarded long line\n"); }
-            discard = true;
+        if((++linecnt % 100) == 0) {
+            // yield to some other threads every 100 lines or so
+            vTaskDelay(pdMS_TO_TICKS(1));
         }
     }
 
+    // the reader must be done with the file before it is closed
+    reader.stop();
+
     // finished file, clean up
     this->playing_file = false;
     this->filename = "";
@@ -0,0 +1,180 @@
+#include "ReadAheadFile.h"
+
+#include "main.h"
+#include "MemoryPool.h"
+
+#include "task.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+bool ReadAheadFile::start(FILE *fp)
+{
+    this->fp = fp;
+    // with no stdio buffering the reads go straight to the file system, which transfers whole sectors
+    // directly into the buffer
+    setvbuf(fp, NULL, _IONBF, 0);
+
+    for (int i = 0; i < NBUFFERS; ++i) {
+        // the buffers go in RAM4 if there is room, with an extra byte to terminate a line at the end of the file
+        buffers[i] = (char *)_RAM4->alloc(BUFFER_SIZE + 1);
+        if(buffers[i] == nullptr) buffers[i] = (char *)malloc(BUFFER_SIZE + 1);
+        if(buffers[i] == nullptr) {
+            printf("ERROR: ReadAheadFile: no memory for buffers\n");
+            stop();
+            return false;
+        }
+    }
+
+    empty_queue = xQueueCreate(NBUFFERS + 1, sizeof(uint8_t));
+    filled_queue = xQueueCreate(NBUFFERS, sizeof(filled_t));
+    if(empty_queue == 0 || filled_queue == 0) {
+        printf("ERROR: ReadAheadFile: failed to create queues\n");
+        stop();
+        return false;
+    }
+
+    for (uint8_t i = 0; i < NBUFFERS; ++i) {
+        xQueueSend(empty_queue, &i, 0);
+    }
+
+    pos = 0;
+    have_buffer = false;
+    done = false;
+    stopping = false;
+    reader_running = true;
+
+    // the same priority as the player thread so it reads while the player waits for room in the queues
+    if(xTaskCreate(reader_task, "ReadAhead", 2000/4, this, (tskIDLE_PRIORITY + 1UL), (TaskHandle_t *) NULL) != pdPASS) {
+        printf("ERROR: ReadAheadFile: failed to create task\n");
+        reader_running = false;
+        stop();
+        return false;
+    }
+
+    return true;
+}
+
+void ReadAheadFile::stop()
+{
+    if(reader_running) {
+        // wake the reader up if it is waiting for a buffer, it finishes any read it is doing first
+        stopping = true;
+        uint8_t none = NBUFFERS;
+        xQueueSend(empty_queue, &none, 0);
+        while(reader_running) {
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+
+    if(empty_queue != 0) vQueueDelete(empty_queue);
+    if(filled_queue != 0) vQueueDelete(filled_queue);
+    empty_queue = filled_queue = 0;
+
+    for (int i = 0; i < NBUFFERS; ++i) {
+        if(buffers[i] == nullptr) continue;
+        if(_RAM4->has(buffers[i])) _RAM4->dealloc(buffers[i]);
+        else free(buffers[i]);
+        buffers[i] = nullptr;
+    }
+    fp = nullptr;
+}
+
+// This is a task
+void ReadAheadFile::reader_task(void *arg)
+{
+    static_cast<ReadAheadFile*>(arg)->reader();
+    vTaskDelete(NULL);
+}
+
+void ReadAheadFile::reader()
+{
+    for (;;) {
+        uint8_t i;
+        xQueueReceive(empty_queue, &i, portMAX_DELAY);
+        if(stopping) break;
+
+        filled_t f;
+        f.index = i;
+        f.len = fread(buffers[i], 1, BUFFER_SIZE, fp);
+        // a read error also ends the file
+        f.eof = f.len < BUFFER_SIZE;
+        // there is always room as there are only as many buffers as the queue holds
+        xQueueSend(filled_queue, &f, portMAX_DELAY);
+        if(f.eof) break;
+    }
+
+    reader_running = false;
+}
+
+// gives the buffer that has been split back to the reader and waits for the next one
+bool ReadAheadFile::next_buffer()
+{
+    if(have_buffer) {
+        if(current.eof) {
+            done = true;
+            have_buffer = false;
+            return false;
+        }
+        xQueueSend(empty_queue, &current.index, 0);
+        have_buffer = false;
+    }
+
+    if(done || filled_queue == 0) return false;
+
+    xQueueReceive(filled_queue, &current, portMAX_DELAY);
+    have_buffer = true;
+    pos = 0;
+    return true;
+}
+
+char *ReadAheadFile::get_line(size_t& n, bool& too_long)
+{
+    n = 0;
+    too_long = false;
+    size_t carried = 0;
+
+    for (;;) {
+        if(!have_buffer || pos >= current.len) {
+            if(!next_buffer()) break;
+            continue;
+        }
+
+        char *p = &buffers[current.index][pos];
+        char *e = (char *)memchr(p, '\n', current.len - pos);
+        size_t l = (e == nullptr) ? current.len - pos : e - p + 1;
+        n += l;
+        pos += l;
+
+        if(carried == 0) {
+            if(e != nullptr) {
+                // the whole line is in this buffer
+                *e = '\0';
+                too_long = e - p > (int)MAX_LINE;
+                return p;
+            }
+            if(current.eof) {
+                // the last line has no newline, there is a spare byte at the end of the buffer
+                p[l] = '\0';
+                too_long = l > MAX_LINE;
+                return p;
+            }
+        }
+
+        // the line runs over the end of the buffer so it is put together in line
+        size_t c = (e == nullptr) ? l : l - 1;
+        if(carried + c > MAX_LINE) {
+            too_long = true;
+        } else {
+            memcpy(&line[carried], p, c);
+        }
+        carried += c;
+        if(e != nullptr) break;
+    }
+
+    if(n == 0) return nullptr;
+
+    line[std::min(carried, MAX_LINE)] = '\0';
+    return line;
+}
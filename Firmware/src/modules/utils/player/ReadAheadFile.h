@@ -0,0 +1,65 @@
+#pragma once
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Reads a file ahead of the player in its own task, so the time the sdcard takes to read does
+ * not hold up the lines being sent.
+ *
+ * The file is read into two large buffers that are passed back and forth between the reader task
+ * and the player, the player splits the lines in place in the buffer it has while the reader fills
+ * the other one. Only a line that runs over the end of a buffer is copied to put it back together.
+ */
+class ReadAheadFile
+{
+public:
+    ReadAheadFile() {};
+    ~ReadAheadFile() { stop(); }
+
+    static const size_t BUFFER_SIZE = 4096;
+    static const size_t MAX_LINE = 128;   // longest line without the newline
+
+    // starts reading fp, false if there is no memory for the buffers or the task
+    bool start(FILE *fp);
+    // stops the reader task and frees the buffers, must be called before the file is closed
+    void stop();
+
+    // the next line without its newline, nullptr at the end of the file. n is set to the number of bytes
+    // it was in the file and too_long is set if it was too long and is not returned whole.
+    // The line is valid until the next call.
+    char *get_line(size_t& n, bool& too_long);
+
+private:
+    static const int NBUFFERS = 2;
+
+    using filled_t = struct {
+        uint16_t len;
+        uint8_t index;
+        bool eof;
+    };
+
+    static void reader_task(void *);
+    void reader();
+    bool next_buffer();
+
+    FILE *fp{nullptr};
+    char *buffers[NBUFFERS]{nullptr, nullptr};
+    QueueHandle_t empty_queue{0};       // buffers the reader can fill
+    QueueHandle_t filled_queue{0};      // buffers the player can split into lines
+
+    // the buffer the player has
+    filled_t current;
+    size_t pos{0};
+    bool have_buffer{false};
+    bool done{false};
+
+    char line[MAX_LINE + 1];    // a line that was split over two buffers
+
+    volatile bool stopping{false};
+    volatile bool reader_running{false};
+};
@@ -3,6 +3,7 @@
 #include "StepTicker.h"
 
 uint8_t Block::n_actuators = 0;
+uint16_t Block::schedule_size = 0;
 
 // A block represents a movement, it's length for each stepper motor, and the corresponding acceleration curves.
 // It's stacked on a queue, and that queue is then executed in order, to move the motors.
@@ -12,12 +13,15 @@ uint8_t Block::n_actuators = 0;
 Block::Block()
 {
     tick_info = nullptr;
+    schedule = nullptr;
     clear();
 }
 
-void Block::init(uint8_t n)
+// n is the number of motors, nruns is the number of step schedule runs each block has, 0 disables it
+void Block::init(uint8_t n, uint16_t nruns)
 {
     n_actuators = n;
+    schedule_size = nruns;
 }
 
 void Block::clear()
@@ -43,7 +47,15 @@ void Block::clear()
     is_ticking          = false;
     is_g123             = false;
     locked              = false;
+    use_schedule        = false;
+    schedule_pending    = false;
+    s_curve             = false;
+    accelerate_ramp     = 0;
+    decelerate_ramp     = 0;
+    jerk_tick[0]        = UINT32_MAX;
     s_value             = 0.0F;
+    raster              = nullptr;
+    raster_size         = 0;
 
     total_move_ticks = 0;
     if(tick_info == nullptr) {
@@ -55,12 +67,22 @@ void Block::clear()
         }
     }
 
+    if(schedule == nullptr && schedule_size > 0) {
+        schedule = new StepSchedule::run_t[schedule_size];
+        if(schedule == nullptr) {
+            abort();
+        }
+    }
+
     for(int i = 0; i < n_actuators; ++i) {
         tick_info[i].steps_per_tick = 0;
         tick_info[i].counter = 0;
         tick_info[i].acceleration_change = 0;
         tick_info[i].deceleration_change = 0;
         tick_info[i].plateau_rate = 0;
+        tick_info[i].jerk_change = 0;
+        tick_info[i].accel_jerk = 0;
+        tick_info[i].decel_jerk = 0;
         tick_info[i].steps_to_move = 0;
         tick_info[i].step_count = 0;
         tick_info[i].next_accel_event = 0;
@@ -73,7 +95,7 @@ void Block::debug() const
     for (size_t i = E_AXIS; i < n_actuators; ++i) {
         printf("%c:%lu ", 'A' + i - E_AXIS, this->steps[i]);
     }
-    printf("(max:%lu) nominal:r%1.4f/s%1.4f mm:%1.4f acc:%1.2f accu:%lu decu:%lu ticks:%lu rates:%1.4f/%1.4f entry/max:%1.4f/%1.4f exit:%1.4f primary:%d ready:%d locked:%d ticking:%d recalc:%d nomlen:%d time:%f\r\n",
+    printf("(max:%lu) nominal:r%1.4f/s%1.4f mm:%1.4f acc:%1.2f accu:%lu decu:%lu ticks:%lu rates:%1.4f/%1.4f entry/max:%1.4f/%1.4f exit:%1.4f primary:%d ready:%d locked:%d ticking:%d recalc:%d nomlen:%d scurve:%lu/%lu time:%f\r\n",
            steps_event_count,
            nominal_rate,
            nominal_speed,
@@ -93,6 +115,8 @@ void Block::debug() const
            is_ticking,
            recalculate_flag ? 1 : 0,
            nominal_length_flag ? 1 : 0,
+           s_curve ? accelerate_ramp : 0,
+           s_curve ? decelerate_ramp : 0,
            total_move_ticks / STEP_TICKER_FREQUENCY
           );
 
@@ -102,6 +126,8 @@ void Block::debug() const
 // returns current rate (steps/sec) for the given actuator
 float Block::get_trapezoid_rate(int i) const
 {
+    if(use_schedule) return StepTicker::getInstance()->get_schedule_rate(i);
+
     // convert steps per tick from fixed point to float and convert to steps/sec
     // FIXME steps_per_tick can change at any time, potential race condition if it changes while being read here
     return STEPTICKER_FROMFP(tick_info[i].steps_per_tick) * STEP_TICKER_FREQUENCY;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ActuatorCoordinates.h"
+#include "StepSchedule.h"
 
 #include <array>
 #include <bitset>
@@ -9,7 +10,7 @@ class Block {
     public:
         Block();
 
-        static void init(uint8_t);
+        static void init(uint8_t, uint16_t);
 
         float get_trapezoid_rate(int i) const;
         void debug() const;
@@ -42,6 +43,9 @@ class Block {
             int64_t acceleration_change; // 2.62 fixed point signed
             int64_t deceleration_change; // 2.62 fixed point
             int64_t plateau_rate; // 2.62 fixed point
+            int64_t jerk_change; // 2.62 fixed point signed, added to acceleration_change each tick for s-curves
+            int64_t accel_jerk; // 2.62 fixed point
+            int64_t decel_jerk; // 2.62 fixed point
             uint32_t steps_to_move;
             uint32_t step_count;
             uint32_t next_accel_event;
@@ -50,7 +54,23 @@ class Block {
         // need info for each active motor
         tickinfo_t *tick_info;
 
+        // for s-curve blocks the jerk changes at these ticks, the code says to what: 0, +-1 +-accel_jerk, +-2 +-decel_jerk,
+        // 3 ends the deceleration ramp and continues at deceleration_change
+        std::array<uint32_t, 9> jerk_tick; // terminated with UINT32_MAX
+        std::array<int8_t, 8> jerk_code;
+        uint32_t accelerate_ramp; // ticks the acceleration takes to ramp up (and down) in s-curve blocks
+        uint32_t decelerate_ramp;
+
+        // the compressed step schedule if enabled, the runs for motor m start at schedule[schedule_index[m]]
+        StepSchedule::run_t *schedule;
+        std::array<uint16_t, k_max_actuators> schedule_index;
+
+        // the PWM duty of each pixel of a raster line for the laser (1.15 fixed point), taken from the RasterBuffer
+        const uint16_t *raster;
+        uint16_t raster_size;
+
         static uint8_t n_actuators;
+        static uint16_t schedule_size;
 
         struct {
             bool recalculate_flag:1;             // Planner flag to recalculate trapezoids on entry junction
@@ -60,6 +80,9 @@ class Block {
             bool is_g123:1;                      // set if this is a G1, G2 or G3
             volatile bool is_ticking:1;          // set when this block is being actively ticked by the stepticker
             volatile bool locked:1;              // set to true when the critical data is being updated, stepticker will have to skip if this is set
+            bool s_curve:1;                      // set if the acceleration is jerk limited
+            volatile bool use_schedule:1;        // set if the block is to be stepped from the schedule rather than the DDA
+            bool schedule_pending:1;             // set when the plan changed and the schedule has not been built for it
             uint16_t s_value:12;                 // for laser 1.11 Fixed point
         };
 };
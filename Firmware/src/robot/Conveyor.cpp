@@ -64,6 +64,8 @@ void Conveyor::on_halt(bool flg)
     if(flg) {
         flush= true;
         continuous= false;
+        // the look-ahead is discarded by the command thread
+        Planner::getInstance()->flush_lookahead();
     }
 }
 
@@ -72,7 +74,7 @@ void Conveyor::on_halt(bool flg)
 // checks that all motors are no longer moving
 bool Conveyor::is_idle() const
 {
-    if(PQUEUE->empty()) {
+    if(PQUEUE->empty() && Planner::getInstance()->lookahead_empty()) {
         for(auto &a : Robot::getInstance()->actuators) {
             if(a->is_moving()) return false;
         }
@@ -86,26 +88,58 @@ bool Conveyor::is_idle() const
 // This must be called in the command thread context and will stall the command thread
 void Conveyor::wait_for_idle(bool wait_for_motors)
 {
-    // wait for the job queue to empty, forcing stepticker to run them
-    while (!PQUEUE->empty()) {
+    // wait for the job queue (and any look-ahead) to empty, forcing stepticker to run them
+    while (!PQUEUE->empty() || !Planner::getInstance()->lookahead_empty()) {
         check_queue(true); // forces queue to be made available to stepticker
-        safe_sleep(10); // is 10ms ok?
+        wait_for_block_release();
     }
 
     if(wait_for_motors) {
         // now we wait for all motors to stop moving
         while(!is_idle()) {
-            safe_sleep(10); // is 10ms ok?
+            wait_for_block_release();
         }
     }
 
     // returning now means that everything has totally finished
 }
 
+// Called by the player thread to hold off sending lines while the planner is full, so the command thread is not
+// stalled with a line it can not plan. Only the command thread plans, so this just waits for it to make room
 void Conveyor::wait_for_room()
 {
-    while (PQUEUE->full()) {
-        safe_sleep(10); // is 10ms ok?
+    Planner *planner= Planner::getInstance();
+    // with the look-ahead the block queue is normally full, room is made by moving nodes into it.
+    // only the command thread is woken on a block release, so this polls
+    while (planner->lookahead != nullptr ? planner->lookahead_full() : PQUEUE->full()) {
+        safe_sleep(10);
+    }
+}
+
+// true if the look-ahead has nodes that will be moved into the block queue as blocks are released
+bool Conveyor::is_filling() const
+{
+    Planner *planner= Planner::getInstance();
+    return running && allow_fetch && planner->lookahead != nullptr && !planner->lookahead_empty();
+}
+
+// Stalls the command thread until the stepticker releases a block, or for at most 10ms,
+// queries are still handled while it waits. There is only the one task to notify so no other thread can wait here
+void Conveyor::wait_for_block_release()
+{
+    waiting_task= xTaskGetCurrentTaskHandle();
+    safe_wait(10);
+    waiting_task= nullptr;
+}
+
+// called from the RTOS tick hook, wakes up the command thread if it is waiting and a block has been released
+void Conveyor::notify_block_release()
+{
+    if(block_released && waiting_task != nullptr) {
+        block_released= false;
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(waiting_task, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
     }
 }
 
@@ -117,19 +151,25 @@ void Conveyor::check_queue(bool force)
     // don't check if we are not running
     if(!force && !running) return;
 
-    if(PQUEUE->empty()) {
+    Planner *planner= Planner::getInstance();
+    if(PQUEUE->empty() && planner->lookahead_empty()) {
         allow_fetch = false;
         last_time_check = xTaskGetTickCount(); // reset timeout
+        planner->fill_queue(); // handles a pending discard
         return;
     }
 
     // if we have been waiting for more than the required waiting time and the queue is not empty, or the queue is full, then allow stepticker to get the tail
     // we do this to allow an idle system to pre load the queue a bit so the first few blocks run smoothly.
-    if(force || PQUEUE->full() || (TICKS2MS(xTaskGetTickCount() - last_time_check) >= queue_delay_time_ms) ) {
+    if(force || PQUEUE->full() || planner->lookahead_full() || (TICKS2MS(xTaskGetTickCount() - last_time_check) >= queue_delay_time_ms) ) {
         last_time_check = xTaskGetTickCount(); // reset timeout
         if(!flush) allow_fetch = true;
-        return;
     }
+
+    // blocks are only made from the look-ahead once the stepticker can fetch them, so they get planned as far ahead as possible
+    if(allow_fetch || force) planner->fill_queue();
+
+    planner->build_schedules();
 }
 
 // called from step ticker ISR
@@ -174,6 +214,7 @@ _ramfunc_ void Conveyor::block_finished()
 {
     // release the tail
     PQUEUE->release_tail();
+    block_released= true;
 }
 
 /*
@@ -187,6 +228,7 @@ void Conveyor::flush_queue()
 {
     allow_fetch = false;
     flush= true;
+    Planner::getInstance()->flush_lookahead();
 
     // TODO force deceleration of last block
 
@@ -2,6 +2,9 @@
 
 #include "Module.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
+
 class PlannerQueue;
 class Block;
 class OutputStream;
@@ -27,7 +30,10 @@ public:
 
     void wait_for_idle(bool wait_for_motors=true);
     void wait_for_room();
+    void wait_for_block_release();
+    void notify_block_release();
     bool is_idle() const;
+    bool is_filling() const;
 
     // returns next available block writes it to block and returns true
     bool get_next_block(Block **block);
@@ -48,6 +54,11 @@ private:
     uint32_t queue_delay_time_ms{100};
     float current_feedrate{0}; // actual nominal feedrate that current block is running at in mm/sec
 
+    // set by the stepticker when it releases a block, the command thread is woken from the tick hook
+    // as the stepticker runs above the priority that can call the RTOS
+    volatile bool block_released{false};
+    volatile TaskHandle_t waiting_task{nullptr}; // the command thread while it waits in wait_for_block_release()
+
     struct {
         volatile bool running:1;
         volatile bool allow_fetch:1;
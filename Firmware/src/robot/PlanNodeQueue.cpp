@@ -0,0 +1,55 @@
+#include "PlanNodeQueue.h"
+
+#include <math.h>
+
+bool PlanNodeQueue::queue_head()
+{
+    if(full()) return false;
+
+    // start again from zero whenever it empties so the potentials do not grow forever
+    if(empty()) m_endPotential = 0;
+
+    size_t i = index_of(m_count);
+    PlanNode& node = m_buffer[i];
+    node.potential = m_endPotential;
+    m_endPotential += 2.0 * node.acceleration * node.millimeters;
+
+    // any earlier limit that is not less than this one can never be the tightest again
+    double l = node.limit();
+    while(m_minCount > 0 && m_buffer[m_minima[(m_minFirst + m_minCount - 1) % m_size]].limit() >= l) {
+        --m_minCount;
+    }
+    m_minima[(m_minFirst + m_minCount) % m_size] = i;
+    ++m_minCount;
+
+    ++m_count;
+    return true;
+}
+
+void PlanNodeQueue::release_tail()
+{
+    if(empty()) return;
+
+    if(m_minCount > 0 && m_minima[m_minFirst] == m_rIndex) {
+        m_minFirst = next(m_minFirst);
+        --m_minCount;
+    }
+
+    m_rIndex = next(m_rIndex);
+    --m_count;
+}
+
+double PlanNodeQueue::second_limit() const
+{
+    // the first entry may be the tail, the limits increase after it so the next one is the smallest of the rest
+    size_t n = 0;
+    if(m_minCount > 0 && m_minima[m_minFirst] == m_rIndex) n = 1;
+    if(n >= m_minCount) return INFINITY;
+    return m_buffer[m_minima[(m_minFirst + n) % m_size]].limit();
+}
+
+double PlanNodeQueue::tail_limit() const
+{
+    if(m_minCount == 0) return INFINITY;
+    return m_buffer[m_minima[m_minFirst]].limit();
+}
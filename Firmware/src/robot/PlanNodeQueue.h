@@ -0,0 +1,113 @@
+//
+//  Fixed size ring buffer of plan nodes for the long look-ahead planner.
+//  Only ever used from the command thread, the stepticker never sees it.
+//
+
+#pragma once
+
+#include "ActuatorCoordinates.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include <bitset>
+
+// The part of a move the planner needs to work out the velocity profile, it is turned into a
+// full Block (with its tick_info) when it gets to the tail of the look-ahead
+struct PlanNode {
+    std::array<uint32_t, k_max_actuators> steps; // Number of steps for each axis for this move
+    std::bitset<k_max_actuators> direction_bits;
+    float millimeters;
+    float nominal_speed;      // mm/sec
+    float acceleration;       // mm/sec²
+    float max_entry_speed;    // junction speed limit
+    float entry_speed;        // only valid for the tail node, it is the exit speed of the block made before it
+    double potential;         // sum of 2*acceleration*millimeters of the nodes before this one, mm²/s²
+    const uint16_t *raster;   // pixels of a raster line, raster_size is 0 if there are none
+    uint16_t raster_size;
+    struct {
+        bool primary_axis:1;
+        bool is_g123:1;
+        uint16_t s_value:12;  // for laser 1.11 Fixed point
+    };
+
+    // decelerating backwards from this junction, the speed² at a node before it is limited to limit() - its potential
+    double limit() const { return (double)max_entry_speed * max_entry_speed + potential; }
+};
+
+class PlanNodeQueue
+{
+public:
+    PlanNodeQueue(size_t length)
+    {
+        m_size = length;
+        m_buffer = new PlanNode[length];
+        m_minima = new uint16_t[length];
+        clear();
+    }
+
+    ~PlanNodeQueue()
+    {
+        delete [] m_buffer;
+        delete [] m_minima;
+    }
+
+    size_t next(size_t n) const { return (n + 1) % m_size; }
+    bool empty() const { return m_count == 0; }
+    // like PlannerQueue one node is always kept free for get_head()
+    bool full() const { return m_count + 1 >= m_size; }
+    size_t size() const { return m_count; }
+
+    void clear()
+    {
+        m_rIndex = 0;
+        m_count = 0;
+        m_minFirst = 0;
+        m_minCount = 0;
+        m_endPotential = 0;
+    }
+
+    // returns the next free node, it is not in the queue until queue_head() is called
+    PlanNode* get_head() { return &m_buffer[(m_rIndex + m_count) % m_size]; }
+
+    // the last node that was queued
+    PlanNode* get_last() { return empty() ? nullptr : &m_buffer[(m_rIndex + m_count - 1) % m_size]; }
+
+    PlanNode* get_tail() { return empty() ? nullptr : &m_buffer[m_rIndex]; }
+
+    // the node after the tail
+    PlanNode* get_second() { return m_count < 2 ? nullptr : &m_buffer[next(m_rIndex)]; }
+
+    // the potential the next node to be queued starts at
+    double end_potential() const { return m_endPotential; }
+
+    // adds the head node to the queue and sets its potential
+    // returns false if the queue is full
+    bool queue_head();
+
+    // removes the tail node
+    void release_tail();
+
+    // the smallest limit() of the nodes from the tail to the head, or INFINITY if there are none
+    double tail_limit() const;
+
+    // the smallest limit() of the nodes from the second one to the head, or INFINITY if there are none.
+    // This is what the speed at the start of the second node is limited by going backwards from the head.
+    double second_limit() const;
+
+private:
+    size_t index_of(size_t i) const { return (m_rIndex + i) % m_size; }
+
+    size_t    m_size;
+    PlanNode *m_buffer;
+    size_t    m_rIndex;
+    size_t    m_count;
+
+    // indexes of the nodes whose limit() is less than all the limits after them, in queue order,
+    // so their limits increase towards the head, the first one at or after a node is the tightest limit on it
+    uint16_t *m_minima;
+    size_t    m_minFirst;
+    size_t    m_minCount;
+
+    double    m_endPotential;
+};
@@ -1,14 +1,18 @@
 #include "Planner.h"
 #include "Block.h"
 #include "PlannerQueue.h"
+#include "PlanNodeQueue.h"
 #include "ConfigReader.h"
 #include "StepperMotor.h"
 #include "AxisDefns.h"
 #include "StepTicker.h"
+#include "StepSchedule.h"
+#include "RasterBuffer.h"
 #include "Robot.h"
 #include "Conveyor.h"
 #include "main.h"
 #include "Module.h"
+#include "stopwatch.h"
 
 #include <math.h>
 #include <algorithm>
@@ -18,6 +22,9 @@
 #define z_junction_deviation_key  "z_junction_deviation"
 #define minimum_planner_speed_key "minimum_planner_speed"
 #define planner_queue_size_key    "planner_queue_size"
+#define step_schedule_size_key    "step_schedule_size"
+#define s_curve_jerk_key          "s_curve_jerk"
+#define lookahead_size_key        "lookahead_size"
 
 Planner *Planner::instance= nullptr;
 
@@ -41,6 +48,14 @@ bool Planner::configure(ConfigReader& cr)
         z_junction_deviation = cr.get_float(m, z_junction_deviation_key, -1);
         minimum_planner_speed = cr.get_float(m, minimum_planner_speed_key, 0.0f);
         planner_queue_size= cr.get_int(m, planner_queue_size_key, 32);
+        step_schedule_size= cr.get_int(m, step_schedule_size_key, 0);
+        s_curve_jerk= cr.get_float(m, s_curve_jerk_key, 0);
+        int n= cr.get_int(m, lookahead_size_key, 0);
+        if(n > 65535) {
+            printf("WARNING: configure-planner: lookahead_size of %d is too big, using 65535\n", n);
+            n= 65535;
+        }
+        lookahead_size= n > 0 ? n : 0;
 
     }else{
         printf("WARNING: configure-planner: no planner section found. defaults loaded\n");
@@ -51,14 +66,22 @@ bool Planner::configure(ConfigReader& cr)
 
 bool Planner::initialize(uint8_t n)
 {
-    Block::init(n); // set the number of motors which determines how big the tick info vector is
+    Block::init(n, step_schedule_size); // set the number of motors which determines how big the tick info vector is
     queue= new PlannerQueue(planner_queue_size);
+    if(lookahead_size > 0) {
+        lookahead= new PlanNodeQueue(lookahead_size);
+        if(lookahead == nullptr) return false;
+    }
     return queue != nullptr;
 }
 
 // Append a block to the queue, compute it's speed factors
 bool Planner::append_block(ActuatorCoordinates& actuator_pos, uint8_t n_motors, float rate_mm_s, float distance, float *unit_vec, float acceleration, float s_value, bool g123)
 {
+    if(lookahead != nullptr) {
+        return append_node(actuator_pos, n_motors, rate_mm_s, distance, unit_vec, acceleration, s_value, g123);
+    }
+
     // get the head block
     Block* block = queue->get_head();
     block->clear();
@@ -89,31 +112,13 @@ bool Planner::append_block(ActuatorCoordinates& actuator_pos, uint8_t n_motors,
     // info needed by laser
     block->s_value = roundf(s_value*(1<<11)); // 1.11 fixed point
     block->is_g123 = g123;
-
-    // use default JD
-    float junction_deviation = this->xy_junction_deviation;
+    // a raster line from the laser goes with the next G1-G3
+    if(g123 && RasterBuffer::getInstance() != nullptr) block->raster = RasterBuffer::getInstance()->take(block->raster_size, block->s_value);
 
     // use either regular junction deviation or z specific and see if a primary axis move
-    block->primary_axis = true;
-    if(block->steps[ALPHA_STEPPER] == 0 && block->steps[BETA_STEPPER] == 0) {
-        if(block->steps[GAMMA_STEPPER] != 0) {
-            // z only move
-            if(this->z_junction_deviation >= 0.0F) junction_deviation = this->z_junction_deviation;
-
-        } else {
-            // is not a primary axis move
-            block->primary_axis= false;
-            #if N_PRIMARY_AXIS > 3
-                for (int i = 3; i < N_PRIMARY_AXIS; ++i) {
-                    if(block->steps[i] != 0){
-                        block->primary_axis= true;
-                        break;
-                    }
-                }
-            #endif
-
-        }
-    }
+    bool primary_axis;
+    float junction_deviation = get_junction_deviation(block->steps, primary_axis);
+    block->primary_axis = primary_axis;
 
     block->acceleration = acceleration; // save in block
 
@@ -137,50 +142,14 @@ bool Planner::append_block(ActuatorCoordinates& actuator_pos, uint8_t n_motors,
     // is equal to the travel/step in the particular axis. For a 45 degree line the steppers of both
     // axes might step for every step event. Travel per step event is then sqrt(travel_x^2+travel_y^2).
 
-    // Compute maximum allowable entry speed at junction by centripetal acceleration approximation.
-    // Let a circle be tangent to both previous and current path line segments, where the junction
-    // deviation is defined as the distance from the junction to the closest edge of the circle,
-    // colinear with the circle center. The circular segment joining the two paths represents the
-    // path of centripetal acceleration. Solve for max velocity based on max acceleration about the
-    // radius of the circle, defined indirectly by junction deviation. This may be also viewed as
-    // path width or max_jerk in the previous grbl version. This approach does not actually deviate
-    // from path, but used as a robust way to compute cornering speeds, as it takes into account the
-    // nonlinearities of both the junction angle and junction velocity.
-
-    // NOTE however it does not take into account independent axis, in most cartesian X and Y and Z are totally independent
-    // and this allows one to stop with little to no decleration in many cases. This is particualrly bad on leadscrew based systems that will skip steps.
-    float vmax_junction = minimum_planner_speed; // Set default max junction speed
-
     // if unit_vec was null then it was not a primary axis move so we skip the junction deviation stuff
+    float previous_nominal_speed = 0;
     if (unit_vec != nullptr && !queue->empty()) {
         queue->start_iteration(); // reset to head
         Block *prev_block = queue->tailward_get(); // gets block prior to head, ie last block
-        float previous_nominal_speed = prev_block->primary_axis ? prev_block->nominal_speed : 0;
-
-        if (junction_deviation > 0.000001F && previous_nominal_speed > 0.000001F) {
-            // Compute cosine of angle between previous and current path. (prev_unit_vec is negative)
-            // NOTE: Max junction velocity is computed without sin() or acos() by trig half angle identity.
-            float cos_theta = - this->previous_unit_vec[X_AXIS] * unit_vec[X_AXIS]
-                              - this->previous_unit_vec[Y_AXIS] * unit_vec[Y_AXIS]
-                              - this->previous_unit_vec[Z_AXIS] * unit_vec[Z_AXIS];
-            #if N_PRIMARY_AXIS > 3
-                for (int i = 3; i < N_PRIMARY_AXIS; ++i) {
-                    cos_theta -= this->previous_unit_vec[i] * unit_vec[i];
-                }
-            #endif
-
-            // Skip and use default max junction speed for 0 degree acute junction.
-            if (cos_theta <= 0.9999F) {
-                vmax_junction = std::min(previous_nominal_speed, block->nominal_speed);
-                // Skip and avoid divide by zero for straight junctions at 180 degrees. Limit to min() of nominal speeds.
-                if (cos_theta >= -0.9999F) {
-                    // Compute maximum junction velocity based on maximum acceleration and junction deviation
-                    float sin_theta_d2 = sqrtf(0.5F * (1.0F - cos_theta)); // Trig half angle identity. Always positive.
-                    vmax_junction = std::min(vmax_junction, sqrtf(acceleration * junction_deviation * sin_theta_d2 / (1.0F - sin_theta_d2)));
-                }
-            }
-        }
+        previous_nominal_speed = prev_block->primary_axis ? prev_block->nominal_speed : 0;
     }
+    float vmax_junction = max_junction_speed(previous_nominal_speed, unit_vec, block->nominal_speed, acceleration, junction_deviation);
     block->max_entry_speed = vmax_junction;
 
     // Initialize block entry speed. Compute based on deceleration to user-defined minimum_planner_speed.
@@ -211,6 +180,9 @@ bool Planner::append_block(ActuatorCoordinates& actuator_pos, uint8_t n_motors,
     // Math-heavy re-computing of the whole queue to take the new
     this->recalculate();
 
+    // the recalculation may have changed the next block to be fetched after it was built
+    build_schedules();
+
     // The block can now be used
     block->ready();
 
@@ -219,7 +191,7 @@ bool Planner::append_block(ActuatorCoordinates& actuator_pos, uint8_t n_motors,
     while(!queue->queue_head()) {
         // queue is full
         // stall the command thread until we have room in the queue
-        safe_sleep(10); // is 10ms a good stall time?
+        Conveyor::getInstance()->wait_for_block_release();
 
         if(Module::is_halted()) {
             // we do not want to stick more stuff on the queue if we are in halt state
@@ -235,6 +207,267 @@ bool Planner::append_block(ActuatorCoordinates& actuator_pos, uint8_t n_motors,
     return true;
 }
 
+// returns the junction deviation to use for a move with the given steps, and whether it is a primary axis move
+float Planner::get_junction_deviation(const std::array<uint32_t, k_max_actuators>& steps, bool& primary_axis) const
+{
+    // use default JD
+    float junction_deviation = this->xy_junction_deviation;
+
+    // use either regular junction deviation or z specific and see if a primary axis move
+    primary_axis = true;
+    if(steps[ALPHA_STEPPER] == 0 && steps[BETA_STEPPER] == 0) {
+        if(steps[GAMMA_STEPPER] != 0) {
+            // z only move
+            if(this->z_junction_deviation >= 0.0F) junction_deviation = this->z_junction_deviation;
+
+        } else {
+            // is not a primary axis move
+            primary_axis= false;
+            #if N_PRIMARY_AXIS > 3
+                for (int i = 3; i < N_PRIMARY_AXIS; ++i) {
+                    if(steps[i] != 0){
+                        primary_axis= true;
+                        break;
+                    }
+                }
+            #endif
+
+        }
+    }
+
+    return junction_deviation;
+}
+
+// Compute maximum allowable entry speed at junction by centripetal acceleration approximation.
+// Let a circle be tangent to both previous and current path line segments, where the junction
+// deviation is defined as the distance from the junction to the closest edge of the circle,
+// colinear with the circle center. The circular segment joining the two paths represents the
+// path of centripetal acceleration. Solve for max velocity based on max acceleration about the
+// radius of the circle, defined indirectly by junction deviation. This may be also viewed as
+// path width or max_jerk in the previous grbl version. This approach does not actually deviate
+// from path, but used as a robust way to compute cornering speeds, as it takes into account the
+// nonlinearities of both the junction angle and junction velocity.
+
+// NOTE however it does not take into account independent axis, in most cartesian X and Y and Z are totally independent
+// and this allows one to stop with little to no decleration in many cases. This is particualrly bad on leadscrew based systems that will skip steps.
+float Planner::max_junction_speed(float previous_nominal_speed, const float unit_vec[], float nominal_speed, float acceleration, float junction_deviation) const
+{
+    float vmax_junction = minimum_planner_speed; // Set default max junction speed
+
+    if (unit_vec != nullptr && junction_deviation > 0.000001F && previous_nominal_speed > 0.000001F) {
+        // Compute cosine of angle between previous and current path. (prev_unit_vec is negative)
+        // NOTE: Max junction velocity is computed without sin() or acos() by trig half angle identity.
+        float cos_theta = - this->previous_unit_vec[X_AXIS] * unit_vec[X_AXIS]
+                          - this->previous_unit_vec[Y_AXIS] * unit_vec[Y_AXIS]
+                          - this->previous_unit_vec[Z_AXIS] * unit_vec[Z_AXIS];
+        #if N_PRIMARY_AXIS > 3
+            for (int i = 3; i < N_PRIMARY_AXIS; ++i) {
+                cos_theta -= this->previous_unit_vec[i] * unit_vec[i];
+            }
+        #endif
+
+        // Skip and use default max junction speed for 0 degree acute junction.
+        if (cos_theta <= 0.9999F) {
+            vmax_junction = std::min(previous_nominal_speed, nominal_speed);
+            // Skip and avoid divide by zero for straight junctions at 180 degrees. Limit to min() of nominal speeds.
+            if (cos_theta >= -0.9999F) {
+                // Compute maximum junction velocity based on maximum acceleration and junction deviation
+                float sin_theta_d2 = sqrtf(0.5F * (1.0F - cos_theta)); // Trig half angle identity. Always positive.
+                vmax_junction = std::min(vmax_junction, sqrtf(acceleration * junction_deviation * sin_theta_d2 / (1.0F - sin_theta_d2)));
+            }
+        }
+    }
+
+    return vmax_junction;
+}
+
+/*
+ * Long look-ahead
+ *
+ * When lookahead_size is set moves are appended to a queue of compact plan nodes instead of the block queue,
+ * they are only made into Blocks (which is when the trapezoid and tick_info are worked out) as the block
+ * queue has room, so the block queue can be short and the look-ahead hundreds of moves long.
+ *
+ * Rather than walking back from the head on every append the reverse pass is kept incrementally:
+ * going back from a junction with speed limit v_j, the speed at the start of an earlier node k is limited to
+ *   v_k² <= v_j² + 2 * sum(acceleration * millimeters of nodes k..j-1) = v_j² + P_j - P_k
+ * where P is the running sum (potential) of 2*acceleration*millimeters, so the limit on node k is the smallest
+ * v_j² + P_j of the junctions from k to the end of the head (where it has to get down to minimum_planner_speed)
+ * less P_k. The queue keeps the nodes whose v_j² + P_j is less than all those after it, so appending a node
+ * drops the ones it makes redundant (amortized O(1)) and the tightest limit on the second node is the first
+ * one kept. The forward pass only has to be done from the tail node, one node at a time, as it is made
+ * into a block, as its entry speed is already fixed.
+ */
+
+bool Planner::append_node(ActuatorCoordinates& actuator_pos, uint8_t n_motors, float rate_mm_s, float distance, float *unit_vec, float acceleration, float s_value, bool g123)
+{
+    PlanNode *node= lookahead->get_head();
+    node->steps.fill(0);
+    node->direction_bits= 0;
+
+    bool has_steps = false;
+    for (size_t i = 0; i < n_motors; i++) {
+        int32_t steps = Robot::getInstance()->actuators[i]->steps_to_target(actuator_pos[i]);
+        // Update current position
+        if(steps != 0) {
+            Robot::getInstance()->actuators[i]->update_last_milestones(actuator_pos[i], steps);
+            has_steps = true;
+        }
+
+        node->direction_bits[i] = (steps < 0) ? 1 : 0;
+        node->steps[i] = labs(steps);
+    }
+
+    // as for blocks we still need to accumulate the move
+    if(!has_steps) return true;
+
+    node->s_value = roundf(s_value*(1<<11)); // 1.11 fixed point
+    node->is_g123 = g123;
+    node->raster = nullptr;
+    node->raster_size = 0;
+    if(g123 && RasterBuffer::getInstance() != nullptr) node->raster = RasterBuffer::getInstance()->take(node->raster_size, node->s_value);
+
+    bool primary_axis;
+    float junction_deviation = get_junction_deviation(node->steps, primary_axis);
+    node->primary_axis = primary_axis;
+
+    node->acceleration = acceleration;
+    node->millimeters = distance;
+    node->nominal_speed = (distance > 0.0F) ? rate_mm_s : 0.0F;
+
+    // the previous move is either still in the look-ahead or has already been made into a block
+    float previous_nominal_speed = 0;
+    if(unit_vec != nullptr) {
+        PlanNode *prev_node = lookahead->get_last();
+        if(prev_node != nullptr) {
+            previous_nominal_speed = prev_node->primary_axis ? prev_node->nominal_speed : 0;
+        } else if(!queue->empty()) {
+            queue->start_iteration(); // reset to head
+            Block *prev_block = queue->tailward_get();
+            previous_nominal_speed = prev_block->primary_axis ? prev_block->nominal_speed : 0;
+        }
+    }
+    node->max_entry_speed = max_junction_speed(previous_nominal_speed, unit_vec, node->nominal_speed, acceleration, junction_deviation);
+
+    // if this becomes the tail straight away the block before it has been planned to end at minimum_planner_speed
+    node->entry_speed = std::min(node->max_entry_speed, minimum_planner_speed);
+
+    // Update previous path unit_vector
+    if(unit_vec != nullptr) {
+        memcpy(previous_unit_vec, unit_vec, sizeof(previous_unit_vec)); // previous_unit_vec[] = unit_vec[]
+    } else {
+        memset(previous_unit_vec, 0, sizeof(previous_unit_vec));
+    }
+
+    while(!lookahead->queue_head()) {
+        // look-ahead is full, wait for the conveyor to make room by moving nodes into the block queue
+        Conveyor::getInstance()->wait_for_block_release();
+
+        if(Module::is_halted()) {
+            return false;
+        }
+
+        Conveyor::getInstance()->check_queue();
+    }
+
+    return true;
+}
+
+bool Planner::lookahead_empty() const
+{
+    return lookahead == nullptr || lookahead->empty();
+}
+
+bool Planner::lookahead_full() const
+{
+    return lookahead != nullptr && lookahead->full();
+}
+
+// makes blocks from the look-ahead until the block queue is full, called from the command thread by the conveyor
+void Planner::fill_queue()
+{
+    if(lookahead == nullptr) return;
+
+    if(discard_lookahead || Module::is_halted()) {
+        lookahead->clear();
+        open_tail= false;
+        discard_lookahead= false;
+        return;
+    }
+
+    while(!lookahead->empty() && !queue->full()) {
+        materialize();
+    }
+}
+
+// the slowest a move can end at decelerating from entry_speed
+static float min_exit_speed(float acceleration, float entry_speed, float distance)
+{
+    float v2= entry_speed * entry_speed - 2.0F * acceleration * distance;
+    return v2 > 0 ? sqrtf(v2) : 0;
+}
+
+// makes the tail node of the look-ahead into a block on the block queue
+void Planner::materialize()
+{
+    PlanNode *node= lookahead->get_tail();
+    PlanNode *next= lookahead->get_second();
+    double end_limit= (double)minimum_planner_speed * minimum_planner_speed + lookahead->end_potential();
+
+    float entry_speed= node->entry_speed;
+    if(open_tail && !queue->empty()) {
+        // the last block had nothing after it when it was made so it ends at minimum_planner_speed, if it has not
+        // started yet it can go into this node faster, otherwise it keeps the exit speed it is running with
+        queue->start_iteration();
+        Block *prev= queue->tailward_get();
+        double l= std::min(lookahead->tail_limit(), end_limit) - node->potential;
+        float exit_speed= std::min({(float)sqrt(std::max(l, 0.0)), max_exit_speed(prev), node->nominal_speed});
+        exit_speed= std::max(exit_speed, min_exit_speed(prev->acceleration, prev->entry_speed, prev->millimeters));
+        calculate_trapezoid(prev, prev->entry_speed, exit_speed);
+        entry_speed= prev->exit_speed;
+    }
+
+    float exit_speed;
+    if(next == nullptr) {
+        // the last node has to be able to stop
+        exit_speed= minimum_planner_speed;
+        open_tail= true;
+
+    } else {
+        // the forward pass, the fastest exit speed it can accelerate to that the rest of the look-ahead allows
+        double l= std::min(lookahead->second_limit(), end_limit) - next->potential;
+        exit_speed= std::min({(float)sqrt(std::max(l, 0.0)), max_allowable_speed(-node->acceleration, entry_speed, node->millimeters),
+                              node->nominal_speed, next->nominal_speed});
+        // the only way it cannot slow down in time is if a junction is slower than minimum_planner_speed
+        exit_speed= std::max(exit_speed, min_exit_speed(node->acceleration, entry_speed, node->millimeters));
+        next->entry_speed= exit_speed;
+        open_tail= false;
+    }
+
+    Block *block= queue->get_head();
+    block->clear();
+    block->steps= node->steps;
+    block->direction_bits= node->direction_bits;
+    block->steps_event_count= *std::max_element(node->steps.begin(), node->steps.end());
+    block->millimeters= node->millimeters;
+    block->nominal_speed= node->nominal_speed;
+    block->nominal_rate= (node->millimeters > 0.0F) ? block->steps_event_count * node->nominal_speed / node->millimeters : 0;
+    block->acceleration= node->acceleration;
+    block->max_entry_speed= node->max_entry_speed;
+    block->entry_speed= entry_speed;
+    block->primary_axis= node->primary_axis;
+    block->is_g123= node->is_g123;
+    block->s_value= node->s_value;
+    block->raster= node->raster;
+    block->raster_size= node->raster_size;
+
+    calculate_trapezoid(block, entry_speed, exit_speed);
+    block->ready();
+
+    queue->queue_head();
+    lookahead->release_tail();
+}
+
 void Planner::recalculate()
 {
     Block* previous;
@@ -381,6 +614,11 @@ void Planner::calculate_trapezoid(Block *block, float entryspeed, float exitspee
 
     // Figure out how long the move takes total ( in seconds )
     float total_move_time = time_to_accelerate + time_to_decelerate + plateau_time;
+
+    // the jerk limited acceleration ramps up to the planned acceleration and back down so it takes longer
+    if(s_curve_jerk > 0 && s_curve_timing(block, initial_rate, final_rate, acceleration_per_second, time_to_accelerate, time_to_decelerate, plateau_time)) {
+        total_move_time = time_to_accelerate + time_to_decelerate + plateau_time;
+    }
     // printf("total move time: %f s time to accelerate: %f, time to decelerate: %f\n", total_move_time, time_to_accelerate, time_to_decelerate);
 
     // We now have the full timing for acceleration, plateau and deceleration,
@@ -557,4 +795,185 @@ void Planner::prepare(Block *block, float acceleration_in_steps, float decelerat
         );
         #endif
     }
+
+    block->s_curve= false;
+    block->accelerate_ramp= 0;
+    block->decelerate_ramp= 0;
+    if(s_curve_jerk > 0) prepare_s_curve(block, acceleration_in_steps, deceleration_in_steps);
+
+    // the plan may still change, the schedule is built by build_schedules() once it is final
+    block->use_schedule= false;
+    block->schedule_pending= step_schedule_size > 0 && !block->s_curve;
+}
+
+// Builds the step schedule of the blocks the planner will not change again, and of the next block
+// the stepticker will fetch. Only called on the command thread, which is the only thread that plans,
+// and the schedule is built without locking the block so the stepticker is never held up by it.
+void Planner::build_schedules()
+{
+    if(step_schedule_size == 0 || queue->empty()) return;
+
+    // walking from the newest block, the recalculation never gets past a block that does not need recalculating,
+    // and with the look-ahead only the newest block can be changed when the next one is made
+    bool final= false;
+    Block *next= nullptr;
+    queue->start_iteration();
+    while(!queue->is_at_tail()) {
+        Block *b= queue->tailward_get();
+        if(b->is_ticking) break;
+        if(final) build_schedule(b);
+        if(lookahead != nullptr || !b->recalculate_flag) final= true;
+        next= b;
+    }
+
+    // the oldest block not being stepped is the next one to be fetched
+    if(next != nullptr) build_schedule(next);
+}
+
+void Planner::build_schedule(Block *b)
+{
+    if(!b->schedule_pending) return;
+
+    uint32_t t= StopWatch_Start();
+    bool ok= StepSchedule::build(b, step_schedule_size);
+    t= StopWatch_Elapsed(t);
+    schedule_stats.count++;
+    schedule_stats.time += t;
+    if(t > schedule_stats.max_time) schedule_stats.max_time= t;
+    for (uint8_t m = 0; m < Block::n_actuators; ++m) schedule_stats.steps += b->steps[m];
+
+    // the stepticker decides how to step a block when it fetches it, and does not fetch locked blocks
+    b->locked= true;
+    if(!b->is_ticking) b->use_schedule= ok;
+    b->schedule_pending= false;
+    b->locked= false;
+}
+
+// the time in seconds to change the rate by dv steps/s when the acceleration ramps up to at most a steps/s² and
+// back down again at a jerk of j steps/s³
+static float s_curve_time(float dv, float a, float j)
+{
+    if(dv <= 0) return 0;
+    return (dv >= a * a / j) ? dv / a + a / j : 2.0F * sqrtf(dv / j);
+}
+
+// Works out the timing of a block for the s-curve so its acceleration never goes over the planned acceleration.
+// Each phase takes longer than with constant acceleration to change the rate as much, and as the ramps are symmetric
+// it still averages the rates it starts and ends at, so it also covers more steps. That comes out of the plateau, and
+// if there is not enough plateau the peak rate is lowered until the phases fit in the block.
+// returns false and leaves the timing as it was if the block is too short to change the rate that much
+bool Planner::s_curve_timing(Block *block, float initial_rate, float final_rate, float acceleration, float& time_to_accelerate, float& time_to_decelerate, float& plateau_time) const
+{
+    float jerk= s_curve_jerk * block->steps_event_count / block->millimeters; // steps/s³
+    float steps= block->steps_event_count;
+    float ta, td;
+    auto distance= [&](float rate) {
+        ta= s_curve_time(rate - initial_rate, acceleration, jerk);
+        td= s_curve_time(rate - final_rate, acceleration, jerk);
+        return (initial_rate + rate) / 2.0F * ta + (rate + final_rate) / 2.0F * td;
+    };
+
+    float rate= block->maximum_rate;
+    if(distance(rate) > steps) {
+        float lo= std::max(initial_rate, final_rate);
+        if(distance(lo) > steps) return false;
+
+        // the steps taken grow with the peak rate, so bisect for the fastest one that fits
+        float hi= rate;
+        for (int i = 0; i < 16; ++i) {
+            float mid= (lo + hi) / 2.0F;
+            if(distance(mid) > steps) hi= mid;
+            else lo= mid;
+        }
+        rate= lo;
+        block->maximum_rate= rate;
+    }
+
+    float d= distance(rate);
+    time_to_accelerate= ta;
+    time_to_decelerate= td;
+    plateau_time= (steps - d) / rate;
+    return true;
+}
+
+// returns the number of ticks the acceleration takes to ramp up to its peak (and back down) for an acceleration phase
+// of the given ticks, so the peak is no more than peak when the phase averages average (any units, the same for both)
+// 0 if the phase is too short to shape or does not need to be
+uint32_t Planner::s_curve_ramp(uint32_t ticks, float average, float peak) const
+{
+    if(ticks < 2 || peak <= 0) return 0;
+
+    // ramping for r of T ticks gives a peak acceleration of average*T/(T-r), rounding the ramp down keeps it under peak
+    float r= floorf(ticks * (1.0F - average / peak));
+    if(r < 1) return 0;
+
+    uint32_t n= r;
+    if(n > ticks / 2) n= ticks / 2;
+    return n;
+}
+
+// Replaces the constant acceleration and deceleration with jerk limited ones (7 segment s-curve).
+// calculate_trapezoid() has already lengthened the phases with s_curve_timing() so that ramping the acceleration up to
+// the planned acceleration and back down changes the rate by as much as the average acceleration of the phase does.
+// The ramps are symmetric so each phase still covers the steps the plan gives it, and the junction speeds are unchanged.
+void Planner::prepare_s_curve(Block *block, float acceleration_in_steps, float deceleration_in_steps)
+{
+    uint32_t au= block->accelerate_until;
+    uint32_t da= block->decelerate_after;
+    uint32_t total= block->total_move_ticks;
+
+    // deceleration starts the tick after decelerate_after, or at the start if the block starts off decelerating
+    bool decelerates= (da < total) || (au == 0 && da == 0);
+    uint32_t sd= (au == 0 && da == 0) ? 0 : da + 1;
+    uint32_t td= total - da;
+
+    float peak= block->acceleration * block->steps_event_count / block->millimeters; // steps/s²
+    uint32_t ra= s_curve_ramp(au, acceleration_in_steps, peak);
+    uint32_t rd= decelerates ? s_curve_ramp(td, deceleration_in_steps, peak) : 0;
+    if(ra == 0 && rd == 0) return;
+
+    int n= 0;
+    auto add_event= [block, &n](uint32_t tick, int8_t code) {
+        if(n > 0 && block->jerk_tick[n - 1] == tick) {
+            block->jerk_code[n - 1]= code;
+        } else {
+            block->jerk_tick[n]= tick;
+            block->jerk_code[n++]= code;
+        }
+    };
+
+    if(ra > 0) {
+        add_event(0, 1);
+        add_event(ra, 0);
+        add_event(au - ra, -1);
+        add_event(au, 0);
+    }
+    if(rd > 0) {
+        add_event(sd, -2);
+        add_event(sd + rd, 0);
+        add_event(sd + td - rd, 2);
+        // any steps left after the deceleration are finished at the deceleration rate, as without the s-curve
+        add_event(sd + td, 3);
+    }
+    block->jerk_tick[n]= UINT32_MAX;
+
+    for (uint8_t m = 0; m < Block::n_actuators; m++) {
+        Block::tickinfo_t& ti= block->tick_info[m];
+        if(ti.steps_to_move == 0) continue;
+
+        // the jerk that changes the rate by the same amount as the constant acceleration did
+        if(ra > 0) {
+            ti.accel_jerk= llround((double)ti.acceleration_change * au / ((double)ra * (au - ra)));
+            ti.acceleration_change= 0;
+        }
+        if(rd > 0) {
+            ti.decel_jerk= llround(-(double)ti.deceleration_change * td / ((double)rd * (td - rd)));
+            if(au == 0 && da == 0) ti.acceleration_change= 0;
+        }
+        ti.jerk_change= 0;
+    }
+
+    block->accelerate_ramp= ra;
+    block->decelerate_ramp= rd;
+    block->s_curve= true;
 }
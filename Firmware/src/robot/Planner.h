@@ -6,6 +6,7 @@
 
 class Block;
 class PlannerQueue;
+class PlanNodeQueue;
 class ConfigReader;
 class Conveyor;
 
@@ -26,6 +27,10 @@ public:
     bool configure(ConfigReader& cr);
     bool initialize(uint8_t n);
 
+    // what building the step schedules has cost the command thread, times in StopWatch ticks
+    struct schedule_stats_t { uint32_t count; uint64_t steps; uint64_t time; uint32_t max_time; };
+    const schedule_stats_t& get_schedule_stats() const { return schedule_stats; }
+
 private:
     static Planner *instance;
     float max_exit_speed(Block *);
@@ -35,19 +40,43 @@ private:
     float reverse_pass(Block *, float exit_speed);
     float forward_pass(Block *, float next_entry_speed);
     void prepare(Block *, float acceleration_in_steps, float deceleration_in_steps);
+    bool s_curve_timing(Block *, float initial_rate, float final_rate, float acceleration, float& time_to_accelerate, float& time_to_decelerate, float& plateau_time) const;
+    void prepare_s_curve(Block *, float acceleration_in_steps, float deceleration_in_steps);
+    uint32_t s_curve_ramp(uint32_t ticks, float average, float peak) const;
+    void build_schedules();
+    void build_schedule(Block *);
 
     bool append_block(ActuatorCoordinates& target, uint8_t n_motors, float rate_mm_s, float distance, float unit_vec[], float accleration, float s_value, bool g123);
+    bool append_node(ActuatorCoordinates& target, uint8_t n_motors, float rate_mm_s, float distance, float unit_vec[], float accleration, float s_value, bool g123);
+    float get_junction_deviation(const std::array<uint32_t, k_max_actuators>& steps, bool& primary_axis) const;
+    float max_junction_speed(float previous_nominal_speed, const float unit_vec[], float nominal_speed, float acceleration, float junction_deviation) const;
     void recalculate();
 
+    // the long look-ahead, only used when lookahead_size is set
+    bool lookahead_empty() const;
+    bool lookahead_full() const;
+    void fill_queue();
+    void materialize();
+    void flush_lookahead() { discard_lookahead= true; }
+
     double fp_scale; // optimize to store this as it does not change
 
     PlannerQueue *queue{nullptr};
+    PlanNodeQueue *lookahead{nullptr};
     float previous_unit_vec[N_PRIMARY_AXIS];
 
     float xy_junction_deviation{0.05F};    // Setting
     float z_junction_deviation{NAN};  // Setting
     float minimum_planner_speed{0.0F}; // Setting
     int planner_queue_size{32}; // setting
+    uint16_t step_schedule_size{0}; // setting, runs per block for the precomputed step schedule, 0 uses the DDA
+    float s_curve_jerk{0}; // setting, mm/s³ jerk limit for s-curve acceleration, 0 is constant acceleration
+    uint16_t lookahead_size{0}; // setting, number of moves planned ahead of the block queue, 0 plans in the block queue only
+
+    schedule_stats_t schedule_stats{0, 0, 0, 0};
+
+    bool open_tail{false}; // set when the last block was made from the last node in the look-ahead, so it was planned to stop
+    volatile bool discard_lookahead{false};
 
     // FIXME should really just make getters and setters or handle the set/get gcode here
     friend Robot;
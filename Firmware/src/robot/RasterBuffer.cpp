@@ -0,0 +1,64 @@
+#include "RasterBuffer.h"
+
+#include <string.h>
+
+RasterBuffer *RasterBuffer::instance= nullptr;
+
+RasterBuffer::RasterBuffer(size_t size)
+{
+    buf= new uint16_t[size];
+    this->size= (buf == nullptr) ? 0 : size;
+    if(instance == nullptr) instance= this;
+}
+
+RasterBuffer::~RasterBuffer()
+{
+    if(instance == this) instance= nullptr;
+    delete [] buf;
+}
+
+bool RasterBuffer::add(const uint8_t *pixels, size_t n)
+{
+    // tail is moved by the step ticker so only read it once
+    size_t t= tail;
+    size_t len= head - start;
+
+    if(start >= t) {
+        // the lines in use are all between tail and start, so the free space is after head and before tail
+        if(head + n > size) {
+            // move the line being built to the start, it must not reach tail or the buffer would look empty
+            if(len + n >= t) return false;
+            memmove(buf, &buf[start], len * sizeof(uint16_t));
+            start= 0;
+            head= len;
+        }
+
+    } else if(head + n >= t) {
+        // the lines in use wrap around the end, the free space is between head and tail
+        return false;
+    }
+
+    for (size_t i = 0; i < n; ++i) buf[head + i]= pixels[i];
+    head += n;
+    return true;
+}
+
+const uint16_t *RasterBuffer::take(uint16_t& n, uint16_t s_value)
+{
+    n= head - start;
+    if(n == 0) return nullptr;
+
+    uint16_t *p= &buf[start];
+    if(prepare_fnc) prepare_fnc(p, n, s_value);
+    start= head;
+    return p;
+}
+
+void RasterBuffer::reset()
+{
+    size_t len= head - start;
+    memmove(buf, &buf[start], len * sizeof(uint16_t));
+    start= 0;
+    head= len;
+    tail= 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+/*
+ * Holds the pixels of the raster lines in the queued blocks, a pixel is the power (0-255) to use
+ * for its share of the primary axis steps of the move.
+ *
+ * The command thread adds the pixels for a line, the next G1-G3 takes them into its block and the
+ * step ticker releases them when that block has finished, so the lines are released in the order
+ * they were taken. A line is always contiguous so the step ticker can index it, a line that does
+ * not fit at the end of the buffer is moved to the start.
+ *
+ * When a line is taken it is converted in place by prepare_fnc, with the S value of the move, to
+ * what the step ticker outputs for each pixel (the PWM duty for the laser).
+ */
+class RasterBuffer
+{
+public:
+    RasterBuffer(size_t size);
+    ~RasterBuffer();
+
+    static RasterBuffer *getInstance() { return instance; }
+
+    bool is_valid() const { return buf != nullptr; }
+    size_t get_size() const { return size; }
+
+    // adds pixels to the line being built, false if there is not room for them until more blocks have finished
+    bool add(const uint8_t *pixels, size_t n);
+    // number of pixels in the line being built
+    size_t pending() const { return head - start; }
+    // takes the line being built for a block with the S value s_value (1.11 fixed point), n is set to its length,
+    // nullptr if there is no line
+    const uint16_t *take(uint16_t& n, uint16_t s_value);
+    // called from the step ticker when the block using the line ending at end has finished
+    void release(const uint16_t *end) { tail = end - buf; }
+
+    // converts the n pixels of a line when it is taken, called on the command thread
+    std::function<void(uint16_t *line, size_t n, uint16_t s_value)> prepare_fnc{nullptr};
+    // only called when no queued block is using the buffer, keeps the line being built
+    void reset();
+
+private:
+    static RasterBuffer *instance;
+
+    uint16_t *buf;
+    size_t size;
+    size_t start{0};            // start of the line being built
+    size_t head{0};             // end of the line being built
+    volatile size_t tail{0};    // start of the oldest line a block is still using
+};
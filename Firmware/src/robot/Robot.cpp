@@ -6,6 +6,7 @@
 #include "StepperMotor.h"
 #include "GCode.h"
 #include "StepTicker.h"
+#include "RasterBuffer.h"
 #include "ConfigReader.h"
 #include "StringUtils.h"
 #include "main.h"
@@ -373,11 +374,8 @@ bool Robot::configure(ConfigReader& cr)
     using std::placeholders::_1;
     using std::placeholders::_2;
 
-    // G Code handlers
-    THEDISPATCHER->add_handler(Dispatcher::GCODE_HANDLER, 0, std::bind(&Robot::handle_motion_command, this, _1, _2));
-    THEDISPATCHER->add_handler(Dispatcher::GCODE_HANDLER, 1, std::bind(&Robot::handle_motion_command, this, _1, _2));
-    THEDISPATCHER->add_handler(Dispatcher::GCODE_HANDLER, 2, std::bind(&Robot::handle_motion_command, this, _1, _2));
-    THEDISPATCHER->add_handler(Dispatcher::GCODE_HANDLER, 3, std::bind(&Robot::handle_motion_command, this, _1, _2));
+    // G Code handlers, G0-G3 are called directly by the dispatcher
+    THEDISPATCHER->set_motion_handler(&Robot::motion_command);
 
     THEDISPATCHER->add_handler(Dispatcher::GCODE_HANDLER, 4, std::bind(&Robot::handle_dwell, this, _1, _2));
 
@@ -1080,7 +1078,7 @@ bool Robot::handle_mcodes(GCode& gcode, OutputStream& os)
             }
             break;
 
-        case 205: // M205 Xnnn - set junction deviation, Z - set Z junction deviation, Snnn - Set minimum planner speed
+        case 205: // M205 Xnnn - set junction deviation, Z - set Z junction deviation, Snnn - Set minimum planner speed, Jnnn - set s-curve jerk
             if (gcode.has_arg('X')) {
                 float jd = gcode.get_arg('X');
                 // enforce minimum
@@ -1101,6 +1099,13 @@ bool Robot::handle_mcodes(GCode& gcode, OutputStream& os)
                     mps = 0.0F;
                 Planner::getInstance()->minimum_planner_speed = mps;
             }
+            if (gcode.has_arg('J')) {
+                float j = gcode.get_arg('J');
+                // 0 disables s-curve acceleration
+                if (j < 0.0F)
+                    j = 0.0F;
+                Planner::getInstance()->s_curve_jerk = j;
+            }
             break;
 
         case 220: // M220 - speed override percentage
@@ -1268,7 +1273,7 @@ bool Robot::handle_M500(GCode& gcode, OutputStream& os)
     }
     os.printf("\n");
 
-    os.printf(";X- Junction Deviation, Z- Z junction deviation, S - Minimum Planner speed mm/sec:\nM205 X%1.5f Z%1.5f S%1.5f\n", Planner::getInstance()->xy_junction_deviation, Planner::getInstance()->z_junction_deviation, Planner::getInstance()->minimum_planner_speed);
+    os.printf(";X- Junction Deviation, Z- Z junction deviation, S - Minimum Planner speed mm/sec, J - s-curve jerk mm/sec^3:\nM205 X%1.5f Z%1.5f S%1.5f J%1.5f\n", Planner::getInstance()->xy_junction_deviation, Planner::getInstance()->z_junction_deviation, Planner::getInstance()->minimum_planner_speed, Planner::getInstance()->s_curve_jerk);
 
     os.printf(";Max cartesian feedrates in mm/sec, S - Seek rate, P - overall max speed:\nM203 X%1.5f Y%1.5f Z%1.5f S%1.5f", max_speeds[X_AXIS], max_speeds[Y_AXIS], max_speeds[Z_AXIS], seek_rate/60);
     if(max_speed > 0.1F) {
@@ -1340,7 +1345,7 @@ bool Robot::handle_M665(GCode& gcode, OutputStream& os)
 {
     // M665 set optional arm solution variables based on arm solution.
     // the parameter args could be any letter each arm solution only accepts certain ones
-    BaseSolution::arm_options_t options = gcode.get_args();
+    BaseSolution::arm_options_t options(gcode.get_args().begin(), gcode.get_args().end());
     options.erase('S'); // don't include the S
     options.erase('U'); // don't include the U
     if(options.size() > 0) {
@@ -1612,6 +1617,7 @@ void Robot::reset_compensated_machine_position()
 {
     if(compensationTransform) {
         compensationTransform= nullptr;
+        compensation_grid.x_lines= compensation_grid.y_lines= 0;
         // we want to leave it where we have set Z, not where it ended up AFTER compensation so
         // this should correct the Z position to the machine_position
         is_g123= false; // we don't want the laser to fire
@@ -1627,9 +1633,7 @@ void Robot::reset_compensated_machine_position()
 // all transforms and is what we actually convert to actuator positions
 bool Robot::append_milestone(const float target[], float rate_mm_s)
 {
-    float deltas[n_motors];
     float transformed_target[n_motors]; // adjust target for bed compensation
-    float unit_vec[N_PRIMARY_AXIS];
 
     // unity transform by default
     memcpy(transformed_target, target, n_motors * sizeof(float));
@@ -1640,6 +1644,28 @@ bool Robot::append_milestone(const float target[], float rate_mm_s)
         compensationTransform(transformed_target, false);
     }
 
+    // find actuator position given the machine position, use actual adjusted target
+    ActuatorCoordinates actuator_pos;
+    if(!disable_arm_solution) {
+        arm_solution->cartesian_to_actuator( transformed_target, actuator_pos );
+
+    } else {
+        // basically the same as cartesian, would be used for special homing situations like for scara
+        for (size_t i = X_AXIS; i <= Z_AXIS; i++) {
+            actuator_pos[i] = transformed_target[i];
+        }
+    }
+
+    return append_transformed_milestone(transformed_target, actuator_pos, rate_mm_s);
+}
+
+// the rest of append_milestone() once the target has been compensated and the XYZ actuator positions found,
+// the XYZ of actuator_pos must be set, the rest are set here
+bool Robot::append_transformed_milestone(const float transformed_target[], ActuatorCoordinates &actuator_pos, float rate_mm_s)
+{
+    float deltas[n_motors];
+    float unit_vec[N_PRIMARY_AXIS];
+
     bool move = false;
     float sos = 0; // sum of squares for just primary axis (XYZ usually)
 
@@ -1694,18 +1720,6 @@ bool Robot::append_milestone(const float target[], float rate_mm_s)
 
     }
 
-    // find actuator position given the machine position, use actual adjusted target
-    ActuatorCoordinates actuator_pos;
-    if(!disable_arm_solution) {
-        arm_solution->cartesian_to_actuator( transformed_target, actuator_pos );
-
-    } else {
-        // basically the same as cartesian, would be used for special homing situations like for scara
-        for (size_t i = X_AXIS; i <= Z_AXIS; i++) {
-            actuator_pos[i] = transformed_target[i];
-        }
-    }
-
 #if MAX_ROBOT_ACTUATORS > 3
     sos = 0;
     // for the extruders just copy the position, and possibly scale it from mm³ to mm
@@ -1810,6 +1824,35 @@ bool Robot::delta_move(const float *delta, float rate_mm_s, uint8_t naxis)
     return false;
 }
 
+// walks the lines of one axis of the compensation grid crossed by a move in the order they are crossed
+// the lines are at start + i * step for i= 0 to n-1, the edges count as the compensation is clamped outside the grid
+struct grid_walk_t {
+    void init(float p0, float p1, float start, float step, int n)
+    {
+        g0 = (p0 - start) / step;
+        float g1 = (p1 - start) / step;
+        dg = g1 - g0;
+        if(dg > 0) {
+            dir = 1;
+            line = std::max(0, (int)floorf(g0) + 1);
+            last = std::min(n - 1, (int)ceilf(g1) - 1);
+        } else if(dg < 0) {
+            dir = -1;
+            line = std::min(n - 1, (int)ceilf(g0) - 1);
+            last = std::max(0, (int)floorf(g1) + 1);
+        } else {
+            dir = 0;
+        }
+    }
+
+    // the fraction of the move where the next line is crossed, 1 if there are no more
+    float t() const { return (dir == 0 || (line - last) * dir > 0) ? 1.0F : (line - g0) / dg; }
+    void next() { line += dir; }
+
+    float g0{0}, dg{0};
+    int line{0}, last{0}, dir{0};
+};
+
 // Append a move to the queue ( cutting it into segments if needed )
 bool Robot::append_line(GCode& gcode, const float target[], float rate_mm_s, float delta_e)
 {
@@ -1853,7 +1896,10 @@ bool Robot::append_line(GCode& gcode, const float target[], float rate_mm_s, flo
     // The latter is more efficient and avoids splitting fast long lines into very small segments, like initial z move to 0, it is what Johanns Marlin delta port does
     uint16_t segments;
 
-    if(this->disable_segmentation || (!segment_z_moves && !gcode.has_arg('X') && !gcode.has_arg('Y'))) {
+    // the pixels of a raster line are spread over one block, so a G1 with a raster line is never cut up
+    bool raster = gcode.has_g() && gcode.get_code() == 1 && RasterBuffer::getInstance() != nullptr && RasterBuffer::getInstance()->pending() > 0;
+
+    if(raster || this->disable_segmentation || (!segment_z_moves && !gcode.has_arg('X') && !gcode.has_arg('Y'))) {
         segments = 1;
 
     } else if(this->delta_segments_per_second > 1.0F) {
@@ -1872,8 +1918,19 @@ bool Robot::append_line(GCode& gcode, const float target[], float rate_mm_s, flo
         }
     }
 
+    // when not segmenting and there is a grid compensation the line is split where it crosses the grid lines instead,
+    // the compensation is then interpolated across each cell rather than just between the ends of the move
+    grid_walk_t grid_x, grid_y;
+    bool split_at_grid = false;
+    if(segments == 1 && !raster && !this->disable_segmentation && this->delta_segments_per_second <= 1.0F && this->mm_per_line_segment < 0.0001F &&
+       compensationTransform && compensation_grid.x_lines > 1 && compensation_grid.y_lines > 1) {
+        grid_x.init(machine_position[X_AXIS], target[X_AXIS], compensation_grid.x_start, compensation_grid.x_step, compensation_grid.x_lines);
+        grid_y.init(machine_position[Y_AXIS], target[Y_AXIS], compensation_grid.y_start, compensation_grid.y_step, compensation_grid.y_lines);
+        split_at_grid = std::min(grid_x.t(), grid_y.t()) < 1.0F;
+    }
+
     bool moved = false;
-    if (segments > 1) {
+    if (segments > 1 || split_at_grid) {
         // A vector to keep track of the endpoint of each segment
         float segment_delta[n_motors];
         float segment_end[n_motors];
@@ -1883,17 +1940,75 @@ bool Robot::append_line(GCode& gcode, const float target[], float rate_mm_s, flo
         for (int i = 0; i < n_motors; i++)
             segment_delta[i] = (target[i] - machine_position[i]) / segments;
 
+        // sets segment_end to the end of the next segment, returns false when the next one is the end of the move
         // segment 0 is already done - it's the end point of the previous move so we start at segment 1
-        // We always add another point after this loop so we stop at segments-1, ie i < segments
-        for (int i = 1; i < segments; i++) {
-            if(halted) return false; // don't queue any more segments
+        // We always add another point after this so we stop at segments-1
+        int segment = 1;
+        float last_t = 0;
+        auto next_segment_end = [&]() {
+            if(split_at_grid) {
+                float t;
+                do {
+                    float tx = grid_x.t(), ty = grid_y.t();
+                    t = std::min(tx, ty);
+                    if(t >= 1.0F) return false;
+                    if(tx == t) grid_x.next();
+                    if(ty == t) grid_y.next();
+                    // a crossing at a grid point, or one next to the last, does not need its own segment
+                } while((t - last_t) * millimeters_of_travel < 0.001F);
+
+                last_t = t;
+                for (int j = 0; j < n_motors; j++)
+                    segment_end[j] = machine_position[j] + (target[j] - machine_position[j]) * t;
+                return (1.0F - t) * millimeters_of_travel >= 0.001F;
+            }
+
+            if(segment >= segments) return false;
+            ++segment;
             for (int j = 0; j < n_motors; j++)
                 segment_end[j] += segment_delta[j];
+            return true;
+        };
+
+        // the segment ends are compensated then handed to the arm solution a batch at a time, so the
+        // inverse kinematics for the whole batch is done in one call
+        const int batch_size = 16;
+        float transformed[batch_size][k_max_actuators];
+        float xyz[3][batch_size];
+        float abc[3][batch_size];
+        const float *const cartesian[3] = {xyz[0], xyz[1], xyz[2]};
+        float *const actuator[3] = {abc[0], abc[1], abc[2]};
+
+        bool more = true;
+        while(more) {
+            int n = 0;
+            while(n < batch_size && (more = next_segment_end())) {
+                memcpy(transformed[n], segment_end, n_motors * sizeof(float));
+                if(compensationTransform) compensationTransform(transformed[n], false);
+                for (int j = X_AXIS; j <= Z_AXIS; j++)
+                    xyz[j][n] = transformed[n][j];
+                ++n;
+            }
+            if(n == 0) break;
 
-            // Append the end of this segment to the queue
-            // this can block waiting for free block queue or if in feed hold
-            bool b = this->append_milestone(segment_end, rate_mm_s);
-            moved = moved || b;
+            if(!disable_arm_solution) {
+                arm_solution->cartesian_to_actuator_n(n, cartesian, actuator);
+            } else {
+                memcpy(abc, xyz, sizeof(xyz));
+            }
+
+            for (int k = 0; k < n; k++) {
+                if(halted) return false; // don't queue any more segments
+
+                ActuatorCoordinates actuator_pos;
+                for (int j = ALPHA_STEPPER; j <= GAMMA_STEPPER; j++)
+                    actuator_pos[j] = abc[j][k];
+
+                // Append the end of this segment to the queue
+                // this can block waiting for free block queue or if in feed hold
+                bool b = this->append_transformed_milestone(transformed[k], actuator_pos, rate_mm_s);
+                moved = moved || b;
+            }
         }
     }
 
@@ -74,6 +74,9 @@ public:
 
     // set by a leveling strategy to transform the target of a move according to the current plan
     std::function<void(float*, bool)> compensationTransform;
+    // set by a grid leveling strategy along with compensationTransform, when mm_per_line_segment is 0 lines are split where they cross the grid
+    struct compensation_grid_t { float x_start, y_start, x_step, y_step; uint8_t x_lines, y_lines; };
+    compensation_grid_t compensation_grid{0, 0, 0, 0, 0, 0};
     // set by an active extruder, returns the amount to scale the E parameter by (to convert mm³ to mm)
     std::function<float(void)> get_e_scale_fnc;
 
@@ -114,6 +117,7 @@ private:
     bool handle_gcodes(GCode& gcode, OutputStream& os);
     bool handle_mcodes(GCode& gcode, OutputStream& os);
     bool handle_motion_command(GCode& gcode, OutputStream& os);
+    static bool motion_command(GCode& gcode, OutputStream& os) { return instance->handle_motion_command(gcode, os); }
     bool handle_dwell(GCode& gcode, OutputStream& os);
     bool handle_G10(GCode&, OutputStream&);
     bool handle_G92(GCode&, OutputStream&);
@@ -126,6 +130,7 @@ private:
     #endif
 
     bool append_milestone(const float target[], float rate_mm_s);
+    bool append_transformed_milestone(const float transformed_target[], ActuatorCoordinates &actuator_pos, float rate_mm_s);
     bool append_line(GCode& gcode, const float target[], float rate_mm_s, float delta_e);
     bool append_arc(GCode& gcode, const float target[], const float offset[], float radius, bool is_clockwise );
     bool compute_arc(GCode& gcode, const float offset[], const float target[], enum MOTION_MODE_T motion_mode);
@@ -0,0 +1,177 @@
+#include "StepSchedule.h"
+#include "Block.h"
+#include "StepTicker.h"
+
+#include <math.h>
+#include <limits.h>
+
+// Works out the velocity profile the DDA in StepTicker::step_tick() would follow for motor m
+// so the schedule issues the steps on the same ticks (within STEP_SCHEDULE_TOLERANCE)
+StepSchedule::StepSchedule(const Block *block, int m)
+{
+    const Block::tickinfo_t& ti= block->tick_info[m];
+    const float fps= (float)STEPTICKER_FPSCALE;
+    uint32_t au= block->accelerate_until;
+    uint32_t da= block->decelerate_after;
+    uint32_t total= block->total_move_ticks;
+
+    steps= ti.steps_to_move;
+    v0= ti.steps_per_tick / fps;
+    d= -ti.deceleration_change / fps;
+    a= 0;
+
+    if(au != 0) {
+        a= ti.acceleration_change / fps;
+        if(da < total && au != da) {
+            k1= au; vc= ti.plateau_rate / fps; k2= da;
+        } else {
+            // the last tick of the acceleration is at the rate it got to, there is no plateau
+            k1= au + 1; vc= v0 + a * k1; k2= (da < total) ? au : INFINITY;
+        }
+
+    } else {
+        k1= 0; vc= v0;
+        if(da == 0) {
+            k2= -1; // decelerating from the start
+        } else {
+            k2= (da != total) ? da : INFINITY;
+        }
+    }
+
+    x1= (v0 + a / 2) * k1 + a * k1 * k1 / 2;
+    x2= isinf(k2) ? INFINITY : x1 + vc * (k2 + 1 - k1);
+
+    if(vc <= 0) {
+        kz= k1; xz= x1;
+    } else if(d <= 0 || isinf(k2)) {
+        kz= INFINITY; xz= INFINITY;
+    } else {
+        kz= k2 + ceilf(vc / d);
+        float j= kz - (k2 + 1);
+        xz= x2 + (vc - d / 2) * j - d * j * j / 2;
+    }
+}
+
+// the time in ticks from the start of the block that the position reaches step n (1 based)
+float StepSchedule::step_time(uint32_t n) const
+{
+    float x= n;
+    if(x > xz) {
+        // the DDA forces one step per tick once the rate gets to zero
+        return kz + (x - floorf(xz));
+    }
+
+    if(x <= x1) {
+        float b= v0 + a / 2;
+        return 2 * x / (b + sqrtf(b * b + 2 * a * x));
+    }
+
+    if(x <= x2) {
+        return k1 + (x - x1) / vc;
+    }
+
+    float r= x - x2;
+    float b= vc - d / 2;
+    float disc= b * b - 2 * d * r;
+    if(disc < 0) disc= 0;
+    return k2 + 1 + 2 * r / (b + sqrtf(disc));
+}
+
+// sees if count steps starting at step n can be one run starting from last, returns the
+// run and the time of the last step it issues. The times are worked out in float ticks
+// relative to last so they keep their precision, only the run itself is fixed point
+bool StepSchedule::fit(uint32_t n, uint32_t count, int64_t last, run_t& run, int64_t& end) const
+{
+    const float one= STEP_SCHEDULE_ONE;
+    const float lastf= (float)last / one;
+
+    // a step is issued on the tick during which the position reaches it, so one tick before the time it is reached
+    float first= step_time(n) - 1 - lastf;
+    int64_t interval= llroundf(first * one);
+    if(interval < 0) interval= 0;
+    if(interval > UINT32_MAX) return false;
+
+    int64_t add= 0;
+    if(count > 1) {
+        // make the last step of the run land on its ideal time
+        float final= step_time(n + count - 1) - 1 - lastf;
+        float a= 2 * (final * one - (float)count * interval) / ((float)count * (count - 1));
+        if(a < INT32_MIN || a > INT32_MAX) return false;
+        add= lroundf(a);
+    }
+
+    int64_t t= 0;
+    int64_t iv= interval;
+    for (uint32_t i = 0; i < count; ++i) {
+        if(iv < 0 || iv > UINT32_MAX) return false;
+        t += iv;
+        float e= (float)t / one - (step_time(n + i) - 1 - lastf);
+        if(fabsf(e) > STEP_SCHEDULE_TOLERANCE) return false;
+        iv += add;
+    }
+
+    run.interval= interval;
+    run.add= add;
+    run.count= count;
+    end= last + t;
+    return true;
+}
+
+// greedy compression, each run is extended for as long as all of its steps stay within the tolerance
+// returns the number of runs used or -1 if they do not fit
+int StepSchedule::compress(run_t *runs, int max_runs) const
+{
+    int64_t last= -STEP_SCHEDULE_ONE;
+    int nruns= 0;
+    uint32_t n= 1;
+
+    while(n <= steps) {
+        if(nruns >= max_runs) return -1;
+
+        run_t run, r;
+        int64_t end, e;
+        if(!fit(n, 1, last, run, end)) return -1;
+
+        uint32_t left= steps - n + 1;
+        uint32_t good= 1, bad= 2;
+        while(bad <= left && fit(n, bad, last, r, e)) {
+            good= bad; run= r; end= e;
+            bad *= 2;
+        }
+        if(bad > left) bad= left + 1;
+
+        while(bad - good > 1) {
+            uint32_t mid= good + (bad - good) / 2;
+            if(fit(n, mid, last, r, e)) {
+                good= mid; run= r; end= e;
+            } else {
+                bad= mid;
+            }
+        }
+
+        runs[nruns++]= run;
+        last= end;
+        n += good;
+    }
+
+    return nruns;
+}
+
+bool StepSchedule::build(Block *block, uint16_t size)
+{
+    // the schedule only models constant acceleration, s-curve blocks use the DDA
+    if(block->schedule == nullptr || block->s_curve || block->total_move_ticks > STEP_SCHEDULE_MAX_TICKS) return false;
+
+    int used= 0;
+    for (uint8_t m = 0; m < Block::n_actuators; ++m) {
+        block->schedule_index[m]= used;
+        if(block->tick_info[m].steps_to_move == 0) continue;
+
+        StepSchedule s(block, m);
+        int n= s.compress(&block->schedule[used], size - used);
+        if(n < 0) return false;
+        used += n;
+    }
+
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+class Block;
+
+// Precomputed step schedule for a block.
+// When enabled (planner.step_schedule_size > 0) Planner::build_schedules() works out the tick
+// each step of each motor is due on and compresses them into runs of steps whose
+// interval changes linearly, the StepTicker then only has to do any work on the ticks
+// that actually issue a step, instead of running the DDA for every motor on every tick.
+// If a block does not fit in the runs available it is stepped by the DDA as before.
+// It is built once on the command thread when the plan of the block is final (or it is next
+// to be fetched), all in single precision as the M4F only does floats in hardware.
+
+// fixed point used for the step times and intervals
+#define STEP_SCHEDULE_FRAC_BITS 16
+#define STEP_SCHEDULE_ONE (1L<<STEP_SCHEDULE_FRAC_BITS)
+
+// maximum allowed difference in ticks between the scheduled and ideal time of a step
+#define STEP_SCHEDULE_TOLERANCE 0.25F
+
+// the step times are floats in ticks from the start of the block, in longer blocks they would be
+// less precise than 1/32 tick so they are stepped by the DDA
+#define STEP_SCHEDULE_MAX_TICKS (1UL<<18)
+
+class StepSchedule
+{
+public:
+    // count steps, the first is interval ticks after the previous step,
+    // then interval changes by add after each step (16.16 fixed point ticks)
+    using run_t= struct {
+        uint32_t interval;
+        int32_t add;
+        uint32_t count;
+    };
+
+    // compresses the steps of all the active motors in the block into block->schedule
+    // returns false if it did not fit or could not be represented
+    static bool build(Block *block, uint16_t size);
+
+private:
+    StepSchedule(const Block *block, int m);
+    float step_time(uint32_t n) const;
+    int compress(run_t *runs, int max_runs) const;
+    bool fit(uint32_t n, uint32_t count, int64_t last, run_t& run, int64_t& end) const;
+
+    // velocity in steps/tick is v0 + a*(k+1) for ticks k < k1, vc up to and including tick k2,
+    // then vc - d*(k-k2), once it gets to zero the remaining steps are issued one per tick
+    float v0, a, vc, d;
+    float k1, k2;
+    float x1, x2, xz; // positions at the end of the acceleration and the plateau, and when the velocity gets to zero
+    float kz;
+    uint32_t steps;
+};
@@ -4,6 +4,7 @@
 #include "StepperMotor.h"
 #include "Block.h"
 #include "Conveyor.h"
+#include "RasterBuffer.h"
 #include "Module.h"
 #include "tmr-setup.h"
 
@@ -21,6 +22,14 @@ Pin stepticker_debug_pin(STEPTICKER_DEBUG_PIN, Pin::AS_OUTPUT);
 #define SET_STEPTICKER_DEBUG_PIN(n)
 #endif
 
+#ifdef STEPTICKER_TRACE
+// records all steps issued for offline verification, only compiled in with rake steptrace=1
+#include "StepTrace.h"
+#define STEPTRACE(f) { StepTrace *st= StepTrace::getInstance(); if(st != nullptr) st->f; }
+#else
+#define STEPTRACE(f)
+#endif
+
 // TODO move ramfunc define to a utils.h
 #define _ramfunc_ __attribute__ ((section(".ramfunctions"),long_call,noinline))
 
@@ -121,12 +130,17 @@ _ramfunc_  bool StepTicker::start_unstep_ticker()
 // Reset step pins on any motor that was stepped
 _ramfunc_  void StepTicker::unstep_tick()
 {
-    uint32_t bitmsk= 1;
-    for (int i = 0; i < num_motors; i++) {
-        if(this->unstep & bitmsk) {
-            this->motor[i]->unstep();
+    if(batch_steps) {
+        step_pins.unstep(this->unstep);
+
+    } else {
+        uint32_t bitmsk= 1;
+        for (int i = 0; i < num_motors; i++) {
+            if(this->unstep & bitmsk) {
+                this->motor[i]->unstep();
+            }
+            bitmsk <<= 1;
         }
-        bitmsk <<= 1;
     }
     this->unstep= 0;
 }
@@ -147,6 +161,7 @@ _ramfunc_  void StepTicker::unstep_tick()
 _ramfunc_  void StepTicker::step_tick (void)
 {
     //SET_STEPTICKER_DEBUG_PIN(running ? 1 : 0);
+    STEPTRACE(tick());
 
     if(unstep != 0) {
         // this is a failsafe, if we get here it means we missed the unstep from a previous tick
@@ -171,14 +186,49 @@ _ramfunc_  void StepTicker::step_tick (void)
         current_tick = 0;
         current_block = nullptr;
         continuing= false;
+        scheduled= false;
+        return;
+    }
+
+    // first tick of a new block
+    if(current_tick == 0) STEPTRACE(record_block(current_block, num_motors));
+
+    if(scheduled) {
+        schedule_tick();
         return;
     }
 
+    // s-curve blocks change the acceleration by the jerk, which changes at the jerk events
+    bool s_curve = current_block->s_curve;
+    bool jerk_event = false;
+    int8_t jerk_code = 0;
+    if(s_curve && current_tick == current_block->jerk_tick[jerk_index]) {
+        jerk_event = true;
+        jerk_code = current_block->jerk_code[jerk_index++];
+    }
+
     bool still_moving = false;
     // foreach motor, if it is active see if time to issue a step to that motor
     for (uint8_t m = 0; m < num_motors; m++) {
         if(current_block->tick_info[m].steps_to_move == 0) continue; // not active
 
+        if(s_curve) {
+            if(jerk_event) {
+                switch(jerk_code) {
+                    case 1: current_block->tick_info[m].jerk_change = current_block->tick_info[m].accel_jerk; break;
+                    case -1: current_block->tick_info[m].jerk_change = -current_block->tick_info[m].accel_jerk; break;
+                    case 2: current_block->tick_info[m].jerk_change = current_block->tick_info[m].decel_jerk; break;
+                    case -2: current_block->tick_info[m].jerk_change = -current_block->tick_info[m].decel_jerk; break;
+                    case 3:
+                        current_block->tick_info[m].jerk_change = 0;
+                        current_block->tick_info[m].acceleration_change = current_block->tick_info[m].deceleration_change;
+                        break;
+                    default: current_block->tick_info[m].jerk_change = 0;
+                }
+            }
+            current_block->tick_info[m].acceleration_change += current_block->tick_info[m].jerk_change;
+        }
+
         current_block->tick_info[m].steps_per_tick += current_block->tick_info[m].acceleration_change;
 
         if(current_tick == current_block->tick_info[m].next_accel_event) {
@@ -198,7 +248,7 @@ _ramfunc_  void StepTicker::step_tick (void)
                 }
             }
 
-            if(current_tick == current_block->decelerate_after) { // We start decelerating
+            if(current_tick == current_block->decelerate_after && current_block->decelerate_ramp == 0) { // We start decelerating, s-curve deceleration is done by the jerk events
                 current_block->tick_info[m].acceleration_change = current_block->tick_info[m].deceleration_change;
             }
         }
@@ -223,7 +273,9 @@ _ramfunc_  void StepTicker::step_tick (void)
             }
 
             // step the motor
-            bool ismoving = motor[m]->step(); // returns false if the moving flag was set to false externally (probes, endstops etc)
+            // returns false if the moving flag was set to false externally (probes, endstops etc)
+            // when batched the step pins of all the motors are set together at the end of the tick
+            bool ismoving = batch_steps ? motor[m]->count_step() : motor[m]->step();
             // we stepped so schedule an unstep
             unstep |= (1<<m);
 
@@ -249,35 +301,164 @@ _ramfunc_  void StepTicker::step_tick (void)
     // right now it takes about 1-2us to get here which will add to the pulse width from when it was on
     // the pulse width will be 1us (or whatever it is set to) from this point on, so at least 2-3 us
     if(unstep != 0) {
+        if(batch_steps) step_pins.step(unstep);
         start_unstep_ticker();
+        STEPTRACE(record_steps(unstep, current_block->direction_bits.to_ulong()));
+        if(current_block->raster_size != 0 && (unstep & (1<<raster_motor))) raster_step();
     }
 
     // see if any motors are still moving
     if(!still_moving) {
         //SET_STEPTICKER_DEBUG_PIN(0);
+        finish_block();
+    }
+}
 
-        // all moves finished
-        current_tick = 0;
+// the primary motor of a raster block has stepped, moves on to the next pixel when its share of the steps is done
+_ramfunc_ void StepTicker::raster_step()
+{
+    uint16_t last = raster_pixel;
+    raster_acc += current_block->raster_size;
+    while(raster_acc >= current_block->steps_event_count) {
+        raster_acc -= current_block->steps_event_count;
+        ++raster_pixel;
+    }
 
-        // get next block
-        // do it here so there is no delay in ticks
-        Conveyor::getInstance()->block_finished();
+    // the power is only set when it changes, after the last pixel it is left as it is until the block finishes
+    if(raster_pixel != last && raster_pixel < current_block->raster_size &&
+       current_block->raster[raster_pixel] != current_block->raster[last] && raster_fnc) {
+        raster_fnc(current_block->raster[raster_pixel]);
+    }
+}
 
-        if(Conveyor::getInstance()->get_next_block(&current_block)) { // returns false if no new block is available
-            running = start_next_block(); // returns true if there is at least one motor with steps to issue
+// all moves finished, get the next block
+// do it here so there is no delay in ticks
+_ramfunc_ void StepTicker::finish_block()
+{
+    current_tick = 0;
 
-        } else {
-            current_block = nullptr;
-            running = false;
+    if(current_block->raster_size != 0) {
+        if(raster_fnc) raster_fnc(0);
+        RasterBuffer::getInstance()->release(current_block->raster + current_block->raster_size);
+    }
+
+    Conveyor::getInstance()->block_finished();
+
+    if(Conveyor::getInstance()->get_next_block(&current_block)) { // returns false if no new block is available
+        running = start_next_block(); // returns true if there is at least one motor with steps to issue
+
+    } else {
+        current_block = nullptr;
+        running = false;
+    }
+
+    // all moves finished
+    // we delegate the slow stuff to the pendsv handler which will run as soon as this interrupt exits
+    //NVIC_SetPendingIRQ(PendSV_IRQn); this doesn't work
+    //SCB->ICSR = 0x10000000; // SCB_ICSR_PENDSVSET_Msk;
+}
+
+// step clock when the block has a step schedule, nothing needs to be done unless a step is due this tick
+_ramfunc_ void StepTicker::schedule_tick()
+{
+    if(current_tick != next_event) {
+        ++current_tick;
+        return;
+    }
+
+    bool still_moving = false;
+    uint32_t next = UINT32_MAX;
+    for (uint8_t m = 0; m < num_motors; m++) {
+        Block::tickinfo_t& ti= current_block->tick_info[m];
+        if(ti.steps_to_move == 0) continue; // not active
+
+        schedule_state_t& s= schedule[m];
+        if(s.next_tick == current_tick) {
+            // a motor stopped externally (probes, endstops etc) is not stepped again, it is retired at what would have been its next step
+            bool ismoving = motor[m]->is_moving();
+            if(ismoving) {
+                if(batch_steps) motor[m]->count_step(); else motor[m]->step();
+                unstep |= (1<<m);
+                ++ti.step_count;
+            }
+
+            if(!ismoving || ti.step_count == ti.steps_to_move) {
+                // done
+                ti.steps_to_move = 0;
+                motor[m]->stop_moving();
+                continue;
+            }
+
+            // work out when the next step is due
+            if(--s.count == 0) {
+                ++s.run;
+                s.interval= s.run->interval;
+                s.add= s.run->add;
+                s.count= s.run->count;
+            } else {
+                s.interval += s.add;
+            }
+            s.time += s.interval;
+            int64_t t= (s.time + STEP_SCHEDULE_ONE - 1) >> STEP_SCHEDULE_FRAC_BITS;
+            s.next_tick= (t > current_tick) ? t : current_tick + 1; // can only step once per tick
         }
 
-        // all moves finished
-        // we delegate the slow stuff to the pendsv handler which will run as soon as this interrupt exits
-        //NVIC_SetPendingIRQ(PendSV_IRQn); this doesn't work
-        //SCB->ICSR = 0x10000000; // SCB_ICSR_PENDSVSET_Msk;
+        still_moving = true;
+        if(s.next_tick < next) next= s.next_tick;
+    }
+
+    ++current_tick;
+
+    if(unstep != 0) {
+        if(batch_steps) step_pins.step(unstep);
+        start_unstep_ticker();
+        STEPTRACE(record_steps(unstep, current_block->direction_bits.to_ulong()));
+        if(current_block->raster_size != 0 && (unstep & (1<<raster_motor))) raster_step();
+    }
+
+    if(still_moving) {
+        next_event= next;
+    } else {
+        finish_block();
     }
 }
 
+// sets up the step schedule of a new block, the DDA is used for the block if it has no schedule
+_ramfunc_ bool StepTicker::start_schedule()
+{
+    // the schedule can not hold the plateau
+    if(Conveyor::getInstance()->get_continuous_mode()) {
+        current_block->use_schedule = false;
+        return false;
+    }
+
+    next_event = UINT32_MAX;
+    for (uint8_t m = 0; m < num_motors; m++) {
+        if(current_block->tick_info[m].steps_to_move == 0) continue;
+
+        schedule_state_t& s= schedule[m];
+        s.run= &current_block->schedule[current_block->schedule_index[m]];
+        s.interval= s.run->interval;
+        s.add= s.run->add;
+        s.count= s.run->count;
+        // the step times are relative to the tick before the block starts
+        s.time= s.interval - STEP_SCHEDULE_ONE;
+        int64_t t= (s.time + STEP_SCHEDULE_ONE - 1) >> STEP_SCHEDULE_FRAC_BITS;
+        s.next_tick= (t > 0) ? t : 0;
+        if(s.next_tick < next_event) next_event= s.next_tick;
+    }
+
+    return true;
+}
+
+// returns the current rate of the motor in steps/sec when stepping from the schedule
+float StepTicker::get_schedule_rate(int m) const
+{
+    uint32_t interval= schedule[m].interval;
+    if(interval < STEP_SCHEDULE_ONE) return frequency;
+    return (float)frequency * STEP_SCHEDULE_ONE / interval;
+}
+
 // only called from the step tick ISR (single consumer)
 _ramfunc_ bool StepTicker::start_next_block()
 {
@@ -297,9 +478,24 @@ _ramfunc_ bool StepTicker::start_next_block()
     }
 
     current_tick = 0;
+    jerk_index = 0;
+
+    if(ok && current_block->raster_size != 0) {
+        // the raster line is advanced by the motor with the most steps
+        for (uint8_t m = 0; m < num_motors; m++) {
+            if(current_block->steps[m] == current_block->steps_event_count) {
+                raster_motor = m;
+                break;
+            }
+        }
+        raster_acc = 0;
+        raster_pixel = 0;
+        if(raster_fnc) raster_fnc(current_block->raster[0]);
+    }
 
     if(ok) {
         //SET_STEPTICKER_DEBUG_PIN(1);
+        scheduled = current_block->use_schedule && start_schedule();
         return true;
 
     } else {
@@ -315,6 +511,8 @@ _ramfunc_ bool StepTicker::start_next_block()
 // returns index of the stepper motor in the array and bitset
 int StepTicker::register_actuator(StepperMotor* m)
 {
+    // if any step pin can not be batched (open drain etc) they are all set by the motors
+    if(!step_pins.add(num_motors, m->get_step_pin())) batch_steps= false;
     motor[num_motors++] = m;
     return num_motors - 1;
 }
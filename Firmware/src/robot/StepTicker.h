@@ -6,6 +6,8 @@
 #include <functional>
 
 #include "ActuatorCoordinates.h"
+#include "StepSchedule.h"
+#include "StepPins.h"
 
 class StepperMotor;
 class Block;
@@ -31,12 +33,16 @@ public:
     int register_actuator(StepperMotor* motor);
     float get_frequency() const { return frequency; }
     const Block *get_current_block() const { return current_block; }
+    float get_schedule_rate(int m) const;
 
     bool start();
     bool stop();
 
     // whatever setup the block should register this to know when it is done
     std::function<void()> finished_fnc{nullptr};
+    // called with the PWM duty of each pixel of a raster line as the primary motor gets to it, and 0 at the end of the line.
+    // called from the ISR so it must be a _ramfunc_ that only uses integer math, the duty was worked out when the line was queued
+    void (*raster_fnc)(uint16_t duty){nullptr};
 
     static StepTicker *getInstance() { return instance; }
 
@@ -45,9 +51,13 @@ private:
     void handle_finish (void);
     void unstep_tick();
     void step_tick (void);
+    void schedule_tick (void);
+    void finish_block (void);
+    bool start_schedule();
     bool start_unstep_ticker();
     int initial_setup(const char *dev, void *timer_handler, uint32_t per);
     bool start_next_block();
+    void raster_step();
 
     static void step_timer_handler(void);
     static void unstep_timer_handler(void);
@@ -55,10 +65,23 @@ private:
     std::array<StepperMotor*, k_max_actuators> motor;
 
     uint32_t unstep{0}; // one bit set per motor to indicayte step pin needs to be unstepped
+    StepPins step_pins; // sets the step pins of all the motors with one write per port
     uint32_t missed_unsteps{0};
 
     Block *current_block{nullptr};
 
+    // state of each motor when stepping from the block's step schedule
+    using schedule_state_t= struct {
+        int64_t time; // 48.16 fixed point tick the next step is due, relative to the start of the block
+        uint32_t next_tick; // tick the next step is issued on
+        uint32_t interval;
+        int32_t add;
+        uint32_t count; // steps left in the current run
+        const StepSchedule::run_t *run;
+    };
+    std::array<schedule_state_t, k_max_actuators> schedule;
+    uint32_t next_event{0}; // next tick that any motor has a step due
+
     uint32_t frequency{100000}; // 100KHz
     uint32_t delay{1}; //microseconds
 
@@ -69,4 +92,12 @@ private:
     volatile bool running{false};
     bool started{false};
     bool continuing{false};
+    bool scheduled{false}; // set if the current block is stepped from its step schedule
+    bool batch_steps{true}; // cleared if any step pin can not be set by step_pins
+    uint8_t jerk_index{0}; // next jerk event of an s-curve block
+
+    // position in the raster line of the current block, pixel i is used from step i*steps_event_count/raster_size of the primary motor
+    uint32_t raster_acc{0};
+    uint16_t raster_pixel{0};
+    uint8_t raster_motor{0};
 };
@@ -0,0 +1,184 @@
+#ifdef STEPTICKER_TRACE
+
+#include "StepTrace.h"
+#include "Block.h"
+#include "StepTicker.h"
+#include "Dispatcher.h"
+#include "OutputStream.h"
+#include "StringUtils.h"
+#include "main.h"
+
+#include <string.h>
+
+// TODO move ramfunc define to a utils.h
+#define _ramfunc_ __attribute__ ((section(".ramfunctions"),long_call,noinline))
+
+#define HELP(m) if(params == "-h") { os.printf("%s\n", m); return true; }
+
+StepTrace *StepTrace::instance= nullptr;
+
+StepTrace::StepTrace()
+{
+    if(instance == nullptr) instance= this;
+}
+
+bool StepTrace::initialize()
+{
+    using std::placeholders::_1;
+    using std::placeholders::_2;
+    THEDISPATCHER->add_handler( "steptrace", std::bind( &StepTrace::handle_command, this, _1, _2) );
+    return ring.is_ok();
+}
+
+// if the ring is full the record is dropped and counted, the count is recorded
+// as soon as there is room again so the verifier knows the trace has a gap
+_ramfunc_ bool StepTrace::push(const record_t& r)
+{
+    if(lost > 0) {
+        if(ring.full()) {
+            ++lost;
+            return false;
+        }
+        record_t o{current_tick, TR_OVERFLOW, 0, 0, lost, 0, 0};
+        ring.push_back(o);
+        lost= 0;
+    }
+
+    if(ring.full()) {
+        ++lost;
+        ++total_lost;
+        return false;
+    }
+
+    ring.push_back(r);
+    return true;
+}
+
+_ramfunc_ void StepTrace::record_steps(uint32_t stepped, uint32_t dirs)
+{
+    if(!recording) return;
+    record_t r{current_tick, TR_STEP, 0, (uint16_t)stepped, dirs, 0, 0};
+    push(r);
+}
+
+static inline uint32_t float_bits(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+// records the planned trapezoid, the current tick is the first tick of the block
+_ramfunc_ void StepTrace::record_block(const Block *block, uint8_t n_motors)
+{
+    if(!recording) return;
+    record_t r{current_tick, TR_BLOCK, 0, (uint16_t)block->direction_bits.to_ulong(), block->accelerate_until, block->decelerate_after, block->total_move_ticks};
+    push(r);
+
+    if(block->s_curve) {
+        record_t jr{current_tick, TR_JERK, 0, 0, block->accelerate_ramp, block->decelerate_ramp, 0};
+        push(jr);
+    }
+
+    for (uint8_t m = 0; m < n_motors; ++m) {
+        const Block::tickinfo_t& ti= block->tick_info[m];
+        if(ti.steps_to_move == 0) continue;
+        record_t mr{current_tick, TR_MOTOR, m, 0, ti.steps_to_move, float_bits(STEPTICKER_FROMFP(ti.steps_per_tick)), float_bits(STEPTICKER_FROMFP(ti.plateau_rate))};
+        push(mr);
+        record_t ar{current_tick, TR_ACCEL, m, 0, float_bits(STEPTICKER_FROMFP(ti.acceleration_change)), float_bits(STEPTICKER_FROMFP(ti.deceleration_change)),
+            block->s_curve ? float_bits(STEPTICKER_FROMFP(ti.accel_jerk)) : 0};
+        push(ar);
+    }
+}
+
+size_t StepTrace::drain()
+{
+    if(request == REQ_START) {
+        fp= fopen(filename.c_str(), "wb");
+        if(fp != nullptr) {
+            // nothing is pushed while not recording
+            ring.flush();
+            current_tick= 0;
+            lost= 0;
+            total_lost= 0;
+            written= 0;
+            recording= true;
+        }
+        request= REQ_NONE;
+    }
+
+    // once stopped nothing more is pushed so this drains the last of it
+    if(request == REQ_STOP) recording= false;
+
+    size_t n= 0;
+    while(!ring.empty()) {
+        record_t r= ring.pop_front();
+        if(fp != nullptr) {
+            fwrite(&r, sizeof(r), 1, fp);
+            ++n;
+        }
+    }
+    written += n;
+
+    if(request == REQ_STOP) {
+        if(fp != nullptr) fclose(fp);
+        fp= nullptr;
+        request= REQ_NONE;
+    }
+    return n;
+}
+
+// waits for the drain task to act on the request, gives up after a second if it is not running
+bool StepTrace::wait_for_request()
+{
+    for (int i = 0; i < 100 && request != REQ_NONE; ++i) {
+        safe_sleep(10);
+    }
+    if(request == REQ_NONE) return true;
+    request= REQ_NONE;
+    return false;
+}
+
+bool StepTrace::start_recording(const char *filename)
+{
+    if(recording || request != REQ_NONE) return false;
+
+    this->filename= filename;
+    request= REQ_START;
+    return wait_for_request() && recording;
+}
+
+void StepTrace::stop_recording()
+{
+    if(!recording || request != REQ_NONE) return;
+
+    request= REQ_STOP;
+    wait_for_request();
+}
+
+bool StepTrace::handle_command(std::string& params, OutputStream& os)
+{
+    HELP("steptrace start file | stop | status - record the steps issued by the stepticker");
+
+    std::string cmd= stringutils::shift_parameter(params);
+    if(cmd == "start") {
+        std::string fn= stringutils::shift_parameter(params);
+        if(fn.empty()) fn= "/sd/steptrace.bin";
+        if(!start_recording(fn.c_str())) {
+            os.printf("failed to start recording to %s\n", fn.c_str());
+        } else {
+            os.printf("recording steps to %s\n", fn.c_str());
+        }
+
+    } else if(cmd == "stop") {
+        stop_recording();
+        os.printf("recorded %lu records, %lu lost\n", written, total_lost);
+
+    } else {
+        os.printf("%s, %lu records written, %lu lost, %u queued\n", recording ? "recording" : "not recording", written, total_lost, ring.get_size());
+    }
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+// Records every step the StepTicker issues so missed steps and timing jitter can be
+// checked offline with tools/verify-steptrace.py.
+// Only compiled in when STEPTICKER_TRACE is defined (rake steptrace=1), the ISR pushes
+// fixed size records into a single producer/single consumer ring, and a low priority
+// task drains the ring to a file.
+
+#ifdef STEPTICKER_TRACE
+
+#include "RingBuffer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+#ifndef STEPTICKER_TRACE_SIZE
+#define STEPTICKER_TRACE_SIZE 1024
+#endif
+
+class Block;
+class OutputStream;
+
+class StepTrace
+{
+public:
+    // the record types, written to the file as is (little endian, 20 bytes)
+    enum RECORD_TYPE : uint8_t {
+        TR_STEP     = 'S', // bits: motors stepped, a: direction bits
+        TR_BLOCK    = 'B', // bits: direction bits, a: accelerate_until, b: decelerate_after, c: total_move_ticks
+        TR_MOTOR    = 'M', // motor: index, a: steps_to_move, b: initial rate, c: plateau rate (float steps/tick)
+        TR_ACCEL    = 'A', // motor: index, a: acceleration, b: deceleration (float steps/tick²), c: s-curve acceleration jerk (float steps/tick³)
+        TR_JERK     = 'J', // s-curve blocks, a: accelerate_ramp, b: decelerate_ramp (ticks)
+        TR_OVERFLOW = 'O', // a: number of records lost since the last record
+    };
+
+    struct __attribute__ ((packed)) record_t {
+        uint32_t tick;  // step ticks since the trace was started
+        uint8_t type;
+        uint8_t motor;
+        uint16_t bits;
+        uint32_t a, b, c;
+    };
+
+    StepTrace();
+    static StepTrace *getInstance() { return instance; }
+
+    bool initialize();
+
+    // called from the step ticker ISR
+    void tick() { ++current_tick; }
+    void record_steps(uint32_t stepped, uint32_t dirs);
+    void record_block(const Block *block, uint8_t n_motors);
+
+    // called from the drain task, returns the number of records written. The drain task is the only
+    // consumer of the ring and the only one to use the file, it opens and closes it when asked to
+    size_t drain();
+
+    // called from the command thread, they ask the drain task to open or close the file and wait for it
+    bool start_recording(const char *filename);
+    void stop_recording();
+    bool is_recording() const { return recording; }
+
+private:
+    static StepTrace *instance;
+
+    bool push(const record_t& r);
+    bool wait_for_request();
+    bool handle_command(std::string& params, OutputStream& os);
+
+    RingBuffer<record_t, STEPTICKER_TRACE_SIZE> ring;
+    FILE *fp{nullptr};
+    std::string filename;
+    enum REQUEST : uint8_t { REQ_NONE, REQ_START, REQ_STOP };
+    volatile REQUEST request{REQ_NONE};
+    uint32_t current_tick{0};
+    uint32_t lost{0};
+    uint32_t total_lost{0};
+    uint32_t written{0};
+    volatile bool recording{false};
+};
+
+#endif
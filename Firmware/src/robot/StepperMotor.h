@@ -17,7 +17,9 @@ class StepperMotor
         uint8_t get_motor_id() const { return motor_id; }
 
         // called from step ticker ISR
-        inline bool step() { step_pin.set(1); current_position_steps += (direction?-1:1); return moving; }
+        inline bool step() { step_pin.set(1); return count_step(); }
+        // called from step ticker ISR when the step pin is set by the StepTicker
+        inline bool count_step() { current_position_steps += (direction?-1:1); return moving; }
         // called from unstep ISR
         inline void unstep() { step_pin.set(0); }
         // called from step ticker ISR
@@ -26,6 +28,7 @@ class StepperMotor
         void enable(bool state);
         bool is_enabled() const;
         bool is_moving() const { return moving; };
+        const Pin& get_step_pin() const { return step_pin; }
         void start_moving() { moving= true; }
         void stop_moving() { moving= false; }
 
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <map>
+#include <stddef.h>
 #include "ActuatorCoordinates.h"
 
 class ConfigReader;
@@ -12,6 +13,21 @@ class BaseSolution {
         virtual ~BaseSolution() {};
         virtual void cartesian_to_actuator(const float[], ActuatorCoordinates &) const = 0;
         virtual void actuator_to_cartesian(const ActuatorCoordinates &, float[]) const = 0;
+
+        // transforms n points at once, the XYZ of point i is cartesian[X_AXIS][i], cartesian[Y_AXIS][i] and cartesian[Z_AXIS][i],
+        // its alpha, beta and gamma actuator positions are written to actuator[ALPHA_STEPPER][i] etc.
+        // The default calls cartesian_to_actuator() for each point.
+        virtual void cartesian_to_actuator_n(size_t n, const float *const cartesian[3], float *const actuator[3]) const
+        {
+            for (size_t i = 0; i < n; ++i) {
+                float mm[3]= {cartesian[0][i], cartesian[1][i], cartesian[2][i]};
+                ActuatorCoordinates a;
+                cartesian_to_actuator(mm, a);
+                actuator[0][i]= a[0];
+                actuator[1][i]= a[1];
+                actuator[2][i]= a[2];
+            }
+        }
         typedef std::map<char, float> arm_options_t;
         virtual bool set_optional(const arm_options_t& options) { return false; };
         virtual bool get_optional(arm_options_t& options, bool force_all= false) const { return false; };
@@ -74,6 +74,29 @@ void LinearDeltaSolution::cartesian_to_actuator(const float cartesian_mm[], Actu
                                       ) + cartesian_mm[Z_AXIS];
 }
 
+// the three towers are independent, so each iteration has three square roots that do not depend on each other
+// which keeps the FPU pipeline full, and with no branches or calls in the loop the host compiler can vectorise it
+void LinearDeltaSolution::cartesian_to_actuator_n(size_t n, const float *const cartesian[3], float *const actuator[3]) const
+{
+    const float * __restrict__ x= cartesian[X_AXIS];
+    const float * __restrict__ y= cartesian[Y_AXIS];
+    const float * __restrict__ z= cartesian[Z_AXIS];
+    float * __restrict__ alpha= actuator[ALPHA_STEPPER];
+    float * __restrict__ beta= actuator[BETA_STEPPER];
+    float * __restrict__ gamma= actuator[GAMMA_STEPPER];
+
+    const float l2= arm_length_squared;
+    const float t1x= delta_tower1_x, t1y= delta_tower1_y;
+    const float t2x= delta_tower2_x, t2y= delta_tower2_y;
+    const float t3x= delta_tower3_x, t3y= delta_tower3_y;
+
+    for (size_t i = 0; i < n; ++i) {
+        alpha[i]= sqrtf(l2 - SQ(t1x - x[i]) - SQ(t1y - y[i])) + z[i];
+        beta[i] = sqrtf(l2 - SQ(t2x - x[i]) - SQ(t2y - y[i])) + z[i];
+        gamma[i]= sqrtf(l2 - SQ(t3x - x[i]) - SQ(t3y - y[i])) + z[i];
+    }
+}
+
 void LinearDeltaSolution::actuator_to_cartesian(const ActuatorCoordinates &actuator_mm, float cartesian_mm[] ) const
 {
     // from http://en.wikipedia.org/wiki/Circumscribed_circle#Barycentric_coordinates_from_cross-_and_dot-products
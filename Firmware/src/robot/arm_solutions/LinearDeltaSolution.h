@@ -5,6 +5,7 @@ class LinearDeltaSolution : public BaseSolution {
     public:
         LinearDeltaSolution(ConfigReader&);
         void cartesian_to_actuator(const float[], ActuatorCoordinates &) const override;
+        void cartesian_to_actuator_n(size_t n, const float *const cartesian[3], float *const actuator[3]) const override;
         void actuator_to_cartesian(const ActuatorCoordinates &, float[] ) const override;
 
         bool set_optional(const arm_options_t& options) override;
@@ -54,7 +54,8 @@ float MorganSCARASolution::to_degrees(float radians) const
     return radians * (180.0F / 3.14159265359f);
 }
 
-void MorganSCARASolution::cartesian_to_actuator(const float cartesian_mm[], ActuatorCoordinates &actuator_mm ) const
+// the support arm and dual arm angles in degrees for the cartesian x, y
+void MorganSCARASolution::calc_angles(float x, float y, float &alpha, float &beta) const
 {
 
     float SCARA_pos[2],
@@ -65,8 +66,8 @@ void MorganSCARASolution::cartesian_to_actuator(const float cartesian_mm[], Actu
           SCARA_theta,
           SCARA_psi;
 
-    SCARA_pos[X_AXIS] = (cartesian_mm[X_AXIS] - this->morgan_offset_x)  * this->morgan_scaling_x;  //Translate cartesian to tower centric SCARA X Y AND apply scaling factor from this offset.
-    SCARA_pos[Y_AXIS] = (cartesian_mm[Y_AXIS]  * this->morgan_scaling_y - this->morgan_offset_y);  // morgan_offset not to be confused with home offset. This makes the SCARA math work.
+    SCARA_pos[X_AXIS] = (x - this->morgan_offset_x)  * this->morgan_scaling_x;  //Translate cartesian to tower centric SCARA X Y AND apply scaling factor from this offset.
+    SCARA_pos[Y_AXIS] = (y  * this->morgan_scaling_y - this->morgan_offset_y);  // morgan_offset not to be confused with home offset. This makes the SCARA math work.
     // Y has to be scaled before subtracting offset to ensure position on bed.
 
     if (this->arm1_length == this->arm2_length)
@@ -92,11 +93,24 @@ void MorganSCARASolution::cartesian_to_actuator(const float cartesian_mm[], Actu
     SCARA_psi   = atan2f(SCARA_S2, SCARA_C2);
 
 
-    actuator_mm[ALPHA_STEPPER] = to_degrees(SCARA_theta);             // Multiply by 180/Pi  -  theta is support arm angle
-    actuator_mm[BETA_STEPPER ] = to_degrees(SCARA_theta + SCARA_psi); // Morgan kinematics (dual arm)
-    //actuator_mm[BETA_STEPPER ] = to_degrees(SCARA_psi);             // real scara
+    alpha = to_degrees(SCARA_theta);             // Multiply by 180/Pi  -  theta is support arm angle
+    beta  = to_degrees(SCARA_theta + SCARA_psi); // Morgan kinematics (dual arm)
+    //beta  = to_degrees(SCARA_psi);             // real scara
+}
+
+void MorganSCARASolution::cartesian_to_actuator(const float cartesian_mm[], ActuatorCoordinates &actuator_mm ) const
+{
+    calc_angles(cartesian_mm[X_AXIS], cartesian_mm[Y_AXIS], actuator_mm[ALPHA_STEPPER], actuator_mm[BETA_STEPPER]);
     actuator_mm[GAMMA_STEPPER] = cartesian_mm[Z_AXIS];                // No inverse kinematics on Z - Position to add bed offset?
+}
 
+// same as cartesian_to_actuator() without the virtual call per point
+void MorganSCARASolution::cartesian_to_actuator_n(size_t n, const float *const cartesian[3], float *const actuator[3]) const
+{
+    for (size_t i = 0; i < n; ++i) {
+        calc_angles(cartesian[X_AXIS][i], cartesian[Y_AXIS][i], actuator[ALPHA_STEPPER][i], actuator[BETA_STEPPER][i]);
+        actuator[GAMMA_STEPPER][i] = cartesian[Z_AXIS][i];
+    }
 }
 
 void MorganSCARASolution::actuator_to_cartesian(const ActuatorCoordinates &actuator_mm, float cartesian_mm[] ) const
@@ -8,6 +8,7 @@ class MorganSCARASolution : public BaseSolution {
     public:
         MorganSCARASolution(ConfigReader&);
         void cartesian_to_actuator(const float[], ActuatorCoordinates &) const override;
+        void cartesian_to_actuator_n(size_t n, const float *const cartesian[3], float *const actuator[3]) const override;
         void actuator_to_cartesian(const ActuatorCoordinates &, float[] ) const override;
 
         bool set_optional(const arm_options_t& options) override;
@@ -16,6 +17,7 @@ class MorganSCARASolution : public BaseSolution {
     private:
         void init();
         float to_degrees(float radians) const;
+        void calc_angles(float x, float y, float &alpha, float &beta) const;
 
         float arm1_length;
         float arm2_length;
@@ -78,6 +78,24 @@ int RotaryDeltaSolution::delta_calcAngleYZ(float x0, float y0, float z0, float &
     return 0;
 }
 
+// inverse kinematics: (x0, y0, z0) -> (theta1, theta2, theta3), z0 includes the z_calc_offset
+// returned status: 0=OK, -1=non-existing position
+int RotaryDeltaSolution::delta_calcInverse(float x0, float y0, float z0, float &theta1, float &theta2, float &theta3) const
+{
+    //Code from Trossen Robotics tutorial, has X in front Y to the right and Z to the left
+    // firepick is X at the back and negates X0 X0
+    // selected by a config option
+    if(mirror_xy) {
+        x0 = -x0;
+        y0 = -y0;
+    }
+
+    int status =              delta_calcAngleYZ(x0,                    y0,                  z0, theta1);
+    if (status == 0) status = delta_calcAngleYZ(x0 * cos120 + y0 * sin120, y0 * cos120 - x0 * sin120, z0, theta2); // rotate co-ordinates to +120 deg
+    if (status == 0) status = delta_calcAngleYZ(x0 * cos120 - y0 * sin120, y0 * cos120 + x0 * sin120, z0, theta3); // rotate co-ordinates to -120 deg
+    return status;
+}
+
 // forward kinematics: (theta1, theta2, theta3) -> (x0, y0, z0)
 // returned status: 0=OK, -1=non-existing position
 int RotaryDeltaSolution::delta_calcForward(float theta1, float theta2, float theta3, float &x0, float &y0, float &z0) const
@@ -145,21 +163,9 @@ void RotaryDeltaSolution::cartesian_to_actuator(const float cartesian_mm[], Actu
     float beta_theta  = 0.0F;
     float gamma_theta = 0.0F;
 
-    //Code from Trossen Robotics tutorial, has X in front Y to the right and Z to the left
-    // firepick is X at the back and negates X0 X0
-    // selected by a config option
-    float x0 = cartesian_mm[X_AXIS];
-    float y0 = cartesian_mm[Y_AXIS];
-    if(mirror_xy) {
-        x0 = -x0;
-        y0 = -y0;
-    }
-
     float z_with_offset = cartesian_mm[Z_AXIS] + z_calc_offset; //The delta calculation below places zero at the top.  Subtract the Z offset to make zero at the bottom.
 
-    int status =              delta_calcAngleYZ(x0,                    y0,                  z_with_offset, alpha_theta);
-    if (status == 0) status = delta_calcAngleYZ(x0 * cos120 + y0 * sin120, y0 * cos120 - x0 * sin120, z_with_offset, beta_theta); // rotate co-ordinates to +120 deg
-    if (status == 0) status = delta_calcAngleYZ(x0 * cos120 - y0 * sin120, y0 * cos120 + x0 * sin120, z_with_offset, gamma_theta); // rotate co-ordinates to -120 deg
+    int status = delta_calcInverse(cartesian_mm[X_AXIS], cartesian_mm[Y_AXIS], z_with_offset, alpha_theta, beta_theta, gamma_theta);
 
     if (status == -1) { //something went wrong,
         //force to actuator FPD home position as we know this is a valid position
@@ -194,6 +200,31 @@ void RotaryDeltaSolution::cartesian_to_actuator(const float cartesian_mm[], Actu
 
 }
 
+// same as cartesian_to_actuator() without the virtual call per point
+void RotaryDeltaSolution::cartesian_to_actuator_n(size_t n, const float *const cartesian[3], float *const actuator[3]) const
+{
+    if(debug_flag) {
+        // prints each point
+        BaseSolution::cartesian_to_actuator_n(n, cartesian, actuator);
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        float alpha_theta, beta_theta, gamma_theta;
+        float z_with_offset = cartesian[Z_AXIS][i] + z_calc_offset;
+        if(delta_calcInverse(cartesian[X_AXIS][i], cartesian[Y_AXIS][i], z_with_offset, alpha_theta, beta_theta, gamma_theta) == 0) {
+            actuator[ALPHA_STEPPER][i] = alpha_theta;
+            actuator[BETA_STEPPER ][i] = beta_theta;
+            actuator[GAMMA_STEPPER][i] = gamma_theta;
+        } else {
+            //force to actuator FPD home position as we know this is a valid position
+            actuator[ALPHA_STEPPER][i] = 0;
+            actuator[BETA_STEPPER ][i] = 0;
+            actuator[GAMMA_STEPPER][i] = 0;
+        }
+    }
+}
+
 void RotaryDeltaSolution::actuator_to_cartesian(const ActuatorCoordinates &actuator_mm, float cartesian_mm[] ) const
 {
     float x, y, z;
@@ -8,6 +8,7 @@ class RotaryDeltaSolution : public BaseSolution {
     public:
         RotaryDeltaSolution(ConfigReader&);
         void cartesian_to_actuator(const float[], ActuatorCoordinates &) const override;
+        void cartesian_to_actuator_n(size_t n, const float *const cartesian[3], float *const actuator[3]) const override;
         void actuator_to_cartesian(const ActuatorCoordinates &, float[] ) const override;
 
         bool set_optional(const arm_options_t& options) override;
@@ -16,6 +17,7 @@ class RotaryDeltaSolution : public BaseSolution {
     private:
         void init();
         int delta_calcAngleYZ(float x0, float y0, float z0, float &theta) const;
+        int delta_calcInverse(float x0, float y0, float z0, float &theta1, float &theta2, float &theta3) const;
         int delta_calcForward(float theta1, float theta2, float theta3, float &x0, float &y0, float &z0) const;
 
         float delta_e;			// End effector length
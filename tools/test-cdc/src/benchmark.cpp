@@ -0,0 +1,165 @@
+#include "benchmark.h"
+#include "md5.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+void Benchmark::reset()
+{
+    std::lock_guard<std::mutex> lck(mutex);
+    waiting.clear();
+    latencies.clear();
+    errors = 0;
+    stalls = 0;
+    stall_total = stall_max = 0;
+    aborted = false;
+}
+
+bool Benchmark::data_read(std::string msg, bool error)
+{
+    auto now = clock::now();
+    if(error) {
+        std::cerr << "received error: " << msg << "\n";
+        std::lock_guard<std::mutex> lck(mutex);
+        aborted = true;
+        cond.notify_one();
+        return true;
+    }
+
+    bool is_ok = msg.compare(0, 2, "ok") == 0;
+    bool is_error = msg.compare(0, 5, "error") == 0 || msg.compare(0, 2, "!!") == 0;
+    if(!is_ok && !is_error) {
+        std::cerr << "received: " << msg << "\n";
+        return true;
+    }
+    if(is_error) {
+        std::cerr << "received: " << msg << "\n";
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(mutex);
+        if(waiting.empty()) {
+            std::cerr << "received a reply when none was expected: " << msg << "\n";
+            return true;
+        }
+
+        double gap = std::chrono::duration<double, std::milli>(now - last_reply).count();
+        if(gap > stall_ms) {
+            ++stalls;
+            stall_total += gap;
+            stall_max = std::max(stall_max, gap);
+        }
+        last_reply = now;
+
+        latencies.push_back(std::chrono::duration<double, std::milli>(now - waiting.front()).count());
+        waiting.pop_front();
+        if(is_error) ++errors;
+        // halted, nothing more will be done
+        if(msg.compare(0, 2, "!!") == 0) aborted = true;
+    }
+    cond.notify_one();
+    return true;
+}
+
+// waits until no more than max_waiting lines are waiting for a reply
+bool Benchmark::wait_for_replies(size_t max_waiting)
+{
+    std::unique_lock<std::mutex> lck(mutex);
+    return cond.wait_for(lck, std::chrono::duration<double>(timeout), [this, max_waiting]() { return waiting.size() <= max_waiting || aborted; }) && !aborted;
+}
+
+bool Benchmark::sync()
+{
+    // the workloads all start from the middle of the bed in absolute mode
+    const char *lines[] = { "G90\n", "G0 X100 Y100\n", "M400\n" };
+    reset();
+    for (auto l : lines) {
+        {
+            std::lock_guard<std::mutex> lck(mutex);
+            waiting.push_back(clock::now());
+        }
+        serial.send(l);
+    }
+    return wait_for_replies(0);
+}
+
+bool Benchmark::run(const std::string& workload, const std::vector<std::string>& lines, size_t window, BenchmarkResult& result)
+{
+    reset();
+    result = BenchmarkResult();
+    result.workload = workload;
+    result.window = window;
+
+    MD5 md5;
+    clock::time_point start;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if(!wait_for_replies(window - 1)) {
+            result.timed_out = true;
+            break;
+        }
+
+        std::string l(lines[i]);
+        l.append("\n");
+        {
+            // the time is taken before sending so the reply can not be seen first
+            std::lock_guard<std::mutex> lck(mutex);
+            waiting.push_back(clock::now());
+            if(i == 0) start = last_reply = waiting.back();
+        }
+        serial.send(l);
+        md5.update(l.c_str(), l.size());
+        ++result.lines;
+        result.bytes += l.size();
+    }
+
+    if(!result.timed_out && !wait_for_replies(0)) {
+        result.timed_out = true;
+    }
+
+    std::lock_guard<std::mutex> lck(mutex);
+    result.md5 = md5.finalize().hexdigest();
+    result.replies = latencies.size();
+    result.errors = errors;
+    result.elapsed = std::chrono::duration<double>(last_reply - start).count();
+    result.stalls = stalls;
+    result.stall_total = stall_total;
+    result.stall_max = stall_max;
+
+    if(!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        double sum = 0;
+        for (double l : latencies) sum += l;
+        result.latency_mean = sum / latencies.size();
+        // nearest rank
+        auto pct = [this](double p) { return latencies[std::max<size_t>(std::ceil(p / 100 * latencies.size()), 1) - 1]; };
+        result.latency_p50 = pct(50);
+        result.latency_p90 = pct(90);
+        result.latency_p99 = pct(99);
+        result.latency_max = latencies.back();
+    }
+
+    return !result.timed_out;
+}
+
+void BenchmarkResult::print_json(FILE *fp, const char *indent) const
+{
+    double secs = elapsed > 0 ? elapsed : 1;
+    fprintf(fp, "%s{\n", indent);
+    fprintf(fp, "%s  \"workload\": \"%s\",\n", indent, workload.c_str());
+    fprintf(fp, "%s  \"md5\": \"%s\",\n", indent, md5.c_str());
+    fprintf(fp, "%s  \"window\": %lu,\n", indent, (unsigned long)window);
+    fprintf(fp, "%s  \"lines\": %lu,\n", indent, (unsigned long)lines);
+    fprintf(fp, "%s  \"bytes\": %lu,\n", indent, (unsigned long)bytes);
+    fprintf(fp, "%s  \"replies\": %lu,\n", indent, (unsigned long)replies);
+    fprintf(fp, "%s  \"errors\": %lu,\n", indent, (unsigned long)errors);
+    fprintf(fp, "%s  \"timed_out\": %s,\n", indent, timed_out ? "true" : "false");
+    fprintf(fp, "%s  \"elapsed_s\": %1.4f,\n", indent, elapsed);
+    fprintf(fp, "%s  \"lines_per_s\": %1.1f,\n", indent, replies / secs);
+    fprintf(fp, "%s  \"bytes_per_s\": %1.1f,\n", indent, bytes / secs);
+    fprintf(fp, "%s  \"latency_ms\": { \"mean\": %1.3f, \"p50\": %1.3f, \"p90\": %1.3f, \"p99\": %1.3f, \"max\": %1.3f },\n",
+            indent, latency_mean, latency_p50, latency_p90, latency_p99, latency_max);
+    fprintf(fp, "%s  \"stalls\": { \"count\": %lu, \"total_ms\": %1.3f, \"max_ms\": %1.3f }\n",
+            indent, (unsigned long)stalls, stall_total, stall_max);
+    fprintf(fp, "%s}", indent);
+}
@@ -0,0 +1,72 @@
+// benchmark.h
+#pragma once
+
+#include "serial.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+
+struct BenchmarkResult {
+    std::string workload;
+    std::string md5; // of the lines sent, the same for the same workload on every run
+    size_t window{0};
+    size_t lines{0};
+    size_t bytes{0};
+    size_t replies{0};
+    size_t errors{0};
+    bool timed_out{false};
+    double elapsed{0}; // seconds from the first line sent to the last reply
+
+    // milliseconds from a line being sent to its ok
+    double latency_mean{0}, latency_p50{0}, latency_p90{0}, latency_p99{0}, latency_max{0};
+
+    // gaps between replies longer than the stall threshold, while lines are waiting for one
+    size_t stalls{0};
+    double stall_total{0}, stall_max{0};
+
+    void print_json(FILE *fp, const char *indent) const;
+};
+
+// Streams lines keeping up to window of them waiting for a reply. The firmware replies to every
+// line in order with a line starting ok, or error if it could not handle it, so each reply is
+// matched to the oldest line still waiting.
+class Benchmark
+{
+public:
+    Benchmark(MySerial& serial) : serial(serial) {}
+
+    void set_stall_threshold(double ms) { stall_ms = ms; }
+    void set_timeout(double secs) { timeout = secs; }
+
+    // moves to the start of the workloads and waits for it to get there so each run starts from the same state
+    bool sync();
+    bool run(const std::string& workload, const std::vector<std::string>& lines, size_t window, BenchmarkResult& result);
+
+    // the read callback for the serial port
+    bool data_read(std::string msg, bool error);
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    void reset();
+    bool wait_for_replies(size_t max_waiting);
+
+    MySerial& serial;
+    double stall_ms{100};
+    double timeout{30};
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<clock::time_point> waiting; // send time of each line without a reply yet
+    std::vector<double> latencies;
+    clock::time_point last_reply;
+    size_t errors{0};
+    size_t stalls{0};
+    double stall_total{0}, stall_max{0};
+    bool aborted{false};
+};
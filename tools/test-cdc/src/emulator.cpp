@@ -0,0 +1,224 @@
+#include "emulator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+#include <pty.h>
+
+FirmwareEmulator::FirmwareEmulator() : running(false)
+{
+}
+
+FirmwareEmulator::~FirmwareEmulator()
+{
+    close();
+}
+
+void FirmwareEmulator::set_pacing(uint32_t line_us, size_t queue_size, double motion_scale)
+{
+    this->line_us = line_us;
+    this->queue_size = std::max<size_t>(queue_size, 1);
+    this->motion_scale = motion_scale;
+}
+
+bool FirmwareEmulator::open()
+{
+    char name[128];
+    if(openpty(&master, &slave, name, nullptr, nullptr) != 0) {
+        std::cout << "Error (emulator): openpty failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    // the replies must not be echoed back to us as lines
+    struct termios t;
+    tcgetattr(slave, &t);
+    cfmakeraw(&t);
+    tcsetattr(slave, TCSANOW, &t);
+
+    // we keep the slave open so reads do not fail between clients
+    device_name = name;
+    running = true;
+    std::thread t2([this]() { this->run(); });
+    thread.swap(t2);
+    return true;
+}
+
+void FirmwareEmulator::close()
+{
+    if(thread.joinable()) {
+        running = false;
+        thread.join();
+    }
+    if(master >= 0) ::close(master);
+    if(slave >= 0) ::close(slave);
+    master = slave = -1;
+}
+
+void FirmwareEmulator::run()
+{
+    std::string line;
+    char buf[256];
+    while(running) {
+        struct pollfd pfd = { master, POLLIN, 0 };
+        if(poll(&pfd, 1, 100) <= 0) continue;
+
+        ssize_t n = read(master, buf, sizeof(buf));
+        if(n <= 0) {
+            // the client closed
+            usleep(10000);
+            continue;
+        }
+
+        for (ssize_t i = 0; i < n; ++i) {
+            char c = buf[i];
+            if(c == '\n') {
+                handle_line(line);
+                line.clear();
+            } else if(c != '\r') {
+                line.push_back(c);
+            }
+        }
+    }
+}
+
+void FirmwareEmulator::reply(const std::string& s)
+{
+    const char *p = s.c_str();
+    size_t n = s.size();
+    while(n > 0) {
+        ssize_t w = write(master, p, n);
+        if(w < 0) {
+            if(errno == EINTR || errno == EAGAIN) continue;
+            return;
+        }
+        p += w;
+        n -= w;
+    }
+}
+
+// the value of the argument after letter, false if there is none
+static bool get_arg(const std::string& line, char letter, double& v)
+{
+    for (size_t i = 0; i < line.size(); ++i) {
+        if(line[i] == letter && (i == 0 || line[i - 1] == ' ')) {
+            v = strtod(line.c_str() + i + 1, nullptr);
+            return true;
+        }
+    }
+    return false;
+}
+
+double FirmwareEmulator::move_length(int g, const std::string& line)
+{
+    double ex = x, ey = y, ez = z;
+    get_arg(line, 'X', ex);
+    get_arg(line, 'Y', ey);
+    get_arg(line, 'Z', ez);
+
+    double len;
+    if(g == 2 || g == 3) {
+        double i = 0, j = 0;
+        get_arg(line, 'I', i);
+        get_arg(line, 'J', j);
+        double cx = x + i, cy = y + j;
+        double r = hypot(i, j);
+        double a0 = atan2(y - cy, x - cx);
+        double a1 = atan2(ey - cy, ex - cx);
+        double sweep = g == 2 ? a0 - a1 : a1 - a0;
+        if(sweep <= 0) sweep += 2 * M_PI;
+        len = hypot(r * sweep, ez - z);
+    } else {
+        len = sqrt((ex - x) * (ex - x) + (ey - y) * (ey - y) + (ez - z) * (ez - z));
+    }
+
+    x = ex;
+    y = ey;
+    z = ez;
+    return len;
+}
+
+// waits until no more than n moves are queued
+void FirmwareEmulator::wait_for_room(size_t n)
+{
+    auto now = clock::now();
+    while(!moves.empty() && moves.front() <= now) moves.pop_front();
+    while(moves.size() > n) {
+        std::this_thread::sleep_until(moves.front());
+        moves.pop_front();
+    }
+}
+
+void FirmwareEmulator::handle_line(const std::string& line)
+{
+    // the time the command thread takes to parse and dispatch the line
+    std::this_thread::sleep_for(std::chrono::microseconds(line_us));
+
+    if(uploading) {
+        if(line == "M29") {
+            uploading = false;
+            reply("Done saving file.\nok\n");
+        } else {
+            reply("ok\n");
+        }
+        return;
+    }
+
+    if(line.empty() || line[0] == ';' || line[0] == '(') {
+        reply("ok\n");
+        return;
+    }
+
+    if(line[0] == 'G') {
+        int g = atoi(line.c_str() + 1);
+        if(g >= 0 && g <= 3) {
+            double f;
+            if(get_arg(line, 'F', f) && f > 0) {
+                if(g == 0) seek_rate = f;
+                else feedrate = f;
+            }
+            double len = move_length(g, line);
+            double secs = len / ((g == 0 ? seek_rate : feedrate) / 60) * motion_scale;
+
+            // the ok is held while the planner queue is full
+            wait_for_room(queue_size - 1);
+            auto now = clock::now();
+            auto start = moves.empty() ? now : std::max(now, moves.back());
+            moves.push_back(start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(secs)));
+        }
+        reply("ok\n");
+
+    } else if(line[0] == 'M') {
+        int m = atoi(line.c_str() + 1);
+        char buf[128];
+        switch(m) {
+            case 28:
+                uploading = true;
+                reply("Writing to file: " + line.substr(std::min<size_t>(line.size(), 4)) + "\nok\n");
+                break;
+            case 105:
+                reply("ok T:21.0 /0.0 @0 B:21.0 /0.0 @0\n");
+                break;
+            case 114:
+                snprintf(buf, sizeof(buf), "ok C: X:%1.4f Y:%1.4f Z:%1.4f\n", x, y, z);
+                reply(buf);
+                break;
+            case 400:
+                wait_for_room(0);
+                reply("ok\n");
+                break;
+            default:
+                reply("ok\n");
+        }
+
+    } else {
+        // console commands like raster
+        reply("ok\n");
+    }
+}
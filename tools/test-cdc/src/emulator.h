@@ -0,0 +1,54 @@
+// emulator.h
+#pragma once
+
+#include <string>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+// A stand in for the firmware on a pseudo terminal so the benchmark can be run without hardware.
+// It replies to each line as the firmware does, after the time the command thread would take to
+// handle it, and holding the reply to a move while the planner queue is full until the oldest
+// move has been executed. M400 waits for the queue to empty.
+class FirmwareEmulator
+{
+public:
+    FirmwareEmulator();
+    ~FirmwareEmulator();
+
+    // line_us is the time to handle each line, queue_size the number of moves the planner holds,
+    // motion_scale multiplies the time each move takes at its feedrate, 0 executes moves instantly
+    void set_pacing(uint32_t line_us, size_t queue_size, double motion_scale);
+
+    bool open();
+    void close();
+    const char *get_device_name() const { return device_name.c_str(); }
+
+    uint32_t get_line_us() const { return line_us; }
+    size_t get_queue_size() const { return queue_size; }
+    double get_motion_scale() const { return motion_scale; }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    void run();
+    void handle_line(const std::string& line);
+    void reply(const std::string& s);
+    double move_length(int g, const std::string& line);
+    void wait_for_room(size_t n);
+
+    std::string device_name;
+    int master{-1}, slave{-1};
+    std::thread thread;
+    std::atomic<bool> running;
+
+    uint32_t line_us{50};
+    size_t queue_size{32};
+    double motion_scale{1.0};
+
+    // when each queued move will have been executed
+    std::deque<clock::time_point> moves;
+    double x{0}, y{0}, z{0}, feedrate{6000}, seek_rate{6000};
+    bool uploading{false};
+};
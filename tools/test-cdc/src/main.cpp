@@ -10,6 +10,12 @@
 #include <algorithm>
 
 #include "md5.h"
+#include "benchmark.h"
+#include "emulator.h"
+#include "workload.h"
+
+#include <getopt.h>
+#include <sstream>
 
 std::mutex mutex_;
 std::condition_variable condVar;
@@ -88,85 +94,256 @@ bool data_read(std::string msg, bool error)
 }
 
 #define M28
-int main(int argc, char const *argv[])
+// the original test, uploads lines of known content with M28 and checks the rate
+static int upload_test(MySerial& serial)
 {
-	const char *dev;
-	if(argc >= 2) {
-		dev= argv[1];
-	}else{
-		dev= "/dev/ttyACM0";
-	}
+    serial.set_read_callback(data_read);
+    okcnt= 0;
+    serial.send("\n");
 
-	MySerial serial;
-    try {
-    	if(!serial.open(dev, 115200)){
-    		return 1;
-    	}
-    	serial.set_read_callback(data_read);
-        okcnt= 0;
-        serial.send("\n");
-
-        {
-            std::unique_lock<std::mutex> lck(mutex_);
-            condVar.wait(lck, wait_for_ok);
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        condVar.wait(lck, wait_for_ok);
+    }
+
+    okcnt= 0;
+    #ifndef M28
+    serial.send("rxtest\n");
+    #else
+    serial.send("M28 test\n");
+    #endif
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        condVar.wait(lck, wait_for_ok);
+    }
+
+    std::cout << "streaming..." << "\n";
+
+    okcnt= 0;
+    auto start = std::chrono::steady_clock::now();
+    size_t cnt= stream_data(serial, lines_sent);
+    if(cnt) {
+        printf("stream done\n");
+    }else{
+        printf("stream failed\n");
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed_seconds = end-start;
+    std::cout << "elapsed time: " << elapsed_seconds.count() << " s\n";
+    std::cout << "rate: " << cnt/elapsed_seconds.count() << " bytes/s, ";
+    std::cout << lines_sent/elapsed_seconds.count() << " lines/s\n";
+    std::cout << "lines: " << lines_sent << ", oks: " << okcnt << "\n";
+
+    #ifdef M28
+    // wait for oks to finish
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        condVar.wait(lck, wait_for_all_oks);
+    }
+    #endif
+
+    // terminate upload sequence
+    okcnt= 0;
+    #ifndef M28
+    std::string eod("\004");
+    #else
+    std::string eod("M29\n");
+    #endif
+    serial.send(eod);
+
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        condVar.wait(lck, wait_for_ok);
+    }
+
+    return 0;
+}
+
+static std::vector<std::string> split(const std::string& s)
+{
+    std::vector<std::string> v;
+    std::stringstream ss(s);
+    std::string item;
+    while(std::getline(ss, item, ',')) {
+        if(!item.empty()) v.push_back(item);
+    }
+    return v;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [options] [device]\n", name);
+    printf("Streams synthetic workloads to the device (default /dev/ttyACM0) and prints the results as JSON\n");
+    printf("The workloads move within X10-190 Y10-190 starting from X100 Y100, and raster fires the laser if there is one\n");
+    printf("  -l, --workloads list   comma separated workloads to run (default g1,arc,raster,mcode)\n");
+    printf("                         one of %s\n", workload_names());
+    printf("  -w, --windows list     comma separated numbers of lines to have waiting for an ok (default 1,4,16)\n");
+    printf("  -n, --lines n          lines in each run (default 2000)\n");
+    printf("  -s, --seed n           seed of the workloads (default 1)\n");
+    printf("  -t, --stall ms         a gap between oks longer than this is a stall (default 100)\n");
+    printf("  -T, --timeout secs     give up a run when no ok comes for this long (default 30)\n");
+    printf("  -o, --output file      write the JSON to file instead of stdout\n");
+    printf("  -u, --upload           run the M28 upload test instead\n");
+    printf("  -e, --emulate          run against a firmware emulator on a pseudo terminal instead of the device\n");
+    printf("  -E, --emulate-only     just run the emulator, for another host to connect to\n");
+    printf("      --emu-line-us us   time the emulator takes to handle each line (default 50)\n");
+    printf("      --emu-queue n      moves the emulated planner queue holds (default 32)\n");
+    printf("      --emu-motion-scale f  multiplies the emulated time of each move, 0 is instant (default 1)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *dev= "/dev/ttyACM0";
+    std::vector<std::string> workloads{"g1", "arc", "raster", "mcode"};
+    std::vector<size_t> windows{1, 4, 16};
+    size_t nlines= 2000;
+    uint32_t seed= 1;
+    double stall_ms= 100, timeout= 30;
+    const char *output= nullptr;
+    bool upload= false, emulate= false, emulate_only= false;
+    uint32_t emu_line_us= 50;
+    size_t emu_queue= 32;
+    double emu_motion_scale= 1;
+
+    static struct option long_options[] = {
+        {"workloads", required_argument, 0, 'l'},
+        {"windows", required_argument, 0, 'w'},
+        {"lines", required_argument, 0, 'n'},
+        {"seed", required_argument, 0, 's'},
+        {"stall", required_argument, 0, 't'},
+        {"timeout", required_argument, 0, 'T'},
+        {"output", required_argument, 0, 'o'},
+        {"upload", no_argument, 0, 'u'},
+        {"emulate", no_argument, 0, 'e'},
+        {"emulate-only", no_argument, 0, 'E'},
+        {"emu-line-us", required_argument, 0, 1},
+        {"emu-queue", required_argument, 0, 2},
+        {"emu-motion-scale", required_argument, 0, 3},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int c;
+    while((c = getopt_long(argc, argv, "l:w:n:s:t:T:o:ueEh", long_options, nullptr)) != -1) {
+        switch(c) {
+            case 'l': workloads= split(optarg); break;
+            case 'w':
+                windows.clear();
+                for(auto& w : split(optarg)) windows.push_back(strtoul(w.c_str(), nullptr, 10));
+                break;
+            case 'n': nlines= strtoul(optarg, nullptr, 10); break;
+            case 's': seed= strtoul(optarg, nullptr, 10); break;
+            case 't': stall_ms= strtod(optarg, nullptr); break;
+            case 'T': timeout= strtod(optarg, nullptr); break;
+            case 'o': output= optarg; break;
+            case 'u': upload= true; break;
+            case 'e': emulate= true; break;
+            case 'E': emulate_only= true; break;
+            case 1: emu_line_us= strtoul(optarg, nullptr, 10); break;
+            case 2: emu_queue= strtoul(optarg, nullptr, 10); break;
+            case 3: emu_motion_scale= strtod(optarg, nullptr); break;
+            case 'h': usage(argv[0]); return 0;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if(optind < argc) dev= argv[optind];
+
+    if(nlines == 0 || windows.empty() || workloads.empty() ||
+       std::find(windows.begin(), windows.end(), 0) != windows.end()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // make all the workloads first so a bad name fails before anything is sent
+    std::vector<std::vector<std::string>> lines(workloads.size());
+    for (size_t i = 0; i < workloads.size(); ++i) {
+        if(!make_workload(workloads[i], nlines, seed, lines[i])) {
+            std::cout << "Error: unknown workload " << workloads[i] << ", use one of " << workload_names() << "\n";
+            return 1;
+        }
+    }
+
+    FirmwareEmulator emulator;
+    if(emulate || emulate_only) {
+        emulator.set_pacing(emu_line_us, emu_queue, emu_motion_scale);
+        if(!emulator.open()) return 1;
+        dev= emulator.get_device_name();
+        if(emulate_only) {
+            std::cout << "emulating firmware on " << dev << "\n";
+            while(true) pause();
         }
+    }
 
-        okcnt= 0;
-        #ifndef M28
-        serial.send("rxtest\n");
-        #else
-        serial.send("M28 test\n");
-        #endif
-        {
-            std::unique_lock<std::mutex> lck(mutex_);
-            condVar.wait(lck, wait_for_ok);
+    FILE *fp= stdout;
+    if(output != nullptr) {
+        fp= fopen(output, "w");
+        if(fp == nullptr) {
+            std::cout << "Error: can not open " << output << "\n";
+            return 1;
         }
+    }
 
-     	std::cout << "streaming..." << "\n";
-
-        okcnt= 0;
-        auto start = std::chrono::steady_clock::now();
-        size_t cnt= stream_data(serial, lines_sent);
-        if(cnt) {
-    		printf("stream done\n");
-    	}else{
-    		printf("stream failed\n");
-    	}
-        auto end = std::chrono::steady_clock::now();
-        std::chrono::duration<double> elapsed_seconds = end-start;
-        std::cout << "elapsed time: " << elapsed_seconds.count() << " s\n";
-        std::cout << "rate: " << cnt/elapsed_seconds.count() << " bytes/s, ";
-        std::cout << lines_sent/elapsed_seconds.count() << " lines/s\n";
-        std::cout << "lines: " << lines_sent << ", oks: " << okcnt << "\n";
-
-        #ifdef M28
-        // wait for oks to finish
-        {
-            std::unique_lock<std::mutex> lck(mutex_);
-            condVar.wait(lck, wait_for_all_oks);
+    MySerial serial;
+    int ret= 0;
+    try {
+        if(!serial.open(dev, 115200)){
+            return 1;
         }
-        #endif
-
-    	// terminate upload sequence
-        okcnt= 0;
-        #ifndef M28
-        std::string eod("\004");
-        #else
-        std::string eod("M29\n");
-        #endif
-     	serial.send(eod);
-
-        {
-            std::unique_lock<std::mutex> lck(mutex_);
-            condVar.wait(lck, wait_for_ok);
+
+        if(upload) {
+            ret= upload_test(serial);
+
+        } else {
+            Benchmark bench(serial);
+            bench.set_stall_threshold(stall_ms);
+            bench.set_timeout(timeout);
+            serial.set_read_callback([&bench](std::string msg, bool error) { return bench.data_read(msg, error); });
+
+            fprintf(fp, "{\n");
+            fprintf(fp, "  \"device\": \"%s\",\n", dev);
+            if(emulate) {
+                fprintf(fp, "  \"emulator\": { \"line_us\": %u, \"queue\": %lu, \"motion_scale\": %g },\n",
+                        emulator.get_line_us(), (unsigned long)emulator.get_queue_size(), emulator.get_motion_scale());
+            }
+            fprintf(fp, "  \"seed\": %u,\n", seed);
+            fprintf(fp, "  \"stall_ms\": %g,\n", stall_ms);
+            fprintf(fp, "  \"runs\": [\n");
+
+            bool first= true;
+            for (size_t i = 0; i < workloads.size() && ret == 0; ++i) {
+                for (size_t w : windows) {
+                    if(!bench.sync()) {
+                        std::cerr << "no reply to M400, is anything connected?\n";
+                        ret= 1;
+                        break;
+                    }
+
+                    std::cerr << "streaming " << workloads[i] << " with " << w << " in flight...\n";
+                    BenchmarkResult result;
+                    if(!bench.run(workloads[i], lines[i], w, result)) {
+                        std::cerr << "timed out waiting for a reply\n";
+                        ret= 1;
+                    }
+                    if(!first) fprintf(fp, ",\n");
+                    result.print_json(fp, "    ");
+                    first= false;
+                    if(ret != 0) break;
+                }
+            }
+
+            fprintf(fp, "\n  ]\n}\n");
+            fflush(fp);
         }
 
-        std::cout << "closing serial\n";
-    	serial.close();
+        std::cerr << "closing serial\n";
+        serial.close();
 
-  	} catch(std::exception& e) {
+    } catch(std::exception& e) {
         std::cout<<"Error (main): " << e.what() << std::endl;
-        return 1;
+        ret= 1;
     }
-	return 0;
+
+    if(fp != stdout) fclose(fp);
+    emulator.close();
+    return ret;
 }
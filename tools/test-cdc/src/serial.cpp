@@ -135,6 +135,8 @@ void MySerial::do_send()
 {
 	std::lock_guard<std::mutex> l(this->queue_mutex);
  	if(this->priqueue.empty() && this->queue.empty()) return;
+	// only one write at a time, handle_write sends the next one
+	if(!this->last_sent.empty()) return;
 
 	std::string line;
 
@@ -0,0 +1,190 @@
+#include "workload.h"
+
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdarg>
+#include <algorithm>
+
+namespace {
+
+// the raw output of mt19937 is the same on every platform, the std distributions are not
+class Generator
+{
+public:
+    Generator(uint32_t seed) : rng(seed) {}
+
+    double uniform(double lo, double hi) { return lo + (hi - lo) * (rng() / 4294967296.0); }
+    uint32_t below(uint32_t n) { return rng() % n; }
+
+    // moves stay on a 200mm square bed, turning back at the edges
+    void step(double len, double& x, double& y)
+    {
+        double nx = x + len * cos(heading);
+        double ny = y + len * sin(heading);
+        if(nx < 10 || nx > 190 || ny < 10 || ny > 190) {
+            heading += M_PI;
+            nx = x + len * cos(heading);
+            ny = y + len * sin(heading);
+        }
+        x = nx;
+        y = ny;
+    }
+
+    void turn(double max) { heading += uniform(-max, max); }
+
+    std::mt19937 rng;
+    double heading{0};
+};
+
+std::string fmt(const char *f, ...) __attribute__ ((format(printf, 1, 2)));
+std::string fmt(const char *f, ...)
+{
+    char buf[160];
+    va_list args;
+    va_start(args, f);
+    vsnprintf(buf, sizeof(buf), f, args);
+    va_end(args);
+    return buf;
+}
+
+struct State {
+    double x{100}, y{100};
+};
+
+void g1_lines(Generator& g, State& s, size_t n, std::vector<std::string>& lines)
+{
+    for (size_t i = 0; i < n; ++i) {
+        g.turn(0.3);
+        double len = g.uniform(0.1, 0.5);
+        g.step(len, s.x, s.y);
+        if(i == 0) {
+            lines.push_back(fmt("G1 X%1.3f Y%1.3f E%1.5f F6000", s.x, s.y, len * 0.033));
+        } else {
+            lines.push_back(fmt("G1 X%1.3f Y%1.3f E%1.5f", s.x, s.y, len * 0.033));
+        }
+    }
+}
+
+void arc_lines(Generator& g, State& s, size_t n, std::vector<std::string>& lines)
+{
+    for (size_t i = 0; i < n; ++i) {
+        // the centre is off to one side of the current position, the end is part way round
+        double r = g.uniform(1, 5);
+        double a = g.uniform(0, 2 * M_PI);
+        double cx = s.x + r * cos(a), cy = s.y + r * sin(a);
+        if(cx < 10 + r || cx > 190 - r || cy < 10 + r || cy > 190 - r) {
+            cx = 2 * s.x - cx;
+            cy = 2 * s.y - cy;
+        }
+        bool cw = g.below(2) == 0;
+        double start = atan2(s.y - cy, s.x - cx);
+        double sweep = g.uniform(0.2, 1.5);
+        double end = cw ? start - sweep : start + sweep;
+        double ex = cx + r * cos(end), ey = cy + r * sin(end);
+        lines.push_back(fmt("G%d X%1.3f Y%1.3f I%1.3f J%1.3f F3000", cw ? 2 : 3, ex, ey, cx - s.x, cy - s.y));
+        s.x = ex;
+        s.y = ey;
+    }
+}
+
+void raster_lines(Generator& g, State& s, size_t n, std::vector<std::string>& lines)
+{
+    // 48 pixels at 0.1mm keeps the raster line under the 132 character line limit
+    const int npixels = 48;
+    const double pixel = 0.1;
+    double x0 = s.x;
+    bool forward = true;
+    for (size_t i = 0; i < n; i += 3) {
+        std::string l("raster ");
+        uint32_t v = g.below(256);
+        for (int p = 0; p < npixels; ++p) {
+            // runs of similar shades as an image has
+            if(g.below(8) == 0) v = g.below(256);
+            l.append(fmt("%02x", (unsigned)v));
+        }
+        lines.push_back(l);
+        double x = forward ? x0 + npixels * pixel : x0;
+        lines.push_back(fmt("G1 X%1.3f S1 F6000", x));
+        s.x = x;
+        if(i + 2 < n) {
+            s.y += pixel;
+            if(s.y > 190) s.y = 10;
+            lines.push_back(fmt("G0 Y%1.3f", s.y));
+        }
+        forward = !forward;
+    }
+    if(lines.size() > n) lines.resize(n);
+    // do not leave pixels for a G1 that never comes
+    if(!lines.empty() && lines.back().compare(0, 7, "raster ") == 0) {
+        lines.back() = fmt("G0 Y%1.3f", s.y);
+    }
+}
+
+void mcode_lines(Generator& g, State& s, size_t n, std::vector<std::string>& lines)
+{
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t r = g.below(100);
+        if(r < 60) {
+            g.turn(0.5);
+            g.step(g.uniform(0.5, 2), s.x, s.y);
+            lines.push_back(fmt("G1 X%1.3f Y%1.3f F6000", s.x, s.y));
+        } else if(r < 70) {
+            lines.push_back("M105");
+        } else if(r < 75) {
+            lines.push_back("M114");
+        } else if(r < 85) {
+            lines.push_back(fmt("M106 S%u", (unsigned)g.below(256)));
+        } else if(r < 88) {
+            lines.push_back("M107");
+        } else if(r < 93) {
+            lines.push_back(fmt("M204 S%u", (unsigned)(500 + 100 * g.below(20))));
+        } else if(r < 98) {
+            lines.push_back(fmt("M220 S%u", (unsigned)(80 + g.below(40))));
+        } else {
+            // waits for the queue to empty, these are the stalls a host sees
+            lines.push_back("M400");
+        }
+    }
+}
+
+}
+
+bool make_workload(const std::string& name, size_t nlines, uint32_t seed, std::vector<std::string>& lines)
+{
+    Generator g(seed);
+    State s;
+    lines.clear();
+    lines.reserve(nlines);
+
+    if(name == "g1") {
+        g1_lines(g, s, nlines, lines);
+    } else if(name == "arc") {
+        arc_lines(g, s, nlines, lines);
+    } else if(name == "raster") {
+        raster_lines(g, s, nlines, lines);
+    } else if(name == "mcode") {
+        mcode_lines(g, s, nlines, lines);
+    } else if(name == "mixed") {
+        while(lines.size() < nlines) {
+            size_t n = std::min<size_t>(nlines - lines.size(), 20 + g.below(80));
+            std::vector<std::string> run;
+            switch(g.below(4)) {
+                case 0: g1_lines(g, s, n, run); break;
+                case 1: arc_lines(g, s, n, run); break;
+                case 2: raster_lines(g, s, n, run); break;
+                case 3: mcode_lines(g, s, n, run); break;
+            }
+            lines.insert(lines.end(), run.begin(), run.end());
+        }
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+const char *workload_names()
+{
+    return "g1, arc, raster, mcode, mixed";
+}
@@ -0,0 +1,15 @@
+// workload.h
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// synthetic gcode streams for benchmarking, the same name, count and seed always give the same lines
+//  g1     - short G1 segments with extrusion as sliced models produce
+//  arc    - small G2/G3 arcs
+//  raster - laser raster rows, a raster line of pixels then the G1 that burns them
+//  mcode  - G1 moves mixed with fan, temperature, position, acceleration and M400 commands
+//  mixed  - runs of all of the above
+bool make_workload(const std::string& name, size_t nlines, uint32_t seed, std::vector<std::string>& lines);
+const char *workload_names();
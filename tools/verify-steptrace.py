@@ -0,0 +1,339 @@
+#!/usr/bin/env python3
+"""
+Verifies a step trace recorded by the stepticker (firmware built with rake steptrace=1,
+steptrace start/stop commands, or HostSim hostsim -r file).
+
+For every block the planned trapezoid (accelerate_until, decelerate_after, plateau_rate,
+acceleration) is turned into an ideal per tick position for each motor, and the position
+each recorded step was issued at is compared to it. It also rebuilds the per axis
+velocity from the step intervals, and the acceleration from the step positions of each
+phase long enough to measure it, and compares them with the plan.
+
+Reports missed or extra steps, steps issued off the planned position by more than the
+tolerance (jitter), and
+velocity or acceleration that does not match the plan.
+
+Usage: verify-steptrace.py [-t steps] [-v] steptrace.bin
+"""
+
+import argparse
+import math
+import struct
+import sys
+
+RECORD = struct.Struct('<IBBHIII')
+
+
+def as_float(u):
+    return struct.unpack('<f', struct.pack('<I', u))[0]
+
+
+class Motor:
+    def __init__(self, index, steps_to_move, initial_rate, plateau_rate):
+        self.index = index
+        self.steps_to_move = steps_to_move
+        self.initial_rate = initial_rate
+        self.plateau_rate = plateau_rate
+        self.acceleration = 0.0
+        self.deceleration = 0.0
+        self.accel_jerk = 0.0
+        self.steps = []  # ticks relative to start of block
+
+
+class Block:
+    def __init__(self, n, tick, bits, accelerate_until, decelerate_after, total_move_ticks):
+        self.n = n
+        self.tick = tick
+        self.dirs = bits
+        self.accelerate_until = accelerate_until
+        self.decelerate_after = decelerate_after
+        self.total_move_ticks = total_move_ticks
+        self.motors = {}
+        self.complete = True
+        self.accelerate_ramp = 0
+        self.decelerate_ramp = 0
+
+    @property
+    def s_curve(self):
+        return self.accelerate_ramp > 0 or self.decelerate_ramp > 0
+
+    def s_curve_velocities(self, m):
+        """per tick velocity of a jerk limited block, the acceleration ramps up for accelerate_ramp
+        ticks, is constant, then ramps down for accelerate_ramp ticks, likewise for deceleration"""
+        au = self.accelerate_until
+        da = self.decelerate_after
+        total = self.total_move_ticks
+        ra = self.accelerate_ramp
+        rd = self.decelerate_ramp
+        sd = 0 if au == 0 and da == 0 else da + 1
+        td = total - da
+        dj = -m.deceleration * td / (rd * (td - rd)) if rd > 0 else 0.0
+        events = {}
+        if ra > 0:
+            events.update({0: m.accel_jerk, ra: 0.0})
+            events.update({au - ra: -m.accel_jerk, au: 0.0})
+        if rd > 0:
+            events.update({sd: -dj, sd + rd: 0.0})
+            events.update({sd + td - rd: dj, sd + td: None})
+
+        acc = m.acceleration
+        if au == 0 and da == 0 and rd == 0:
+            acc = m.deceleration
+        v = m.initial_rate
+        jerk = 0.0
+        k = 0
+        while True:
+            if k in events:
+                jerk = events[k]
+                if jerk is None:
+                    # after the deceleration ramp it carries on at the deceleration rate
+                    jerk = 0.0
+                    acc = m.deceleration
+            acc += jerk
+            v += acc
+            if au != 0 and k == au:
+                acc = 0.0
+                if da < total and au != da:
+                    v = m.plateau_rate
+            if k == da and rd == 0 and (au != 0 or da != 0) and da < total:
+                acc = m.deceleration
+            yield v
+            k += 1
+
+    def velocity(self, m, k):
+        """ideal velocity in steps/tick during tick k, mirrors the trapezoid the planner set up"""
+        au = self.accelerate_until
+        da = self.decelerate_after
+        if k < au:
+            return m.initial_rate + m.acceleration * (k + 1)
+        if au == 0 and da == 0:
+            # starts off decelerating
+            return m.initial_rate + m.deceleration * (k + 1)
+        if k < da:
+            return m.plateau_rate if au != da else m.initial_rate + m.acceleration * au
+        vd = m.plateau_rate if au != da else m.initial_rate + m.acceleration * au
+        if da == au == 0:
+            vd = m.initial_rate
+        return vd + m.deceleration * (k - da + 1)
+
+    def ideal_positions(self, m):
+        """the ideal position of the motor in steps at the end of each tick of the block"""
+        xs = []
+        x = 0.0
+        k = 0
+        vs = self.s_curve_velocities(m) if self.s_curve else None
+        # the last step can be a tick or two after the end of the block due to rounding
+        while k <= self.total_move_ticks + 2 or (x < m.steps_to_move and k <= self.total_move_ticks + m.steps_to_move):
+            v = next(vs) if vs else self.velocity(m, k)
+            if v > 0:
+                x += v
+            else:
+                # the stepticker forces the remaining steps out one per tick if rounding leaves it short
+                x = min(math.floor(x) + 1, m.steps_to_move)
+            xs.append(x)
+            k += 1
+        return xs
+
+
+def read_trace(fn):
+    blocks = []
+    lost = 0
+    extra = 0
+    current = None
+    with open(fn, 'rb') as f:
+        data = f.read()
+
+    for off in range(0, len(data) - RECORD.size + 1, RECORD.size):
+        tick, rtype, motor, bits, a, b, c = RECORD.unpack_from(data, off)
+        rtype = chr(rtype)
+        if rtype == 'B':
+            current = Block(len(blocks) + 1, tick, bits, a, b, c)
+            blocks.append(current)
+        elif rtype == 'M' and current is not None:
+            current.motors[motor] = Motor(motor, a, as_float(b), as_float(c))
+        elif rtype == 'A' and current is not None and motor in current.motors:
+            current.motors[motor].acceleration = as_float(a)
+            current.motors[motor].deceleration = as_float(b)
+            current.motors[motor].accel_jerk = as_float(c)
+        elif rtype == 'J' and current is not None:
+            current.accelerate_ramp = a
+            current.decelerate_ramp = b
+        elif rtype == 'S':
+            if current is None:
+                extra += 1
+                continue
+            for m, mot in current.motors.items():
+                if bits & (1 << m):
+                    mot.steps.append(tick - current.tick)
+            if bits & ~sum(1 << m for m in current.motors):
+                print("ERROR: block %d: step on an inactive motor at tick %d" % (current.n, tick))
+                extra += 1
+        elif rtype == 'O':
+            lost += a
+            if current is not None:
+                current.complete = False
+        else:
+            print("ERROR: bad record type %r at offset %d" % (rtype, off))
+            return None, lost, extra
+
+    return blocks, lost, extra
+
+
+def det3(m):
+    return (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+            m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+            m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]))
+
+
+def fit_acceleration(points):
+    """least squares fit of position = c0 + c1*t + c2*t^2 to (tick, position), returns the acceleration 2*c2"""
+    n = len(points)
+    if n < 3:
+        return None
+    mt = sum(p[0] for p in points) / n
+    s = [0.0] * 5
+    r = [0.0] * 3
+    for t, y in points:
+        t -= mt
+        tp = 1.0
+        for k in range(5):
+            if k < 3:
+                r[k] += y * tp
+            s[k] += tp
+            tp *= t
+    a = [[s[0], s[1], s[2]], [s[1], s[2], s[3]], [s[2], s[3], s[4]]]
+    d = det3(a)
+    if d == 0:
+        return None
+    return 2 * det3([[a[i][0], a[i][1], r[i]] for i in range(3)]) / d
+
+
+def phases(blk, m):
+    """the (first tick, last tick, acceleration) of the accelerating and decelerating runs of the ideal
+    velocity, so the phases are the ones the stepticker actually runs, not just what the events say"""
+    vs = [blk.velocity(m, k) for k in range(blk.total_move_ticks + 1)]
+    runs = {}
+    for k in range(1, len(vs)):
+        dv = vs[k] - vs[k - 1]
+        sign = 1 if dv > 0 else -1 if dv < 0 else 0
+        if sign == 0:
+            continue
+        if sign not in runs:
+            runs[sign] = [k, k]
+        elif runs[sign][1] == k - 1:
+            runs[sign][1] = k
+    result = {}
+    for sign, (first, last) in runs.items():
+        result[sign] = (first, last, (vs[last] - vs[first - 1]) / (last - first + 1), max(vs[first - 1], vs[last]))
+    return result
+
+
+def verify_motor(blk, m, args):
+    errors = []
+    steps = m.steps
+    if len(steps) != m.steps_to_move:
+        errors.append("motor %d: %s steps, expected %d got %d" % (m.index, "missed" if len(steps) < m.steps_to_move else "extra", m.steps_to_move, len(steps)))
+
+    # the step should happen on the tick the ideal position crosses the step, so checking the
+    # position error rather than the tick error keeps the sparse steps at the ends of a ramp
+    # from looking like jitter
+    ideal = blk.ideal_positions(m)
+    worst = 0.0
+    for i, t in enumerate(steps):
+        if t >= len(ideal):
+            errors.append("motor %d: step %d at tick %d is after the end of the block" % (m.index, i + 1, t))
+            break
+        e = ideal[t] - (i + 1)
+        if abs(e) > abs(worst):
+            worst = e
+        if abs(e) > args.tolerance and len(errors) < 10:
+            errors.append("motor %d: step %d at tick %d is %1.3f steps off the planned position" % (m.index, i + 1, t, e))
+
+    # rebuild velocity (steps/tick) from the intervals
+    vel = []
+    for i in range(1, len(steps)):
+        dt = steps[i] - steps[i - 1]
+        if dt > 0:
+            vel.append(((steps[i] + steps[i - 1]) / 2.0, 1.0 / dt))
+
+    au = blk.accelerate_until
+    da = blk.decelerate_after
+    plateau = [v for t, v in vel if au + 2 < t < da - 2]
+    if len(plateau) >= args.min_samples:
+        mean = sum(plateau) / len(plateau)
+        if abs(mean - m.plateau_rate) > m.plateau_rate * args.rate_error:
+            errors.append("motor %d: plateau rate %g steps/tick, planned %g" % (m.index, mean, m.plateau_rate))
+
+    # the acceleration is fitted to the step positions of each phase. Each step is issued on a whole tick
+    # so it can be up to half a step (at the phase's top speed v, v/2) from where a smooth move would
+    # put it, the fit is only meaningful when the acceleration bends the positions by many times that
+    # over the phase (a*T^2/8 from the straight line), shorter or gentler phases are left to the
+    # position check above. The fits only apply to constant acceleration, s-curve blocks are only
+    # checked by the position error
+    fits = {}
+    if not blk.s_curve:
+        for sign, (first, last, planned, vmax) in phases(blk, m).items():
+            pts = [(t, i + 1) for i, t in enumerate(steps) if first <= t <= last]
+            if len(pts) < args.min_samples:
+                continue
+            span = pts[-1][0] - pts[0][0]
+            if abs(planned) * span * span / 8 < args.min_curvature * vmax / 2:
+                continue
+            f = fit_acceleration(pts)
+            if f is None:
+                continue
+            fits[sign] = f
+            if abs(f - planned) > abs(planned) * args.accel_error:
+                errors.append("motor %d: %s %g steps/tick², planned %g" % (m.index, "acceleration" if sign > 0 else "deceleration", f, planned))
+    a = fits.get(1)
+    d = fits.get(-1)
+
+    if args.verbose:
+        print("  motor %d: %d steps, worst position error %1.3f steps, accel %s/%g, decel %s/%g" %
+              (m.index, len(steps), worst, "%g" % a if a is not None else "-", m.acceleration, "%g" % d if d is not None else "-", m.deceleration))
+
+    return errors, worst
+
+
+def main():
+    parser = argparse.ArgumentParser(description="verify a stepticker step trace against the planned trapezoids")
+    parser.add_argument('file', help="the recorded step trace")
+    parser.add_argument('-t', '--tolerance', type=float, default=0.5, help="allowed position error in steps when a step is issued (default 0.5)")
+    parser.add_argument('--rate-error', type=float, default=0.02, help="allowed relative plateau rate error (default 0.02)")
+    parser.add_argument('--accel-error', type=float, default=0.10, help="allowed relative acceleration error (default 0.10)")
+    parser.add_argument('--min-samples', type=int, default=8, help="minimum intervals needed to check a rate (default 8)")
+    parser.add_argument('--min-curvature', type=float, default=20, help="minimum bend of the positions by the acceleration, in multiples of the tick rounding, to check it (default 20)")
+    parser.add_argument('-v', '--verbose', action='store_true', help="print details for every block")
+    args = parser.parse_args()
+
+    blocks, lost, extra = read_trace(args.file)
+    if blocks is None:
+        return 2
+
+    nerrors = 0
+    skipped = 0
+    worst = 0.0
+    for blk in blocks:
+        if not blk.complete:
+            skipped += 1
+            continue
+        if args.verbose:
+            print("block %d: tick %d, accelerate_until %d, decelerate_after %d, total %d%s" %
+                  (blk.n, blk.tick, blk.accelerate_until, blk.decelerate_after, blk.total_move_ticks,
+                   ", s-curve ramps %d/%d" % (blk.accelerate_ramp, blk.decelerate_ramp) if blk.s_curve else ""))
+        for m in blk.motors.values():
+            errors, w = verify_motor(blk, m, args)
+            if abs(w) > abs(worst):
+                worst = w
+            for e in errors:
+                print("ERROR: block %d (tick %d): %s" % (blk.n, blk.tick, e))
+            nerrors += len(errors)
+
+    print("%d blocks, %d skipped due to %d lost records, %d stray steps, worst position error %1.3f steps, %d errors" %
+          (len(blocks), skipped, lost, extra, worst, nerrors))
+
+    return 1 if nerrors > 0 or extra > 0 else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())